@@ -21,6 +21,7 @@ public:
 
     data::TodoRepository &todoRepository();
     data::EventRepository &eventRepository();
+    data::DataProvider &dataProvider();
     UndoStack &undoStack();
 
 private:
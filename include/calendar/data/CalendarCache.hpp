@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+#include <optional>
+
+#include "calendar/data/CalendarSnapshot.hpp"
+
+namespace calendar {
+namespace data {
+
+// Binary sidecar ("<file>.bmcache") with the parsed index of an ICS file: all todos and the
+// location of every event. It records the size, modification time and hash of the ICS file it
+// was written for and is ignored as soon as the ICS file changes.
+class CalendarCache
+{
+public:
+    static QString cachePathFor(const QString &icsPath);
+    // Reads icsPath into contents. The state describes exactly these bytes; it is invalid if
+    // the file could not be read or changed while it was read.
+    static IcsSourceState readSource(const QString &icsPath, QByteArray *contents);
+    // State of icsPath right after contents were written to it; invalid if it holds others.
+    static IcsSourceState writtenSource(const QString &icsPath, const QByteArray &contents);
+
+    // Returns todos and eventRefs if the cache matches the current contents of icsPath.
+    static std::optional<CalendarSnapshot> read(const QString &icsPath);
+    // Same for contents, read from icsPath in the given state, so the returned offsets are
+    // valid for exactly these bytes.
+    static std::optional<CalendarSnapshot> read(const QString &icsPath,
+                                                const QByteArray &contents,
+                                                const IcsSourceState &state);
+    // Writes todos and eventRefs of the snapshot, stamped with its sourceState; fails if that
+    // state is invalid. Without a hash in the state, snapshot.source must hold the bytes.
+    static bool write(const QString &icsPath,
+                      const CalendarSnapshot &snapshot,
+                      QString *errorString = nullptr);
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QUuid>
+#include <vector>
+
+#include "calendar/data/ChangeSet.hpp"
+#include "calendar/data/EventQuery.hpp"
+#include "calendar/data/SearchIndex.hpp"
+
+namespace calendar {
+namespace data {
+
+class EventRepository;
+class ObservableEventRepository;
+class ObservableTodoRepository;
+class TodoRepository;
+
+// Events matched by a search. Occurrences of a series are not stored anywhere, so they match
+// through their master unless they were overridden with a text of their own. While the index
+// is still being built only the query is known, and contains() compares the texts instead.
+struct EventMatches {
+    QSet<QUuid> ids;
+    QSet<QUuid> unmatchedOverrides;
+    // Set until the index is ready.
+    QString pendingQuery;
+
+    bool contains(const CalendarEvent &event) const;
+};
+
+// Todos matched by a search, like EventMatches.
+struct TodoMatches {
+    QSet<QUuid> ids;
+    QString pendingQuery;
+
+    bool contains(const TodoItem &todo) const;
+};
+
+// Full-text search over every stored event and todo, answered from trigram indexes instead of
+// comparing each row or painted event with the query. Events match in their title, description
+// or location, todos in their title or description, ignoring case. The first search starts
+// building the indexes on a worker thread, from fetchAllEventsAsync() and fetchTodosAsync() of
+// the storages, which read what they do not hold in memory off the calling thread as well;
+// indexReady() is emitted once they can be used. From then on they are kept up to date from
+// the change sets of the observable repositories.
+class CalendarSearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    // storedEvents is the repository below the recurrence expansion, so series are indexed
+    // once instead of once per occurrence.
+    CalendarSearch(EventRepository &storedEvents,
+                   TodoRepository &storedTodos,
+                   ObservableEventRepository &events,
+                   ObservableTodoRepository &todos,
+                   QObject *parent = nullptr);
+    ~CalendarSearch() override;
+
+    EventMatches matchingEvents(const QString &query);
+    TodoMatches matchingTodos(const QString &query);
+
+    bool isIndexed() const;
+
+signals:
+    void indexReady();
+
+private:
+    struct Index {
+        SearchIndex events;
+        SearchIndex todos;
+        // Overrides by the id of their series.
+        QHash<QUuid, QSet<QUuid>> overrides;
+    };
+    enum class State {
+        NotIndexed,
+        Building,
+        Ready
+    };
+
+    void ensureIndexed();
+    void install(Index index);
+    static void indexEvent(Index &index, const CalendarEvent &event);
+    static void unindexEvent(Index &index, const CalendarEvent &event);
+    void applyEventChanges(const EventChangeSet &changes);
+    void applyTodoChanges(const TodoChangeSet &changes);
+
+    EventRepository &m_storedEvents;
+    TodoRepository &m_storedTodos;
+    Index m_index;
+    State m_state = State::NotIndexed;
+    CancellationToken m_buildToken;
+    // Changes reported while the index was built from the contents before them.
+    std::vector<EventChangeSet> m_pendingEventChanges;
+    std::vector<TodoChangeSet> m_pendingTodoChanges;
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QUuid>
+
+#include "calendar/data/EventSnapshot.hpp"
+#include "calendar/data/IcsEventRef.hpp"
+#include "calendar/data/Todo.hpp"
+
+namespace calendar {
+namespace data {
+
+// The ICS file that eventRefs point into, as it was when its bytes were read or written. A
+// cache may only be written with a valid state, since it is trusted while the file matches it.
+struct IcsSourceState {
+    qint64 size = -1;
+    qint64 modified = 0;
+    // SHA-1 of the bytes; empty until someone needed it.
+    QByteArray hash;
+
+    bool isValid() const { return size >= 0; }
+};
+
+// Immutable copy of the calendar contents handed to the writer thread. The Qt containers
+// are implicitly shared and events are shared handles, so taking a snapshot does not copy the
+// items.
+struct CalendarSnapshot {
+    QHash<QUuid, EventHandle> events;
+    QHash<QUuid, TodoItem> todos;
+    // Events that are still in their original ICS form, as ranges of source. An entry in
+    // events with the same id takes precedence.
+    QHash<QUuid, IcsEventRef> eventRefs;
+    QByteArray source;
+    IcsSourceState sourceState;
+    // Written as IcsParser::RevisionProperty if set.
+    qint64 revision = 0;
+};
+
+} // namespace data
+} // namespace calendar
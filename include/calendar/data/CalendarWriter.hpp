@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QUuid>
+#include <optional>
+#include <vector>
+
+#include "calendar/data/CalendarSnapshot.hpp"
+
+class QTimer;
+
+namespace calendar {
+namespace data {
+
+// Performs the file I/O of FileCalendarStorage on its own thread. Journal records and
+// snapshots may be queued from any thread; bursts arriving within the coalescing interval
+// are written together.
+class CalendarWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    CalendarWriter(QString filePath,
+                   QString journalPath,
+                   int coalescingInterval,
+                   QObject *parent = nullptr);
+    ~CalendarWriter() override;
+
+    void setCoalescingInterval(int msecs);
+
+    void appendJournal(const QByteArray &records);
+    void writeSnapshot(CalendarSnapshot snapshot);
+    // Stores the todos and event index of the unchanged ICS file in the binary cache.
+    // Superseded by any snapshot written later, which refreshes the cache itself.
+    void writeCache(CalendarSnapshot snapshot);
+    // Rewrites each file with its snapshot, or removes it if the snapshot is empty. A file
+    // queued again before it was written is only written once, with the latest snapshot.
+    // followUps are only written after all of shards, so an event moving to another file can
+    // stay in its old one until the new one has it. The index file is written last.
+    void writeShards(QHash<QString, CalendarSnapshot> shards,
+                     QHash<QString, CalendarSnapshot> followUps = {},
+                     const QString &indexPath = {},
+                     const QByteArray &index = {});
+
+    // Blocks until everything queued so far has been written.
+    void flush();
+    bool isBusy() const;
+
+signals:
+    void busyChanged(bool busy);
+    void writeFailed(const QString &errorString);
+
+private:
+    void schedule();
+    void writePending();
+    bool appendToJournalFile(const QByteArray &records, QString *errorString) const;
+    void markBusy();
+
+    const QString m_filePath;
+    const QString m_journalPath;
+    QTimer *m_timer = nullptr;
+
+    mutable QMutex m_mutex;
+    std::optional<CalendarSnapshot> m_pendingSnapshot;
+    std::optional<CalendarSnapshot> m_pendingCache;
+    // Written one after the other; each one waits for all files of the previous one.
+    std::vector<QHash<QString, CalendarSnapshot>> m_pendingShards;
+    QString m_pendingIndexPath;
+    QByteArray m_pendingIndex;
+    QByteArray m_journalBeforeSnapshot;
+    QByteArray m_pendingJournal;
+    bool m_busy = false;
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QHash>
+#include <QUuid>
+#include <optional>
+#include <vector>
+
+#include "calendar/data/Event.hpp"
+#include "calendar/data/Todo.hpp"
+
+namespace calendar {
+namespace data {
+
+// Net effect of a group of repository mutations. Every id appears at most once.
+template <typename T>
+struct ChangeSet
+{
+    struct Update {
+        T before;
+        T after;
+    };
+
+    // Inserted items may replace an item with the same id that was unknown to the observer.
+    std::vector<T> inserted;
+    std::vector<Update> updated;
+    std::vector<T> removed;
+
+    bool isEmpty() const { return inserted.empty() && updated.empty() && removed.empty(); }
+};
+
+using EventChangeSet = ChangeSet<CalendarEvent>;
+using TodoChangeSet = ChangeSet<TodoItem>;
+
+// Folds mutations into a ChangeSet, e.g. an insert followed by a removal cancels out.
+template <typename T>
+class ChangeRecorder
+{
+public:
+    void recordInserted(const T &item)
+    {
+        if (Entry *entry = find(item.id)) {
+            entry->after = item;
+            return;
+        }
+        m_entries.push_back({std::nullopt, item});
+        m_positions.insert(item.id, static_cast<int>(m_entries.size()) - 1);
+    }
+
+    void recordUpdated(const T &before, const T &after)
+    {
+        if (Entry *entry = find(after.id)) {
+            entry->after = after;
+            return;
+        }
+        m_entries.push_back({before, after});
+        m_positions.insert(after.id, static_cast<int>(m_entries.size()) - 1);
+    }
+
+    void recordRemoved(const T &item)
+    {
+        if (Entry *entry = find(item.id)) {
+            entry->after.reset();
+            return;
+        }
+        m_entries.push_back({item, std::nullopt});
+        m_positions.insert(item.id, static_cast<int>(m_entries.size()) - 1);
+    }
+
+    bool isEmpty() const { return m_entries.empty(); }
+
+    ChangeSet<T> take()
+    {
+        ChangeSet<T> changes;
+        for (Entry &entry : m_entries) {
+            if (entry.before && entry.after) {
+                changes.updated.push_back({std::move(*entry.before), std::move(*entry.after)});
+            } else if (entry.after) {
+                changes.inserted.push_back(std::move(*entry.after));
+            } else if (entry.before) {
+                changes.removed.push_back(std::move(*entry.before));
+            }
+        }
+        m_entries.clear();
+        m_positions.clear();
+        return changes;
+    }
+
+private:
+    struct Entry {
+        std::optional<T> before;
+        std::optional<T> after;
+    };
+
+    Entry *find(const QUuid &id)
+    {
+        const auto it = m_positions.constFind(id);
+        return it == m_positions.constEnd() ? nullptr : &m_entries[static_cast<size_t>(it.value())];
+    }
+
+    std::vector<Entry> m_entries;
+    QHash<QUuid, int> m_positions;
+};
+
+} // namespace data
+} // namespace calendar
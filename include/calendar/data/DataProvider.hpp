@@ -3,12 +3,19 @@
 #include <memory>
 #include <QString>
 
+class QDir;
+
 namespace calendar {
 namespace data {
 
+class CalendarSearch;
 class TodoRepository;
 class EventRepository;
 class FileCalendarStorage;
+class ObservableEventRepository;
+class ObservableTodoRepository;
+class RecurringEventRepository;
+class SqliteDatabase;
 
 class DataProvider
 {
@@ -16,13 +23,24 @@ public:
     DataProvider();
     ~DataProvider();
 
-    TodoRepository &todoRepository();
-    EventRepository &eventRepository();
+    ObservableTodoRepository &todoRepository();
+    ObservableEventRepository &eventRepository();
+    // Null when the SQLite backend is active.
+    FileCalendarStorage *calendarStorage();
+    CalendarSearch &search();
 
 private:
+    void openBackend(const QDir &dir);
+    bool openSqliteBackend(const QString &databasePath, const QString &icsPath);
+
     std::shared_ptr<FileCalendarStorage> m_calendarStorage;
+    std::shared_ptr<SqliteDatabase> m_database;
     std::unique_ptr<TodoRepository> m_todoRepository;
     std::unique_ptr<EventRepository> m_eventRepository;
+    std::unique_ptr<ObservableTodoRepository> m_observableTodos;
+    std::unique_ptr<RecurringEventRepository> m_recurringEvents;
+    std::unique_ptr<ObservableEventRepository> m_observableEvents;
+    std::unique_ptr<CalendarSearch> m_search;
 };
 
 } // namespace data
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <QDateTime>
+#include <QList>
 #include <QString>
 #include <QStringList>
 #include <QUuid>
@@ -18,8 +19,14 @@ struct CalendarEvent
     bool allDay = false;
     QString location;
     QStringList categories;
-    QString recurrenceRule; // RFC5545 RRULE string placeholder
+    QString recurrenceRule; // RFC5545 RRULE without the "RRULE:" prefix
     int reminderMinutes = 0;
+    // Starts of occurrences excluded from the series (EXDATE).
+    QList<QDateTime> exceptionDates;
+    // Occurrences of a series and overrides of single occurrences (RECURRENCE-ID) carry the id
+    // of the series master and the original start of the occurrence they stand for.
+    QUuid seriesId;
+    QDateTime recurrenceId;
 };
 
 } // namespace data
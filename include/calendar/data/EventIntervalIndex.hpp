@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QHash>
+#include <QUuid>
+#include <QtGlobal>
+#include <vector>
+
+namespace calendar {
+namespace data {
+
+// Balanced search tree (treap) over event intervals ordered by (start, end, id). Every node
+// also stores the largest end of its subtree, so overlap queries only descend into subtrees
+// that can contain matches. Times are milliseconds since the epoch.
+class EventIntervalIndex
+{
+public:
+    void insert(const QUuid &id, qint64 start, qint64 end);
+    bool remove(const QUuid &id);
+    void clear();
+    int size() const;
+
+    // Ids of all intervals with start <= to and end >= from, ordered by (start, end).
+    std::vector<QUuid> overlapping(qint64 from, qint64 to) const;
+
+private:
+    struct Node {
+        qint64 start = 0;
+        qint64 end = 0;
+        qint64 maxEnd = 0;
+        QUuid id;
+        quint32 priority = 0;
+        int left = -1;
+        int right = -1;
+    };
+
+    bool lessThan(const Node &node, qint64 start, qint64 end, const QUuid &id) const;
+    void update(int node);
+    void split(int node, const Node &key, bool keyGoesLeft, int &left, int &right);
+    int merge(int left, int right);
+    void collect(int node, qint64 from, qint64 to, std::vector<QUuid> &result) const;
+    quint32 nextPriority();
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+    QHash<QUuid, int> m_nodeById;
+    int m_root = -1;
+    quint32 m_seed = 0x9e3779b9u;
+};
+
+} // namespace data
+} // namespace calendar
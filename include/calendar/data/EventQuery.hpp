@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QFuture>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "calendar/data/EventSnapshot.hpp"
+
+namespace calendar {
+namespace data {
+
+// Tells a running query that its result is no longer wanted. Copies share the same flag, so
+// the caller keeps one copy and hands another to the query.
+class CancellationToken
+{
+public:
+    CancellationToken();
+
+    void cancel();
+    bool isCancelled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+// A future that has finished with snapshot, for queries that are answered right away.
+QFuture<EventSnapshot> finishedEventQuery(EventSnapshot snapshot);
+// A future for next applied to the result of query. A watcher on the calling thread starts next
+// on the global thread pool once query has finished, so no thread waits for query; the calling
+// thread needs a running event loop.
+QFuture<EventSnapshot> continueEventQuery(const QFuture<EventSnapshot> &query,
+                                         std::function<EventSnapshot(const EventSnapshot &)> next);
+
+} // namespace data
+} // namespace calendar
@@ -4,6 +4,8 @@
 #include <vector>
 
 #include "calendar/data/Event.hpp"
+#include "calendar/data/EventQuery.hpp"
+#include "calendar/data/EventSnapshot.hpp"
 
 namespace calendar {
 namespace data {
@@ -14,10 +16,39 @@ public:
     virtual ~EventRepository() = default;
 
     virtual std::vector<CalendarEvent> fetchEvents(const QDate &from, const QDate &to) const = 0;
+    // The events of fetchEvents() as shared handles. Storages that keep their events as
+    // handles hand them out without copying; the default moves the fetched copies into handles.
+    virtual EventSnapshot fetchEventSnapshot(const QDate &from, const QDate &to) const
+    {
+        return EventSnapshot::fromEvents(fetchEvents(from, to));
+    }
+    // fetchEventSnapshot() without blocking the caller, which must own the repository. Backends
+    // that can hand the expensive part to a worker thread return a running future; the default
+    // answers right away. Once token is cancelled the query may stop early with an empty result.
+    virtual QFuture<EventSnapshot> fetchEventsAsync(const QDate &from,
+                                                    const QDate &to,
+                                                    const CancellationToken &token) const
+    {
+        if (token.isCancelled()) {
+            return finishedEventQuery({});
+        }
+        return finishedEventQuery(fetchEventSnapshot(from, to));
+    }
+    // Every stored event, series masters and overrides included, without blocking the caller,
+    // e.g. to index them. Storages that have to read or parse them do so on a worker thread.
+    virtual QFuture<EventSnapshot> fetchAllEventsAsync(const CancellationToken &token) const = 0;
+    // Masters of recurring series and overrides of single occurrences, whatever their dates.
+    // fetchEvents() of a storage returns them only when their own start and end match.
+    virtual std::vector<CalendarEvent> fetchSeriesEvents() const { return {}; }
     virtual std::optional<CalendarEvent> findById(const QUuid &id) const = 0;
     virtual CalendarEvent addEvent(CalendarEvent event) = 0;
     virtual bool updateEvent(const CalendarEvent &event) = 0;
     virtual bool removeEvent(const QUuid &id) = 0;
+
+    // Mutations between beginBatch() and the matching commitBatch() are persisted once at
+    // commit time. Batches may nest; repositories without persistence ignore them.
+    virtual void beginBatch() {}
+    virtual void commitBatch() {}
 };
 
 } // namespace data
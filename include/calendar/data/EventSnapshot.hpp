@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QUuid>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "calendar/data/Event.hpp"
+
+namespace calendar {
+namespace data {
+
+// Shared, immutable event. Storages replace the handle of an event when it changes instead of
+// modifying it, so a handle that was handed out never changes under its holder.
+using EventHandle = std::shared_ptr<const CalendarEvent>;
+
+// Immutable list of event handles, shared by reference count. Copying a snapshot copies a
+// pointer; deriving a new one (withReplaced(), or a view model patching its range) copies the
+// handles but shares every unchanged event. Neither the list nor the events are ever modified,
+// so a snapshot can be read from any thread while the repository keeps changing.
+class EventSnapshot
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = CalendarEvent;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const CalendarEvent *;
+        using reference = const CalendarEvent &;
+
+        const_iterator() = default;
+        explicit const_iterator(std::vector<EventHandle>::const_iterator it)
+            : m_it(it)
+        {
+        }
+
+        reference operator*() const { return **m_it; }
+        pointer operator->() const { return m_it->get(); }
+        const_iterator &operator++()
+        {
+            ++m_it;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator previous = *this;
+            ++m_it;
+            return previous;
+        }
+        bool operator==(const const_iterator &other) const { return m_it == other.m_it; }
+        bool operator!=(const const_iterator &other) const { return m_it != other.m_it; }
+
+    private:
+        std::vector<EventHandle>::const_iterator m_it;
+    };
+
+    EventSnapshot() = default;
+    // Handles must not be null.
+    explicit EventSnapshot(std::vector<EventHandle> events);
+    // Moves the events into handles of their own.
+    static EventSnapshot fromEvents(std::vector<CalendarEvent> events);
+
+    bool empty() const;
+    std::size_t size() const;
+    const CalendarEvent &operator[](std::size_t index) const;
+    const CalendarEvent &front() const;
+    const CalendarEvent &back() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    const std::vector<EventHandle> &handles() const;
+    // Copy in which the event with the same id is replaced by event; nothing else changes.
+    EventSnapshot withReplaced(CalendarEvent event) const;
+    // Deep copy of the events, for code that wants to own them.
+    std::vector<CalendarEvent> toVector() const;
+
+private:
+    std::shared_ptr<const std::vector<EventHandle>> m_events;
+};
+
+} // namespace data
+} // namespace calendar
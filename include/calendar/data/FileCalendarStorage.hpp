@@ -1,25 +1,93 @@
 #pragma once
 
+#include <QByteArray>
 #include <QHash>
+#include <QDate>
 #include <QDateTime>
+#include <QMap>
+#include <QObject>
+#include <QSet>
 #include <QString>
 #include <QUuid>
 #include <memory>
+#include <optional>
+#include <vector>
 
+#include "calendar/data/ChangeSet.hpp"
 #include "calendar/data/Event.hpp"
+#include "calendar/data/EventIntervalIndex.hpp"
+#include "calendar/data/EventQuery.hpp"
+#include "calendar/data/EventSnapshot.hpp"
+#include "calendar/data/IcsEventRef.hpp"
 #include "calendar/data/Todo.hpp"
+#include "calendar/data/TodoOrderIndex.hpp"
+
+class QFileSystemWatcher;
+class QThread;
+class QTimer;
 
 namespace calendar {
 namespace data {
 
-class FileCalendarStorage
+class CalendarWriter;
+
+class FileCalendarStorage : public QObject
 {
+    Q_OBJECT
+
 public:
-    explicit FileCalendarStorage(QString filePath);
-    ~FileCalendarStorage() = default;
+    // SingleFile keeps the calendar in one ICS file plus a journal of changes. Monthly treats
+    // filePath as a directory with one ICS file per month ("2025/2025-10.ics"), todos in
+    // "todos.ics" and events that cross a month boundary in "spanning.ics". Month files are
+    // read when a query first touches them, and a change only rewrites the files it affects.
+    // "shards.index" records the file of every event, so looking up an event by id reads only
+    // its month, and updating one that was not read yet moves it out of its old file. Every
+    // file carries a revision; should an event still be found in two files, e.g. after an
+    // interrupted move, the copy from the newer file wins and the other one is dropped.
+    //
+    // In the SingleFile layout the ICS file is watched for edits by other programs. The file is
+    // indexed again in the background and only the events and todos that differ from memory
+    // are taken over and reported. Changes that are still in the journal win over the file.
+    enum class Layout {
+        SingleFile,
+        Monthly
+    };
 
-    const QHash<QUuid, CalendarEvent> &events() const;
+    explicit FileCalendarStorage(QString filePath, QObject *parent = nullptr);
+    FileCalendarStorage(QString filePath, Layout layout, QObject *parent = nullptr);
+    ~FileCalendarStorage() override;
+
+    // Events are loaded lazily: at startup only their location in the ICS file is indexed and
+    // the full event is parsed the first time it is requested.
+    std::optional<CalendarEvent> event(const QUuid &id) const;
+    bool containsEvent(const QUuid &id) const;
+    int eventCount() const;
+    // Parses every event without keeping the results materialized.
+    QHash<QUuid, CalendarEvent> allEvents() const;
     const QHash<QUuid, TodoItem> &todos() const;
+    // Todos in listing order (todoListedBefore()), read off an index kept sorted on every change.
+    std::vector<TodoItem> orderedTodos() const;
+    // Events touching the given days, ordered by start and end.
+    std::vector<CalendarEvent> eventsInRange(const QDate &from, const QDate &to) const;
+    // The same events as the handles kept in memory, without copying them.
+    EventSnapshot eventSnapshot(const QDate &from, const QDate &to) const;
+    // eventSnapshot() with the events that are not materialized yet parsed on a worker thread.
+    // Those are not kept materialized; month files are still read on the calling thread.
+    QFuture<EventSnapshot> eventSnapshotAsync(const QDate &from,
+                                              const QDate &to,
+                                              const CancellationToken &token) const;
+    // Every event without blocking the caller. Events that are not materialized and month files
+    // that were not read yet are parsed on a worker thread, and nothing read there is kept.
+    QFuture<EventSnapshot> allEventsAsync(const CancellationToken &token) const;
+    // Masters of recurring series and overrides of their occurrences.
+    std::vector<CalendarEvent> seriesEvents() const;
+
+    // Maximum number of unmodified events kept materialized. The least recently used ones are
+    // dropped back to their ICS source beyond that (default 2000).
+    void setMaterializedEventBudget(int events);
+    int materializedEventCount() const;
+    // Number of month files read so far (Monthly layout).
+    int loadedShardCount() const;
 
     CalendarEvent addOrUpdateEvent(CalendarEvent event);
     bool removeEvent(const QUuid &id);
@@ -27,22 +95,111 @@ public:
     TodoItem addOrUpdateTodo(TodoItem todo);
     bool removeTodo(const QUuid &id);
 
+    // Defers persistence of all mutations until the outermost commitBatch().
+    void beginBatch();
+    void commitBatch();
+
+    // Schedules a rewrite of the full calendar into the ICS file, which discards the journal.
+    void compact();
+    // Blocks until all pending changes have been written by the writer thread.
+    void flush();
+    bool isWriting() const;
+    // Changes arriving within this interval are written together (default 250 ms).
+    void setWriteCoalescingInterval(int msecs);
+    QString journalPath() const;
+
+signals:
+    void writingChanged(bool writing);
+    void writeFailed(const QString &errorString);
+    void eventsChangedExternally(const calendar::data::EventChangeSet &changes);
+    void todosChangedExternally(const calendar::data::TodoChangeSet &changes);
+
 private:
-    void load();
-    void save() const;
+    struct ExternalState;
 
-    static QString encodeText(const QString &text);
-    static QString decodeText(const QString &text);
-    static QString formatDateTime(const QDateTime &dt);
-    static QDateTime parseDateTime(const QString &value);
-    static QString statusToString(TodoStatus status);
-    static TodoStatus statusFromString(const QString &value);
+    void load();
+    void loadShards();
+    void loadShard(const QDate &month) const;
+    void loadShardsInRange(const QDate &from, const QDate &to) const;
+    // Reads the month file the shard index names for id, or every file if the index may be
+    // missing it. Returns whether a file was read.
+    bool loadShardOf(const QUuid &id) const;
+    bool loadAllShards() const;
+    QString shardPath(const QDate &month) const;
+    QString shardIndexPath() const;
+    void loadShardIndex();
+    QByteArray shardIndex() const;
+    qint64 nextShardRevision();
+    void assignShard(const QUuid &id, const QDate &month);
+    void releaseShard(const QUuid &id);
+    void writeDirtyShards();
+    void watchFile();
+    void startExternalReload();
+    void applyExternalState(const ExternalState &state);
+    bool hasSameContent(const QUuid &id, const QByteArray &source, const IcsEventRef &ref) const;
+    void persistChange(const QUuid &id, const QString &record);
+    void flushPendingChanges();
+    void indexEvent(const QUuid &id, const QDateTime &start, const QDateTime &end, bool inSeries) const;
+    void unindexEvent(const QUuid &id) const;
+    void indexTodos();
+    void markModified(const QUuid &id);
+    EventHandle materialize(const QUuid &id) const;
+    void evictColdEvents() const;
+    CalendarWriter *writer();
 
     QString m_filePath;
-    QHash<QUuid, CalendarEvent> m_events;
+    Layout m_layout = Layout::SingleFile;
+    // Contents of the ICS file at load time; m_eventRefs point into it.
+    QByteArray m_source;
+    // Events that are unmodified since loading.
+    QHash<QUuid, IcsEventRef> m_eventRefs;
+    // Modified events plus materialized copies of unmodified ones. A change replaces the
+    // handle, so snapshots handed out keep the version they were taken with.
+    mutable QHash<QUuid, EventHandle> m_events;
+    // Last access of every materialized unmodified event.
+    mutable QHash<QUuid, quint64> m_eventAccess;
+    mutable quint64 m_accessClock = 0;
+    int m_materializedEventBudget = 0;
     QHash<QUuid, TodoItem> m_todos;
+    TodoOrderIndex m_todoOrder;
+    mutable EventIntervalIndex m_eventIndex;
+    // Events for seriesEvents(), which does not depend on the time range.
+    mutable QSet<QUuid> m_seriesIds;
+    // Monthly layout: every month file by its first day and whether it has been read. Events of
+    // the spanning file are filed under the invalid date.
+    mutable QMap<QDate, bool> m_monthShards;
+    mutable QHash<QUuid, QDate> m_eventShards;
+    mutable QHash<QDate, QSet<QUuid>> m_shardEvents;
+    mutable QSet<QDate> m_dirtyShards;
+    // Revision of every month file read or written so far, and the highest one seen.
+    mutable QHash<QDate, qint64> m_shardRevisions;
+    mutable qint64 m_shardRevision = 0;
+    // Contents of "shards.index": the file of every event, including months not read yet.
+    mutable QHash<QUuid, QDate> m_indexedShards;
+    // Whether m_indexedShards lists every stored event: the index was read from disk, there
+    // were no month files, or every month has been read.
+    mutable bool m_shardIndexComplete = false;
+    // Events changed since loading; their copy in memory is newer than any file.
+    QSet<QUuid> m_changedEvents;
+    // Files events were moved out of since the last write. They keep the event until the
+    // new file has been written.
+    QHash<QUuid, QDate> m_movedEvents;
+    bool m_todosDirty = false;
+    int m_journalRecords = 0;
+    bool m_journalNeedsCompaction = false;
+    int m_batchDepth = 0;
+    QString m_pendingJournal;
+    int m_pendingRecords = 0;
+    int m_writeCoalescingInterval = 0;
+    std::unique_ptr<CalendarWriter> m_writer;
+    std::unique_ptr<QThread> m_writerThread;
+    // Ids changed since the last compaction, i.e. the ones the journal would restore.
+    QSet<QUuid> m_journaledIds;
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer *m_reloadTimer = nullptr;
+    bool m_reloadRunning = false;
+    bool m_reloadPending = false;
 };
 
 } // namespace data
 } // namespace calendar
-
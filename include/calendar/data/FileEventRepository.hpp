@@ -15,10 +15,18 @@ public:
     ~FileEventRepository() override = default;
 
     std::vector<CalendarEvent> fetchEvents(const QDate &from, const QDate &to) const override;
+    EventSnapshot fetchEventSnapshot(const QDate &from, const QDate &to) const override;
+    QFuture<EventSnapshot> fetchEventsAsync(const QDate &from,
+                                            const QDate &to,
+                                            const CancellationToken &token) const override;
+    QFuture<EventSnapshot> fetchAllEventsAsync(const CancellationToken &token) const override;
+    std::vector<CalendarEvent> fetchSeriesEvents() const override;
     std::optional<CalendarEvent> findById(const QUuid &id) const override;
     CalendarEvent addEvent(CalendarEvent event) override;
     bool updateEvent(const CalendarEvent &event) override;
     bool removeEvent(const QUuid &id) override;
+    void beginBatch() override;
+    void commitBatch() override;
 
 private:
     std::shared_ptr<FileCalendarStorage> m_storage;
@@ -19,6 +19,8 @@ public:
     TodoItem addTodo(TodoItem todo) override;
     bool updateTodo(const TodoItem &todo) override;
     bool removeTodo(const QUuid &id) override;
+    void beginBatch() override;
+    void commitBatch() override;
 
 private:
     std::shared_ptr<FileCalendarStorage> m_storage;
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QDate>
+#include <QDateTime>
+#include <QString>
+
+namespace calendar {
+namespace data {
+
+// Conversion between QDateTime and the date forms of the ICS dialect, "yyyyMMdd" and
+// "yyyyMMdd'T'hhmmss'Z'". Digits are handled directly with calendar arithmetic, and local
+// times are converted with a per-thread table of UTC offsets sampled once per day. Days close
+// to a daylight saving transition and unusual input go through QDateTime instead, so the
+// results are identical to QDateTime::toUTC().toString() and QDateTime::toLocalTime().
+class IcsDateTime
+{
+public:
+    // "yyyyMMdd" is the start of that local day, "yyyyMMdd'T'hhmmss'Z'" a UTC time converted
+    // to local time and "yyyyMMdd'T'hhmmss" a local time. Anything else is read as ISO 8601.
+    static QDateTime parse(const char *data, int size);
+    // "yyyyMMdd'T'hhmmss'Z'", or an empty string for an invalid dateTime.
+    static QString format(const QDateTime &dateTime);
+    // "yyyyMMdd".
+    static QString formatDate(const QDate &date);
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QDateTime>
+#include <QUuid>
+
+namespace calendar {
+namespace data {
+
+// A VEVENT that has not been materialized: its position in the ICS source plus the fields
+// needed to place it in the interval index.
+struct IcsEventRef {
+    QUuid id;
+    QDateTime start;
+    QDateTime end;
+    qint64 offset = 0;
+    int length = 0;
+    // A recurring master or an override of one of its occurrences.
+    bool inSeries = false;
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QString>
+
+namespace calendar {
+namespace data {
+
+class EventRepository;
+class TodoRepository;
+
+// Moves whole calendars between an ICS file and any pair of repositories, e.g. to migrate
+// default.ics into a SQLite database or to export a database for other calendar applications.
+class IcsExchange
+{
+public:
+    // Adds every event and todo of the file in a single batch. Returns the number of records
+    // read, or -1 if the file could not be read.
+    static int importFile(const QString &icsPath, EventRepository &events, TodoRepository &todos);
+    // events is written as it is stored; a RecurringEventRepository would write every
+    // occurrence of a series as an event of its own.
+    static bool exportFile(const QString &icsPath,
+                           const EventRepository &events,
+                           const TodoRepository &todos,
+                           QString *errorString = nullptr);
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QUuid>
+#include <optional>
+
+#include "calendar/data/Event.hpp"
+#include "calendar/data/IcsEventRef.hpp"
+#include "calendar/data/Todo.hpp"
+
+namespace calendar {
+namespace data {
+
+// Parser for the ICS dialect written by IcsWriter. It works on raw UTF-8 bytes and only
+// creates QStrings for values that end up in a CalendarEvent or TodoItem.
+class IcsParser
+{
+public:
+    // Journal lines outside of any component that record a removal.
+    static constexpr const char *DeletedEventProperty = "X-TASKMASTER-DELETED-EVENT";
+    static constexpr const char *DeletedTodoProperty = "X-TASKMASTER-DELETED-TODO";
+    // Calendar property counting the rewrites of a file; the higher revision is the newer file.
+    static constexpr const char *RevisionProperty = "X-TASKMASTER-REVISION";
+
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+        virtual void eventParsed(CalendarEvent event) = 0;
+        virtual void todoParsed(TodoItem todo) = 0;
+        // Replaces eventParsed() when only an index is built.
+        virtual void eventIndexed(const IcsEventRef &ref);
+        virtual void eventRemoved(const QUuid &id);
+        virtual void todoRemoved(const QUuid &id);
+        virtual void revisionParsed(qint64 revision);
+    };
+
+    // Keeps the latest version of every component, in the order the records were applied.
+    class Collector : public Handler
+    {
+    public:
+        void eventParsed(CalendarEvent event) override;
+        void todoParsed(TodoItem todo) override;
+        void eventIndexed(const IcsEventRef &ref) override;
+        void eventRemoved(const QUuid &id) override;
+        void todoRemoved(const QUuid &id) override;
+        void revisionParsed(qint64 revision) override;
+
+        QHash<QUuid, CalendarEvent> events;
+        QHash<QUuid, IcsEventRef> eventRefs;
+        QHash<QUuid, TodoItem> todos;
+        // 0 for files written without a revision.
+        qint64 revision = 0;
+    };
+
+    struct Result {
+        int records = 0;
+        // False if the input ends inside a component, e.g. after an interrupted write.
+        bool complete = true;
+    };
+
+    // Memory-maps the file privately (copy-on-write) and parses it; the file is never modified.
+    static Result parseFile(const QString &filePath, Handler &handler);
+    // Parses [begin, end). Folded lines are unfolded in place, so the buffer must be writable.
+    static Result parse(char *begin, char *end, Handler &handler);
+    // Splits large inputs at BEGIN:VEVENT/BEGIN:VTODO lines and parses the chunks on the
+    // global thread pool. The merged result is identical to a sequential parse.
+    static Result parseFileConcurrently(const QString &filePath, Collector &collector);
+    static Result parseConcurrently(char *begin, char *end, Collector &collector);
+
+    // Reports every VEVENT as an IcsEventRef (offsets relative to begin) instead of parsing it;
+    // todos and removals are handled as usual. The input is not modified.
+    static Result index(const char *begin, const char *end, Handler &handler);
+    static Result indexConcurrently(const char *begin, const char *end, Collector &collector);
+    // Materializes a single VEVENT, typically the range of an IcsEventRef.
+    static std::optional<CalendarEvent> parseEvent(const char *data, int size);
+
+    static QString decodeText(const char *data, int size);
+    static QDateTime parseDateTime(const char *data, int size);
+    static TodoStatus statusFromString(const char *data, int size);
+
+private:
+    static Result parseChunks(const char *begin, const char *end, Collector &collector, bool indexEvents);
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QTextStream>
+#include <QUuid>
+
+#include "calendar/data/CalendarSnapshot.hpp"
+#include "calendar/data/Event.hpp"
+#include "calendar/data/Todo.hpp"
+
+namespace calendar {
+namespace data {
+
+// Serializes events and todos into the ICS dialect used by FileCalendarStorage.
+// All functions are reentrant so they can run on the background writer thread.
+class IcsWriter
+{
+public:
+    static void writeEvent(QTextStream &stream, const CalendarEvent &event);
+    static void writeTodo(QTextStream &stream, const TodoItem &todo);
+    static QString eventRecord(const CalendarEvent &event);
+    static QString todoRecord(const TodoItem &todo);
+
+    // Writes the snapshot as one ICS file; unmaterialized events are copied verbatim from
+    // snapshot.source. writtenEvents receives the location of every event in the new file and
+    // writtenState the state of the file these locations refer to.
+    static bool writeCalendar(const QString &filePath,
+                              const CalendarSnapshot &snapshot,
+                              QString *errorString = nullptr,
+                              QHash<QUuid, IcsEventRef> *writtenEvents = nullptr,
+                              IcsSourceState *writtenState = nullptr);
+
+    static QString encodeText(const QString &text);
+    static QString formatDateTime(const QDateTime &dt);
+    static QString statusToString(TodoStatus status);
+};
+
+} // namespace data
+} // namespace calendar
@@ -1,7 +1,9 @@
 #pragma once
 
-#include <QMultiHash>
+#include <QHash>
+#include <QSet>
 
+#include "calendar/data/EventIntervalIndex.hpp"
 #include "calendar/data/EventRepository.hpp"
 
 namespace calendar {
@@ -14,13 +16,20 @@ public:
     ~InMemoryEventRepository() override;
 
     std::vector<CalendarEvent> fetchEvents(const QDate &from, const QDate &to) const override;
+    QFuture<EventSnapshot> fetchAllEventsAsync(const CancellationToken &token) const override;
+    std::vector<CalendarEvent> fetchSeriesEvents() const override;
     std::optional<CalendarEvent> findById(const QUuid &id) const override;
     CalendarEvent addEvent(CalendarEvent event) override;
     bool updateEvent(const CalendarEvent &event) override;
     bool removeEvent(const QUuid &id) override;
 
 private:
+    void index(const CalendarEvent &event);
+
     QHash<QUuid, CalendarEvent> m_events;
+    // Range queries go through the same interval index as FileCalendarStorage.
+    EventIntervalIndex m_index;
+    QSet<QUuid> m_seriesIds;
 };
 
 } // namespace data
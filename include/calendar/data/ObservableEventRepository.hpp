@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QObject>
+
+#include "calendar/data/ChangeSet.hpp"
+#include "calendar/data/EventRepository.hpp"
+
+namespace calendar {
+namespace data {
+
+// Forwards to another repository and reports every mutation as an EventChangeSet. Mutations
+// inside a batch are reported together when the outermost batch is committed.
+class ObservableEventRepository : public QObject, public EventRepository
+{
+    Q_OBJECT
+
+public:
+    explicit ObservableEventRepository(EventRepository &repository, QObject *parent = nullptr);
+    ~ObservableEventRepository() override;
+
+    std::vector<CalendarEvent> fetchEvents(const QDate &from, const QDate &to) const override;
+    EventSnapshot fetchEventSnapshot(const QDate &from, const QDate &to) const override;
+    QFuture<EventSnapshot> fetchEventsAsync(const QDate &from,
+                                            const QDate &to,
+                                            const CancellationToken &token) const override;
+    QFuture<EventSnapshot> fetchAllEventsAsync(const CancellationToken &token) const override;
+    std::vector<CalendarEvent> fetchSeriesEvents() const override;
+    std::optional<CalendarEvent> findById(const QUuid &id) const override;
+    CalendarEvent addEvent(CalendarEvent event) override;
+    bool updateEvent(const CalendarEvent &event) override;
+    bool removeEvent(const QUuid &id) override;
+    void beginBatch() override;
+    void commitBatch() override;
+
+public slots:
+    // Reports changes that did not go through this repository, e.g. external edits of the
+    // calendar file. Inside a batch they are folded into the batch's change set.
+    void publishChanges(const calendar::data::EventChangeSet &changes);
+
+signals:
+    void eventsChanged(const calendar::data::EventChangeSet &changes);
+
+private:
+    void publish();
+
+    EventRepository &m_repository;
+    ChangeRecorder<CalendarEvent> m_changes;
+    int m_batchDepth = 0;
+};
+
+} // namespace data
+} // namespace calendar
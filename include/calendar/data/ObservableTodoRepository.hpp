@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QObject>
+
+#include "calendar/data/ChangeSet.hpp"
+#include "calendar/data/TodoRepository.hpp"
+
+namespace calendar {
+namespace data {
+
+// Forwards to another repository and reports every mutation as a TodoChangeSet. Mutations
+// inside a batch are reported together when the outermost batch is committed.
+class ObservableTodoRepository : public QObject, public TodoRepository
+{
+    Q_OBJECT
+
+public:
+    explicit ObservableTodoRepository(TodoRepository &repository, QObject *parent = nullptr);
+    ~ObservableTodoRepository() override;
+
+    std::vector<TodoItem> fetchTodos() const override;
+    QFuture<std::vector<TodoItem>> fetchTodosAsync(const CancellationToken &token) const override;
+    std::optional<TodoItem> findById(const QUuid &id) const override;
+    TodoItem addTodo(TodoItem todo) override;
+    bool updateTodo(const TodoItem &todo) override;
+    bool removeTodo(const QUuid &id) override;
+    void beginBatch() override;
+    void commitBatch() override;
+
+public slots:
+    // Reports changes that did not go through this repository, e.g. external edits of the
+    // calendar file. Inside a batch they are folded into the batch's change set.
+    void publishChanges(const calendar::data::TodoChangeSet &changes);
+
+signals:
+    void todosChanged(const calendar::data::TodoChangeSet &changes);
+
+private:
+    void publish();
+
+    TodoRepository &m_repository;
+    ChangeRecorder<TodoItem> m_changes;
+    int m_batchDepth = 0;
+};
+
+} // namespace data
+} // namespace calendar
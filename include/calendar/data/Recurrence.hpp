@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QDateTime>
+#include <QString>
+#include <QUuid>
+#include <QtGlobal>
+#include <optional>
+#include <vector>
+
+#include "calendar/data/Event.hpp"
+
+namespace calendar {
+namespace data {
+
+// A parsed RFC 5545 RRULE. FREQ=DAILY/WEEKLY/MONTHLY/YEARLY with INTERVAL, COUNT, UNTIL,
+// BYDAY (with ordinals in monthly and yearly rules), BYMONTHDAY and BYMONTH are supported.
+// WKST is accepted, but weeks always start on Monday. Rules with any other part are rejected
+// rather than expanded wrongly; their events show up as a single occurrence.
+struct RecurrenceRule
+{
+    enum class Frequency {
+        Daily,
+        Weekly,
+        Monthly,
+        Yearly
+    };
+
+    struct WeekdayNum {
+        // 0 for every such weekday, 1 for the first, -1 for the last one of the month or year.
+        int ordinal = 0;
+        // 1 (Monday) to 7 (Sunday), as QDate::dayOfWeek().
+        int dayOfWeek = 1;
+    };
+
+    // Upper bound of occurrences() for a single window.
+    static constexpr int MaxOccurrences = 10000;
+
+    static std::optional<RecurrenceRule> parse(const QString &rule);
+
+    // Starts of the occurrences of a series beginning at start whose span of durationMs
+    // overlaps [from, to], in order. start itself is always the first occurrence. Without
+    // COUNT, expansion begins at the first period that can reach from, so an endless series
+    // costs the same for any window.
+    std::vector<QDateTime> occurrences(const QDateTime &start,
+                                       qint64 durationMs,
+                                       const QDateTime &from,
+                                       const QDateTime &to) const;
+
+    Frequency frequency = Frequency::Daily;
+    int interval = 1;
+    // 0 if the series is not limited by a count.
+    int count = 0;
+    QDateTime until;
+    std::vector<WeekdayNum> byDay;
+    std::vector<int> byMonthDay;
+    std::vector<int> byMonth;
+};
+
+class Recurrence
+{
+public:
+    // Id of the occurrence of a series that originally starts at recurrenceId. It is derived
+    // from both, so an occurrence and an override replacing it always share the same id.
+    static QUuid occurrenceId(const QUuid &seriesId, const QDateTime &recurrenceId);
+    // A series master (RRULE) or the override of one of its occurrences (RECURRENCE-ID).
+    static bool belongsToSeries(const CalendarEvent &event);
+    static bool isOverride(const CalendarEvent &event);
+};
+
+} // namespace data
+} // namespace calendar
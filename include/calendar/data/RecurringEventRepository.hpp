@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QUuid>
+#include <vector>
+
+#include "calendar/data/EventRepository.hpp"
+#include "calendar/data/Recurrence.hpp"
+
+namespace calendar {
+namespace data {
+
+// Forwards to another repository and expands its recurring series. fetchEvents() replaces
+// every series master by its occurrences in the requested days, leaving out the ones excluded
+// by EXDATE or replaced by an override. The occurrence times are cached per series and window
+// until the rule, start or end of the master changes, so scrolling back and forth does not
+// expand a series again.
+//
+// Occurrences behave like events: updating one stores an override of it, removing one adds
+// an exception date to its master. Removing a master removes the whole series.
+class RecurringEventRepository : public EventRepository
+{
+public:
+    explicit RecurringEventRepository(EventRepository &repository);
+    ~RecurringEventRepository() override;
+
+    std::vector<CalendarEvent> fetchEvents(const QDate &from, const QDate &to) const override;
+    EventSnapshot fetchEventSnapshot(const QDate &from, const QDate &to) const override;
+    // Series are expanded on the calling thread; the backend query and the merge run on a
+    // worker thread when the backend supports it.
+    QFuture<EventSnapshot> fetchEventsAsync(const QDate &from,
+                                            const QDate &to,
+                                            const CancellationToken &token) const override;
+    // The stored events of the other repository; series are not expanded.
+    QFuture<EventSnapshot> fetchAllEventsAsync(const CancellationToken &token) const override;
+    std::vector<CalendarEvent> fetchSeriesEvents() const override;
+    std::optional<CalendarEvent> findById(const QUuid &id) const override;
+    CalendarEvent addEvent(CalendarEvent event) override;
+    bool updateEvent(const CalendarEvent &event) override;
+    bool removeEvent(const QUuid &id) override;
+    void beginBatch() override;
+    void commitBatch() override;
+
+    // Windows cached over all series.
+    int cachedWindowCount() const;
+
+private:
+    struct Window {
+        qint64 from = 0;
+        qint64 to = 0;
+        std::vector<QDateTime> starts;
+        quint64 lastUse = 0;
+    };
+
+    struct SeriesCache {
+        QString rule;
+        QDateTime start;
+        QDateTime end;
+        std::vector<Window> windows;
+    };
+
+    struct OccurrenceKey {
+        QUuid seriesId;
+        QDateTime recurrenceId;
+    };
+
+    // Occurrences of every series in the given days, except excluded and overridden ones.
+    std::vector<EventHandle> occurrencesInRange(const QDate &from, const QDate &to) const;
+    std::vector<QDateTime> occurrenceStarts(const CalendarEvent &master,
+                                            const RecurrenceRule &rule,
+                                            const QDateTime &from,
+                                            const QDateTime &to) const;
+    std::optional<CalendarEvent> generatedOccurrence(const QUuid &id) const;
+    void rememberOccurrence(const CalendarEvent &occurrence) const;
+
+    EventRepository &m_repository;
+    mutable QHash<QUuid, SeriesCache> m_cache;
+    // Generated occurrences handed out so far, so that findById() can rebuild them.
+    mutable QHash<QUuid, OccurrenceKey> m_occurrences;
+    mutable quint64 m_useClock = 0;
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,31 @@
+#pragma once
+
+namespace calendar {
+namespace data {
+
+class EventRepository;
+class TodoRepository;
+
+// Scope guard that opens a batch on the given repositories and commits it when the
+// scope ends, so multi-item operations are persisted with a single write.
+class RepositoryBatch
+{
+public:
+    explicit RepositoryBatch(EventRepository &events);
+    explicit RepositoryBatch(TodoRepository &todos);
+    RepositoryBatch(EventRepository &events, TodoRepository &todos);
+    ~RepositoryBatch();
+
+    RepositoryBatch(const RepositoryBatch &) = delete;
+    RepositoryBatch &operator=(const RepositoryBatch &) = delete;
+
+    void commit();
+
+private:
+    EventRepository *m_events = nullptr;
+    TodoRepository *m_todos = nullptr;
+    bool m_committed = false;
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QUuid>
+#include <QtGlobal>
+
+namespace calendar {
+namespace data {
+
+// Inverted index from the trigrams of case-folded texts to the ids they belong to. A query of
+// three or more characters only checks the ids that contain all of its trigrams; shorter ones
+// scan the stored texts. Either way the result equals a case-insensitive contains() over every
+// text, and updating one text only touches its own trigrams.
+class SearchIndex
+{
+public:
+    // Inserts the text or replaces the one stored for id.
+    void insert(const QUuid &id, const QString &text);
+    bool remove(const QUuid &id);
+    void clear();
+    int size() const;
+    bool contains(const QUuid &id) const;
+
+    // Ids whose text contains query, ignoring case. Empty for an empty query.
+    QSet<QUuid> matching(const QString &query) const;
+
+private:
+    static QSet<quint64> trigrams(const QString &foldedText);
+
+    QHash<QUuid, QString> m_texts;
+    QHash<quint64, QSet<QUuid>> m_postings;
+};
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QString>
+#include <functional>
+
+namespace calendar {
+namespace data {
+
+// Connection to the SQLite calendar database shared by SqliteEventRepository and
+// SqliteTodoRepository. Opening the database brings its schema up to date.
+class SqliteDatabase
+{
+public:
+    explicit SqliteDatabase(QString filePath);
+    ~SqliteDatabase();
+
+    SqliteDatabase(const SqliteDatabase &) = delete;
+    SqliteDatabase &operator=(const SqliteDatabase &) = delete;
+
+    bool isOpen() const;
+    QString lastError() const;
+    QSqlDatabase database() const;
+    QString filePath() const;
+    // Runs read with a read-only connection of its own to the database at filePath, e.g. on a
+    // worker thread, where the shared connection must not be used. Only committed data is seen.
+    static void readSeparately(const QString &filePath,
+                               const std::function<void(const QSqlDatabase &)> &read);
+    // Value of PRAGMA user_version, i.e. the number of applied migrations.
+    int schemaVersion() const;
+    static int latestSchemaVersion();
+
+    // Groups all statements until the outermost commitBatch() into one transaction.
+    void beginBatch();
+    void commitBatch();
+
+private:
+    bool configure();
+    bool migrate();
+    bool execute(const QString &statement);
+
+    QString m_filePath;
+    QString m_connectionName;
+    QSqlDatabase m_database;
+    QString m_lastError;
+    int m_batchDepth = 0;
+    bool m_open = false;
+};
+
+} // namespace data
+} // namespace calendar
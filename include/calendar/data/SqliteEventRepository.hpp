@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QSqlQuery>
+#include <memory>
+
+#include "calendar/data/EventRepository.hpp"
+
+namespace calendar {
+namespace data {
+
+class SqliteDatabase;
+
+class SqliteEventRepository : public EventRepository
+{
+public:
+    explicit SqliteEventRepository(std::shared_ptr<SqliteDatabase> database);
+    ~SqliteEventRepository() override;
+
+    std::vector<CalendarEvent> fetchEvents(const QDate &from, const QDate &to) const override;
+    // Reads the events table on a worker thread with a connection of its own.
+    QFuture<EventSnapshot> fetchAllEventsAsync(const CancellationToken &token) const override;
+    std::vector<CalendarEvent> fetchSeriesEvents() const override;
+    std::optional<CalendarEvent> findById(const QUuid &id) const override;
+    CalendarEvent addEvent(CalendarEvent event) override;
+    bool updateEvent(const CalendarEvent &event) override;
+    bool removeEvent(const QUuid &id) override;
+    void beginBatch() override;
+    void commitBatch() override;
+
+private:
+    void bindEvent(QSqlQuery &query, const CalendarEvent &event) const;
+
+    std::shared_ptr<SqliteDatabase> m_database;
+    mutable QSqlQuery m_rangeQuery;
+    mutable QSqlQuery m_seriesQuery;
+    mutable QSqlQuery m_findQuery;
+    QSqlQuery m_upsertQuery;
+    QSqlQuery m_updateQuery;
+    QSqlQuery m_deleteQuery;
+};
+
+} // namespace data
+} // namespace calendar
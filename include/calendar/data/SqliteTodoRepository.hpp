@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QSqlQuery>
+#include <memory>
+
+#include "calendar/data/TodoRepository.hpp"
+
+namespace calendar {
+namespace data {
+
+class SqliteDatabase;
+
+class SqliteTodoRepository : public TodoRepository
+{
+public:
+    explicit SqliteTodoRepository(std::shared_ptr<SqliteDatabase> database);
+    ~SqliteTodoRepository() override;
+
+    std::vector<TodoItem> fetchTodos() const override;
+    // Reads the todos table on a worker thread with a connection of its own.
+    QFuture<std::vector<TodoItem>> fetchTodosAsync(const CancellationToken &token) const override;
+    std::optional<TodoItem> findById(const QUuid &id) const override;
+    TodoItem addTodo(TodoItem todo) override;
+    bool updateTodo(const TodoItem &todo) override;
+    bool removeTodo(const QUuid &id) override;
+    void beginBatch() override;
+    void commitBatch() override;
+
+private:
+    void bindTodo(QSqlQuery &query, const TodoItem &todo) const;
+
+    std::shared_ptr<SqliteDatabase> m_database;
+    mutable QSqlQuery m_fetchQuery;
+    mutable QSqlQuery m_findQuery;
+    QSqlQuery m_upsertQuery;
+    QSqlQuery m_updateQuery;
+    QSqlQuery m_deleteQuery;
+};
+
+} // namespace data
+} // namespace calendar
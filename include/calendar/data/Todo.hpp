@@ -29,5 +29,14 @@ struct TodoItem
     int durationMinutes = 0;
 };
 
+// Order in which repositories list todos: highest priority first, then by title.
+inline bool todoListedBefore(const TodoItem &lhs, const TodoItem &rhs)
+{
+    if (lhs.priority == rhs.priority) {
+        return lhs.title.toLower() < rhs.title.toLower();
+    }
+    return lhs.priority > rhs.priority;
+}
+
 } // namespace data
 } // namespace calendar
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QUuid>
+#include <set>
+#include <vector>
+
+#include "calendar/data/Todo.hpp"
+
+namespace calendar {
+namespace data {
+
+// Todo ids in listing order (see todoListedBefore()), kept sorted across mutations. The
+// lower-cased title is computed once per insert, so neither updates (O(log n)) nor reading
+// the order compare strings that have to be folded again. Equal keys are ordered by id.
+class TodoOrderIndex
+{
+public:
+    void insert(const TodoItem &todo);
+    bool remove(const QUuid &id);
+    void clear();
+    int size() const;
+
+    std::vector<QUuid> ids() const;
+
+private:
+    struct Key {
+        int priority = 0;
+        QString foldedTitle;
+        QUuid id;
+
+        bool operator<(const Key &other) const;
+    };
+
+    std::set<Key> m_order;
+    QHash<QUuid, std::set<Key>::const_iterator> m_keys;
+};
+
+} // namespace data
+} // namespace calendar
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <QFuture>
+#include <QFutureInterface>
 #include <optional>
 #include <vector>
 
+#include "calendar/data/EventQuery.hpp"
 #include "calendar/data/Todo.hpp"
 
 namespace calendar {
@@ -14,10 +17,26 @@ public:
     virtual ~TodoRepository() = default;
 
     virtual std::vector<TodoItem> fetchTodos() const = 0;
+    // fetchTodos() without blocking the caller, see EventRepository::fetchEventsAsync(). The
+    // default answers right away; a cancelled query has no result.
+    virtual QFuture<std::vector<TodoItem>> fetchTodosAsync(const CancellationToken &token) const
+    {
+        QFutureInterface<std::vector<TodoItem>> result;
+        result.reportStarted();
+        if (!token.isCancelled()) {
+            result.reportResult(fetchTodos());
+        }
+        result.reportFinished();
+        return result.future();
+    }
     virtual std::optional<TodoItem> findById(const QUuid &id) const = 0;
     virtual TodoItem addTodo(TodoItem todo) = 0;
     virtual bool updateTodo(const TodoItem &todo) = 0;
     virtual bool removeTodo(const QUuid &id) = 0;
+
+    // See EventRepository::beginBatch().
+    virtual void beginBatch() {}
+    virtual void commitBatch() {}
 };
 
 } // namespace data
@@ -58,6 +58,7 @@ private:
     void handleTodoSelectionChanged(TodoListView *view);
     void clearOtherTodoSelections(QListView *except);
     void updateTodoFilterText(const QString &text);
+    void updateEventSearchFilter();
     void handleTodoStatusDrop(const QList<QUuid> &todoIds, data::TodoStatus status);
     void clearAllTodoSelections();
     void goToday();
@@ -138,6 +139,7 @@ private:
     std::unique_ptr<SettingsDialog> m_settingsDialog;
     bool m_previewVisible = false;
     QLabel *m_shortcutLabel = nullptr;
+    QLabel *m_saveStateLabel = nullptr;
     QDate m_currentDate;
     int m_visibleDays = 9;
     double m_dayOffset = 0.0;
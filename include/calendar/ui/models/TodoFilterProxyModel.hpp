@@ -3,6 +3,7 @@
 #include <QSortFilterProxyModel>
 #include <optional>
 
+#include "calendar/data/CalendarSearch.hpp"
 #include "calendar/data/Todo.hpp"
 
 namespace calendar {
@@ -15,7 +16,9 @@ class TodoFilterProxyModel : public QSortFilterProxyModel
 public:
     explicit TodoFilterProxyModel(QObject *parent = nullptr);
 
-    void setFilterText(const QString &text);
+    // matches are the todos whose title or description contains text; rows are only looked
+    // up in it. Applied again whenever the todos change.
+    void setFilterText(const QString &text, data::TodoMatches matches);
     void setStatusFilter(std::optional<data::TodoStatus> status);
 
 protected:
@@ -23,6 +26,7 @@ protected:
 
 private:
     QString m_filterText;
+    data::TodoMatches m_matches;
     std::optional<data::TodoStatus> m_statusFilter;
 };
 
@@ -24,7 +24,13 @@ public:
     QStringList mimeTypes() const override;
 
     void setTodos(QVector<data::TodoItem> todos);
+    const QVector<data::TodoItem> &todos() const;
     const data::TodoItem *todoAt(const QModelIndex &index) const;
+    // Single-row updates that keep the other rows, and with them selections, in place.
+    int rowOf(const QUuid &id) const;
+    void insertTodo(int row, data::TodoItem todo);
+    void replaceTodo(int row, data::TodoItem todo);
+    void removeTodoAt(int row);
     void setKeywordColors(QHash<QString, QColor> colors);
 
 signals:
@@ -2,9 +2,13 @@
 
 #include <QDate>
 #include <QObject>
+#include <optional>
 #include <vector>
 
+#include "calendar/data/ChangeSet.hpp"
 #include "calendar/data/Event.hpp"
+#include "calendar/data/EventQuery.hpp"
+#include "calendar/data/EventSnapshot.hpp"
 
 namespace calendar {
 namespace data {
@@ -19,19 +23,60 @@ class ScheduleViewModel : public QObject
 
 public:
     ScheduleViewModel(data::EventRepository &repository, QObject *parent = nullptr);
+    ~ScheduleViewModel() override;
 
     void setRange(const QDate &start, const QDate &end);
+    // Shows the current range. Ranges fetched recently, including the ones prefetched next to
+    // the visible range in the direction of navigation, are served from memory. Otherwise the
+    // range is queried without blocking: until the result arrives events() keeps the previous
+    // snapshot, and a query that is overtaken by a newer one is cancelled and its result
+    // dropped, so eventsChanged() is only emitted for the latest range. Results that are ready
+    // right away are applied before refresh() returns.
     void refresh();
-    const std::vector<data::CalendarEvent> &events() const;
+    bool isLoading() const;
+    // Patches the loaded and the cached events instead of querying the repository again;
+    // eventsChanged() is only emitted if an event of the current range was affected. Changes
+    // of a recurring series master drop the cache and reload the range, as do changes while a
+    // query is running. Patching derives a new snapshot that shares the unchanged events with
+    // the previous one.
+    void applyChanges(const calendar::data::EventChangeSet &changes);
+    const data::EventSnapshot &events() const;
+    // For changes the view model is not told about.
+    void clearCache();
+    int cachedRangeCount() const;
 
 signals:
-    void eventsChanged(const std::vector<data::CalendarEvent> &events);
+    void eventsChanged(const calendar::data::EventSnapshot &events);
 
 private:
+    struct CachedRange {
+        QDate start;
+        QDate end;
+        data::EventSnapshot events;
+        quint64 lastUse = 0;
+    };
+
+    void applySnapshot(data::EventSnapshot events);
+    std::optional<data::EventSnapshot> cachedEvents(const QDate &start, const QDate &end);
+    void storeRange(const QDate &start, const QDate &end, const data::EventSnapshot &events);
+    void prefetch();
+
     data::EventRepository &m_repository;
     QDate m_start;
     QDate m_end;
-    std::vector<data::CalendarEvent> m_events;
+    // 1 after moving forward, -1 after moving backward, 0 before any move.
+    int m_direction = 0;
+    data::EventSnapshot m_events;
+    data::CancellationToken m_queryToken;
+    quint64 m_queryGeneration = 0;
+    bool m_queryPending = false;
+    std::vector<CachedRange> m_cache;
+    quint64 m_useClock = 0;
+    // Bumped whenever cached contents may be outdated; results of older queries are not cached.
+    quint64 m_cacheGeneration = 0;
+    data::CancellationToken m_prefetchToken;
+    QDate m_prefetchStart;
+    QDate m_prefetchEnd;
 };
 
 } // namespace ui
@@ -3,6 +3,7 @@
 #include <QObject>
 #include <memory>
 
+#include "calendar/data/ChangeSet.hpp"
 #include "calendar/data/Todo.hpp"
 
 namespace calendar {
@@ -24,11 +25,15 @@ public:
 
 public slots:
     void refresh();
+    // Patches the model row by row instead of reloading all todos.
+    void applyChanges(const calendar::data::TodoChangeSet &changes);
 
 signals:
     void todosChanged();
 
 private:
+    void insertListed(data::TodoItem todo);
+
     data::TodoRepository &m_repository;
     std::unique_ptr<TodoListModel> m_model;
 };
@@ -4,6 +4,8 @@
 #include <QDate>
 #include <QDateTime>
 #include <QVector>
+#include <array>
+#include <functional>
 #include <optional>
 #include <vector>
 #include <QString>
@@ -12,10 +14,12 @@
 #include <QElapsedTimer>
 #include <QHash>
 #include <QColor>
-#include <map>
 
+#include "calendar/data/CalendarSearch.hpp"
 #include "calendar/data/Event.hpp"
+#include "calendar/data/EventSnapshot.hpp"
 #include "calendar/data/Todo.hpp"
+#include "calendar/ui/widgets/DayLayout.hpp"
 
 namespace calendar {
 namespace ui {
@@ -30,13 +34,14 @@ public:
 
     void setDateRange(const QDate &start, int days);
     void setDayOffset(double offsetDays);
-    void setEvents(std::vector<data::CalendarEvent> events);
+    void setEvents(data::EventSnapshot events);
     void zoomTime(double factor);
     double hourHeight() const { return m_hourHeight; }
     void setHourHeight(double height);
     int verticalScrollValue() const;
     void setVerticalScrollValue(int value);
-    void setEventSearchFilter(const QString &text);
+    // matches are the events whose text contains text; the view only adds matches by start time.
+    void setEventSearchFilter(const QString &text, data::EventMatches matches);
     void setKeywordColors(QHash<QString, QColor> colors);
 signals:
     void dayZoomRequested(bool zoomIn);
@@ -97,7 +102,6 @@ private:
     void resetDragCandidate();
     void updateDropPreview(const QDateTime &start, int durationMinutes, const QString &label);
     void clearDropPreview();
-    QPair<double, double> handleArea(const data::CalendarEvent &event, bool top) const;
     void recalculateDayWidth();
     void maybeAutoScrollHorizontally(const QPoint &pos);
     bool handleWheelInteraction(QWheelEvent *event);
@@ -121,13 +125,27 @@ private:
     void clearTodoHoverFeedback();
     struct EventSegment {
         QRectF rect;
-        QDateTime segmentStart;
-        QDateTime segmentEnd;
         bool clipTop = false;
         bool clipBottom = false;
         int dayIndex = -1;
     };
+    // Segment of an event in a visible day, independent of the view geometry. Minutes count
+    // from the start of that day, m_startDate + dayIndex.
+    struct SegmentSpan {
+        int dayIndex = -1;
+        int startMinutes = 0;
+        int endMinutes = 0;
+        bool clipTop = false;
+        bool clipBottom = false;
+        // Wall clock range, as the day layout sees it.
+        DaySpan layoutSpan;
+    };
+    std::vector<SegmentSpan> segmentSpansFor(const data::CalendarEvent &event) const;
+    EventSegment segmentFromSpan(const SegmentSpan &span) const;
     std::vector<EventSegment> segmentsForEvent(const data::CalendarEvent &event) const;
+    // Segments of m_events[slot], from the cached spans.
+    std::vector<EventSegment> segmentsForSlot(std::size_t slot) const;
+    void ensureSegmentSpans() const;
     void startNewEventDrag();
     void updateNewEventDrag(const QPointF &scenePos);
     void finalizeNewEventDrag();
@@ -140,24 +158,72 @@ private:
     QString eventTooltipText(const data::CalendarEvent &event) const;
     QString formatDurationMinutes(int totalMinutes) const;
     void invalidateLayout();
+    // Marks the day columns the event touches for a new layout.
+    void invalidateLayoutDays(const data::CalendarEvent &event);
     void ensureLayoutCache() const;
-    struct LayoutInfo {
-        double offsetFraction = 0.0;
-        double widthFraction = 1.0;
-        enum class Anchor
-        {
-            Left,
-            Right,
-            Center
-        };
-        Anchor anchor = Anchor::Left;
-        int zPriority = 0;
+    using LayoutInfo = EventLayout;
+    // Layout of one date, kept while the date is near the visible range. Only dirty buckets
+    // gather their segments again, and only those whose segments differ are laid out again.
+    struct DayLayoutBucket {
+        std::vector<QUuid> ids;
+        std::vector<DaySpan> spans;
+        std::vector<LayoutInfo> layouts;
+        bool dirty = true;
+    };
+    // Layout of the event at the same index in m_events.
+    struct EventLayoutRecord {
+        bool hasOverlap = false;
+        bool hasOverlay = false;
+        int firstDay = 0;
+        // Visible days from firstDay on; days without a segment keep the default layout.
+        std::vector<LayoutInfo> days;
+    };
+    // Slots are indexes into m_events.
+    LayoutInfo layoutInfoFor(std::size_t slot, int dayIndex) const;
+    QRectF adjustedRectForSegment(std::size_t slot, const EventSegment &segment) const;
+    // Rect of the segment in dayIndex as drawn; the event in front is widened when it overlaps.
+    QRectF layoutRect(std::size_t slot, int dayIndex, const QRectF &segmentRect, bool inFront) const;
+    bool eventHasOverlap(std::size_t slot) const;
+    bool eventHasOverlay(std::size_t slot) const;
+
+    // Parts of one event are tried in this order.
+    enum class EventHitPart
+    {
+        TopHandle,
+        BottomHandle,
+        Body
+    };
+    struct EventHit {
+        std::size_t slot = 0;
+        EventHitPart part = EventHitPart::Body;
+    };
+    using EventHitFilter = std::function<bool(std::size_t slot, EventHitPart part)>;
+    // Visible segment of an event, with the resize handle ranges of its first and last one.
+    struct HitEntry {
+        std::size_t slot = 0;
+        int dayIndex = -1;
+        QRectF segmentRect;
+        // Laid out rect while the event is not in front.
+        QRectF rect;
+        bool firstSegment = false;
+        bool lastSegment = false;
+        QPair<double, double> topHandle;
+        QPair<double, double> bottomHandle;
+    };
+    // Segments of one day column sorted by the top of their extent (rect and handles). With the
+    // running maximum of the bottoms, the entries that may contain a y are a range found by
+    // binary search.
+    struct HitColumn {
+        std::vector<std::size_t> entries;
+        std::vector<double> tops;
+        std::vector<double> bottoms;
+        std::vector<double> maxBottoms;
     };
-    LayoutInfo layoutInfoFor(const QUuid &eventId, int dayIndex) const;
-    QRectF adjustedRectForSegment(const data::CalendarEvent &event, const EventSegment &segment) const;
-    bool eventHasOverlap(const data::CalendarEvent &event) const;
-    bool eventHasOverlay(const data::CalendarEvent &event) const;
-    std::vector<const data::CalendarEvent *> eventsInHitOrder() const;
+    void ensureHitIndex() const;
+    // First event part under scenePos in hit order that accept takes: the event in front (hovered,
+    // else selected), then overlays, then the others, each by time.
+    std::optional<EventHit> hitTest(const QPointF &scenePos, const EventHitFilter &accept) const;
+    std::optional<std::size_t> eventSlotAt(const QPointF &scenePos) const;
 
     QDate m_startDate;
     int m_dayCount = 5;
@@ -166,7 +232,7 @@ private:
     double m_dayOffset = 0.0;
     double m_headerHeight = 40.0;
     double m_timeAxisWidth = 70.0;
-    std::vector<data::CalendarEvent> m_events;
+    data::EventSnapshot m_events;
     QUuid m_selectedEvent;
     QUuid m_pendingResizeEvent;
     bool m_resizeAdjustStart = false;
@@ -205,9 +271,28 @@ private:
     bool m_allowNewEventCreation = true;
     std::optional<data::TodoStatus> m_currentTodoHoverStatus;
     QString m_eventSearchFilter;
+    data::EventMatches m_eventSearchMatches;
+    // Filter result per event id, so painting does not format start times again.
+    mutable QHash<QUuid, bool> m_eventFilterResults;
     QUuid m_hoveredEventId;
+    // Set when m_layoutRecords have to be rebuilt from m_dayLayouts.
     mutable bool m_layoutDirty = true;
-    mutable std::map<std::pair<QUuid, int>, LayoutInfo> m_layoutCache;
+    mutable QHash<QDate, DayLayoutBucket> m_dayLayouts;
+    mutable std::vector<EventLayoutRecord> m_layoutRecords;
+    // Spans of m_spanSource over m_spanDayCount days from m_spanStartDate; those of slot i are
+    // [m_spanOffsets[i], m_spanOffsets[i + 1]).
+    mutable std::vector<SegmentSpan> m_segmentSpans;
+    mutable std::vector<std::size_t> m_spanOffsets;
+    mutable data::EventSnapshot m_spanSource;
+    mutable QDate m_spanStartDate;
+    mutable int m_spanDayCount = 0;
+    mutable QHash<QUuid, std::size_t> m_slotById;
+    // Rebuilt after the layouts or when the geometry the rects were computed with changes.
+    mutable bool m_hitIndexDirty = true;
+    mutable std::array<double, 5> m_hitGeometry{};
+    // In hit order, without the event in front.
+    mutable std::vector<HitEntry> m_hitEntries;
+    mutable std::vector<HitColumn> m_hitColumns;
     QPoint m_lastPointerPos;
     bool m_lastPointerPosValid = false;
     QHash<QString, QColor> m_keywordColors;
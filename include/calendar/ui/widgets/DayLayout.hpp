@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+namespace calendar {
+namespace ui {
+
+// Horizontal placement of an event segment within its day column, as fractions of the width.
+struct EventLayout
+{
+    double offsetFraction = 0.0;
+    double widthFraction = 1.0;
+    enum class Anchor
+    {
+        Left,
+        Right,
+        Center
+    };
+    Anchor anchor = Anchor::Left;
+    // Contained segments are painted and hit above the others.
+    int zPriority = 0;
+};
+
+// Segment of an event within one day column, in minutes since the start of the day.
+struct DaySpan
+{
+    double startMinutes = 0.0;
+    double endMinutes = 0.0;
+
+    bool operator==(const DaySpan &other) const
+    {
+        return startMinutes == other.startMinutes && endMinutes == other.endMinutes;
+    }
+    bool operator!=(const DaySpan &other) const { return !(*this == other); }
+};
+
+// Lays out the segments of one day column; the result has one entry per span, in the same
+// order. Segments with the same range are split side by side, a segment inside another one is
+// narrowed to the right and put on top, and partially overlapping segments are moved apart.
+// Where these rules disagree, the relation with the segment latest in spans decides, exactly as
+// if every pair were compared in order, but in O(n log n). Times are expected on whole seconds.
+std::vector<EventLayout> layoutDayColumn(const std::vector<DaySpan> &spans);
+
+} // namespace ui
+} // namespace calendar
@@ -1,6 +1,8 @@
 #include "calendar/core/AppContext.hpp"
 
 #include "calendar/data/DataProvider.hpp"
+#include "calendar/data/ObservableEventRepository.hpp"
+#include "calendar/data/ObservableTodoRepository.hpp"
 
 #include "calendar/core/UndoStack.hpp"
 
@@ -25,6 +27,11 @@ data::EventRepository &AppContext::eventRepository()
     return m_dataProvider->eventRepository();
 }
 
+data::DataProvider &AppContext::dataProvider()
+{
+    return *m_dataProvider;
+}
+
 UndoStack &AppContext::undoStack()
 {
     return *m_undoStack;
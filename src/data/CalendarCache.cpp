@@ -0,0 +1,260 @@
+#include "calendar/data/CalendarCache.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <limits>
+
+namespace calendar {
+namespace data {
+
+namespace {
+constexpr auto CACHE_SUFFIX = ".bmcache";
+constexpr quint32 CACHE_MAGIC = 0x424d4348; // "BMCH"
+constexpr quint32 CACHE_VERSION = 3;
+constexpr qint64 INVALID_TIMESTAMP = std::numeric_limits<qint64>::min();
+
+struct FileStamp {
+    qint64 size = -1;
+    qint64 modified = INVALID_TIMESTAMP;
+};
+
+FileStamp fileStamp(const QString &icsPath)
+{
+    const QFileInfo info(icsPath);
+    if (!info.exists()) {
+        return {};
+    }
+    FileStamp stamp;
+    stamp.size = info.size();
+    stamp.modified = info.lastModified().toMSecsSinceEpoch();
+    return stamp;
+}
+
+QByteArray hashOf(const QByteArray &contents)
+{
+    return QCryptographicHash::hash(contents, QCryptographicHash::Sha1);
+}
+
+IcsSourceState stateOf(const FileStamp &stamp)
+{
+    IcsSourceState state;
+    state.size = stamp.size;
+    state.modified = stamp.modified;
+    return state;
+}
+
+void prepareStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream.setByteOrder(QDataStream::LittleEndian);
+}
+
+qint64 toTimestamp(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : INVALID_TIMESTAMP;
+}
+
+QDateTime fromTimestamp(qint64 timestamp)
+{
+    return timestamp == INVALID_TIMESTAMP ? QDateTime() : QDateTime::fromMSecsSinceEpoch(timestamp);
+}
+
+void writeEventRef(QDataStream &stream, const IcsEventRef &ref)
+{
+    stream << ref.id << ref.offset << static_cast<qint32>(ref.length) << toTimestamp(ref.start)
+           << toTimestamp(ref.end) << ref.inSeries;
+}
+
+void readEventRef(QDataStream &stream, IcsEventRef &ref)
+{
+    qint32 length = 0;
+    qint64 start = 0;
+    qint64 end = 0;
+    stream >> ref.id >> ref.offset >> length >> start >> end >> ref.inSeries;
+    ref.length = length;
+    ref.start = fromTimestamp(start);
+    ref.end = fromTimestamp(end);
+}
+
+void writeTodo(QDataStream &stream, const TodoItem &todo)
+{
+    stream << todo.id << todo.title << todo.description << todo.location << todo.tags
+           << toTimestamp(todo.dueDate) << static_cast<qint32>(todo.priority)
+           << static_cast<quint8>(todo.status) << todo.scheduled << static_cast<qint32>(todo.durationMinutes);
+}
+
+void readTodo(QDataStream &stream, TodoItem &todo)
+{
+    qint64 due = 0;
+    qint32 priority = 0;
+    quint8 status = 0;
+    qint32 durationMinutes = 0;
+    stream >> todo.id >> todo.title >> todo.description >> todo.location >> todo.tags >> due >> priority
+        >> status >> todo.scheduled >> durationMinutes;
+    todo.dueDate = fromTimestamp(due);
+    todo.priority = priority;
+    todo.status = status <= static_cast<quint8>(TodoStatus::Completed) ? static_cast<TodoStatus>(status)
+                                                                        : TodoStatus::Pending;
+    todo.durationMinutes = durationMinutes;
+}
+} // namespace
+
+QString CalendarCache::cachePathFor(const QString &icsPath)
+{
+    return icsPath + QLatin1String(CACHE_SUFFIX);
+}
+
+IcsSourceState CalendarCache::readSource(const QString &icsPath, QByteArray *contents)
+{
+    contents->clear();
+    const FileStamp before = fileStamp(icsPath);
+    QFile file(icsPath);
+    if (icsPath.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    *contents = file.readAll();
+    file.close();
+    const FileStamp after = fileStamp(icsPath);
+    if (before.size < 0 || after.modified != before.modified || after.size != contents->size()) {
+        return {};
+    }
+    return stateOf(after);
+}
+
+IcsSourceState CalendarCache::writtenSource(const QString &icsPath, const QByteArray &contents)
+{
+    const FileStamp current = fileStamp(icsPath);
+    if (current.size != contents.size()) {
+        return {};
+    }
+    IcsSourceState state = stateOf(current);
+    state.hash = hashOf(contents);
+    return state;
+}
+
+std::optional<CalendarSnapshot> CalendarCache::read(const QString &icsPath)
+{
+    QByteArray contents;
+    const IcsSourceState state = readSource(icsPath, &contents);
+    return read(icsPath, contents, state);
+}
+
+std::optional<CalendarSnapshot> CalendarCache::read(const QString &icsPath,
+                                                    const QByteArray &contents,
+                                                    const IcsSourceState &state)
+{
+    if (!state.isValid() || state.size != contents.size()) {
+        return std::nullopt;
+    }
+
+    QFile file(cachePathFor(icsPath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    // One sequential read; everything after that is decoding from memory.
+    const QByteArray cacheBytes = file.readAll();
+    file.close();
+
+    QDataStream stream(cacheBytes);
+    prepareStream(stream);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 size = 0;
+    qint64 modified = 0;
+    QByteArray hash;
+    quint32 todoCount = 0;
+    quint32 eventCount = 0;
+    stream >> magic >> version >> size >> modified >> hash >> todoCount >> eventCount;
+    if (stream.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION
+        || size != state.size) {
+        return std::nullopt;
+    }
+    // Same size but touched: only the contents can tell whether the cache still applies.
+    if (modified != state.modified && hash != (state.hash.isEmpty() ? hashOf(contents) : state.hash)) {
+        return std::nullopt;
+    }
+    // Every record takes more than one byte, which bounds the counts of a damaged file.
+    const auto byteCount = static_cast<quint32>(cacheBytes.size());
+    if (eventCount > byteCount || todoCount > byteCount) {
+        return std::nullopt;
+    }
+
+    CalendarSnapshot snapshot;
+    snapshot.todos.reserve(static_cast<int>(todoCount));
+    for (quint32 i = 0; i < todoCount; ++i) {
+        TodoItem todo;
+        readTodo(stream, todo);
+        snapshot.todos.insert(todo.id, todo);
+    }
+    snapshot.eventRefs.reserve(static_cast<int>(eventCount));
+    for (quint32 i = 0; i < eventCount; ++i) {
+        IcsEventRef ref;
+        readEventRef(stream, ref);
+        if (ref.offset < 0 || ref.length <= 0 || ref.offset + ref.length > state.size) {
+            return std::nullopt;
+        }
+        snapshot.eventRefs.insert(ref.id, ref);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        return std::nullopt;
+    }
+    return snapshot;
+}
+
+bool CalendarCache::write(const QString &icsPath, const CalendarSnapshot &snapshot, QString *errorString)
+{
+    // The event offsets are only meaningful for the bytes the state was taken from, which may
+    // no longer be what icsPath holds.
+    const IcsSourceState &source = snapshot.sourceState;
+    if (!source.isValid()) {
+        if (errorString) {
+            *errorString = QStringLiteral("%1 was not read or written completely").arg(icsPath);
+        }
+        return false;
+    }
+    QByteArray sourceHash = source.hash;
+    if (sourceHash.isEmpty()) {
+        if (snapshot.source.size() != source.size) {
+            if (errorString) {
+                *errorString = QStringLiteral("The contents of %1 are missing").arg(icsPath);
+            }
+            return false;
+        }
+        sourceHash = hashOf(snapshot.source);
+    }
+
+    QSaveFile file(cachePathFor(icsPath));
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+
+    QDataStream stream(&file);
+    prepareStream(stream);
+    stream << CACHE_MAGIC << CACHE_VERSION << source.size << source.modified << sourceHash
+           << static_cast<quint32>(snapshot.todos.size()) << static_cast<quint32>(snapshot.eventRefs.size());
+    for (auto it = snapshot.todos.constBegin(); it != snapshot.todos.constEnd(); ++it) {
+        writeTodo(stream, it.value());
+    }
+    for (auto it = snapshot.eventRefs.constBegin(); it != snapshot.eventRefs.constEnd(); ++it) {
+        writeEventRef(stream, it.value());
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,253 @@
+#include "calendar/data/CalendarSearch.hpp"
+
+#include "calendar/data/EventRepository.hpp"
+#include "calendar/data/ObservableEventRepository.hpp"
+#include "calendar/data/ObservableTodoRepository.hpp"
+#include "calendar/data/Recurrence.hpp"
+#include "calendar/data/TodoRepository.hpp"
+
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+namespace calendar {
+namespace data {
+
+namespace {
+QString searchableText(const CalendarEvent &event)
+{
+    return event.title + QLatin1Char('\n') + event.description + QLatin1Char('\n') + event.location;
+}
+
+QString searchableText(const TodoItem &todo)
+{
+    return todo.title + QLatin1Char('\n') + todo.description;
+}
+
+// Calls function with future once it has finished, on the thread of context.
+template<typename T, typename Function>
+void whenFinished(QObject *context, const QFuture<T> &future, Function function)
+{
+    auto *watcher = new QFutureWatcher<T>(context);
+    QObject::connect(watcher, &QFutureWatcher<T>::finished, context, [watcher, function]() {
+        watcher->deleteLater();
+        function(watcher->future());
+    });
+    watcher->setFuture(future);
+}
+} // namespace
+
+bool EventMatches::contains(const CalendarEvent &event) const
+{
+    if (!pendingQuery.isEmpty()) {
+        return event.title.contains(pendingQuery, Qt::CaseInsensitive)
+               || event.description.contains(pendingQuery, Qt::CaseInsensitive)
+               || event.location.contains(pendingQuery, Qt::CaseInsensitive);
+    }
+    if (ids.contains(event.id)) {
+        return true;
+    }
+    return !event.seriesId.isNull() && ids.contains(event.seriesId) && !unmatchedOverrides.contains(event.id);
+}
+
+bool TodoMatches::contains(const TodoItem &todo) const
+{
+    if (!pendingQuery.isEmpty()) {
+        return todo.title.contains(pendingQuery, Qt::CaseInsensitive)
+               || todo.description.contains(pendingQuery, Qt::CaseInsensitive);
+    }
+    return ids.contains(todo.id);
+}
+
+CalendarSearch::CalendarSearch(EventRepository &storedEvents,
+                               TodoRepository &storedTodos,
+                               ObservableEventRepository &events,
+                               ObservableTodoRepository &todos,
+                               QObject *parent)
+    : QObject(parent)
+    , m_storedEvents(storedEvents)
+    , m_storedTodos(storedTodos)
+{
+    connect(&events, &ObservableEventRepository::eventsChanged, this, [this](const EventChangeSet &changes) {
+        applyEventChanges(changes);
+    });
+    connect(&todos, &ObservableTodoRepository::todosChanged, this, [this](const TodoChangeSet &changes) {
+        applyTodoChanges(changes);
+    });
+}
+
+CalendarSearch::~CalendarSearch()
+{
+    m_buildToken.cancel();
+}
+
+EventMatches CalendarSearch::matchingEvents(const QString &query)
+{
+    EventMatches matches;
+    if (query.isEmpty()) {
+        return matches;
+    }
+    ensureIndexed();
+    if (m_state != State::Ready) {
+        matches.pendingQuery = query;
+        return matches;
+    }
+    matches.ids = m_index.events.matching(query);
+    for (const QUuid &id : matches.ids) {
+        const auto overrides = m_index.overrides.constFind(id);
+        if (overrides == m_index.overrides.constEnd()) {
+            continue;
+        }
+        for (const QUuid &overrideId : overrides.value()) {
+            if (!matches.ids.contains(overrideId)) {
+                matches.unmatchedOverrides.insert(overrideId);
+            }
+        }
+    }
+    return matches;
+}
+
+TodoMatches CalendarSearch::matchingTodos(const QString &query)
+{
+    TodoMatches matches;
+    if (query.isEmpty()) {
+        return matches;
+    }
+    ensureIndexed();
+    if (m_state != State::Ready) {
+        matches.pendingQuery = query;
+        return matches;
+    }
+    matches.ids = m_index.todos.matching(query);
+    return matches;
+}
+
+bool CalendarSearch::isIndexed() const
+{
+    return m_state == State::Ready;
+}
+
+void CalendarSearch::ensureIndexed()
+{
+    if (m_state != State::NotIndexed) {
+        return;
+    }
+    m_state = State::Building;
+    // The storages read everything they do not hold in memory on worker threads and do not
+    // keep it. Everything is taken as of now; later changes are queued until the index is
+    // installed.
+    const QFuture<EventSnapshot> eventQuery = m_storedEvents.fetchAllEventsAsync(m_buildToken);
+    const QFuture<std::vector<TodoItem>> todoQuery = m_storedTodos.fetchTodosAsync(m_buildToken);
+    whenFinished(this, eventQuery, [this, todoQuery](const QFuture<EventSnapshot> &events) {
+        whenFinished(this, todoQuery, [this, events](const QFuture<std::vector<TodoItem>> &todos) {
+            const EventSnapshot snapshot = events.resultCount() > 0 ? events.result() : EventSnapshot();
+            const std::vector<TodoItem> todoItems = todos.resultCount() > 0 ? todos.result()
+                                                                            : std::vector<TodoItem>();
+            const QFuture<Index> index = QtConcurrent::run([snapshot, todoItems]() {
+                Index result;
+                for (const EventHandle &event : snapshot.handles()) {
+                    indexEvent(result, *event);
+                }
+                for (const TodoItem &todo : todoItems) {
+                    result.todos.insert(todo.id, searchableText(todo));
+                }
+                return result;
+            });
+            whenFinished(this, index, [this](const QFuture<Index> &index) { install(index.result()); });
+        });
+    });
+}
+
+void CalendarSearch::install(Index index)
+{
+    m_index = std::move(index);
+    m_state = State::Ready;
+    std::vector<EventChangeSet> eventChanges;
+    std::vector<TodoChangeSet> todoChanges;
+    eventChanges.swap(m_pendingEventChanges);
+    todoChanges.swap(m_pendingTodoChanges);
+    for (const EventChangeSet &changes : eventChanges) {
+        applyEventChanges(changes);
+    }
+    for (const TodoChangeSet &changes : todoChanges) {
+        applyTodoChanges(changes);
+    }
+    emit indexReady();
+}
+
+void CalendarSearch::indexEvent(Index &index, const CalendarEvent &event)
+{
+    index.events.insert(event.id, searchableText(event));
+    if (Recurrence::isOverride(event)) {
+        index.overrides[event.seriesId].insert(event.id);
+    }
+}
+
+void CalendarSearch::unindexEvent(Index &index, const CalendarEvent &event)
+{
+    index.events.remove(event.id);
+    if (Recurrence::isOverride(event)) {
+        const auto overrides = index.overrides.find(event.seriesId);
+        if (overrides != index.overrides.end()) {
+            overrides.value().remove(event.id);
+            if (overrides.value().isEmpty()) {
+                index.overrides.erase(overrides);
+            }
+        }
+    }
+    // Removing a series removes its overrides without reporting them.
+    const auto overrides = index.overrides.constFind(event.id);
+    if (overrides != index.overrides.constEnd()) {
+        for (const QUuid &overrideId : overrides.value()) {
+            index.events.remove(overrideId);
+        }
+        index.overrides.erase(overrides);
+    }
+}
+
+void CalendarSearch::applyEventChanges(const EventChangeSet &changes)
+{
+    if (m_state == State::Building) {
+        m_pendingEventChanges.push_back(changes);
+        return;
+    }
+    if (m_state != State::Ready) {
+        return;
+    }
+    for (const CalendarEvent &event : changes.removed) {
+        unindexEvent(m_index, event);
+    }
+    for (const auto &update : changes.updated) {
+        // Only the series an override belongs to needs to be forgotten; the text is replaced.
+        if (Recurrence::isOverride(update.before) != Recurrence::isOverride(update.after)
+            || update.before.seriesId != update.after.seriesId) {
+            unindexEvent(m_index, update.before);
+        }
+        indexEvent(m_index, update.after);
+    }
+    for (const CalendarEvent &event : changes.inserted) {
+        indexEvent(m_index, event);
+    }
+}
+
+void CalendarSearch::applyTodoChanges(const TodoChangeSet &changes)
+{
+    if (m_state == State::Building) {
+        m_pendingTodoChanges.push_back(changes);
+        return;
+    }
+    if (m_state != State::Ready) {
+        return;
+    }
+    for (const TodoItem &todo : changes.removed) {
+        m_index.todos.remove(todo.id);
+    }
+    for (const auto &update : changes.updated) {
+        m_index.todos.insert(update.after.id, searchableText(update.after));
+    }
+    for (const TodoItem &todo : changes.inserted) {
+        m_index.todos.insert(todo.id, searchableText(todo));
+    }
+}
+
+} // namespace data
+} // namespace calendar
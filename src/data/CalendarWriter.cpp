@@ -0,0 +1,266 @@
+#include "calendar/data/CalendarWriter.hpp"
+
+#include "calendar/data/CalendarCache.hpp"
+#include "calendar/data/IcsWriter.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QTimer>
+
+namespace calendar {
+namespace data {
+
+CalendarWriter::CalendarWriter(QString filePath,
+                               QString journalPath,
+                               int coalescingInterval,
+                               QObject *parent)
+    : QObject(parent)
+    , m_filePath(std::move(filePath))
+    , m_journalPath(std::move(journalPath))
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(qMax(0, coalescingInterval));
+    connect(m_timer, &QTimer::timeout, this, &CalendarWriter::writePending);
+}
+
+CalendarWriter::~CalendarWriter() = default;
+
+void CalendarWriter::setCoalescingInterval(int msecs)
+{
+    QMetaObject::invokeMethod(
+        this, [this, msecs]() { m_timer->setInterval(qMax(0, msecs)); }, Qt::QueuedConnection);
+}
+
+void CalendarWriter::appendJournal(const QByteArray &records)
+{
+    if (records.isEmpty()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingJournal += records;
+    }
+    schedule();
+}
+
+void CalendarWriter::writeSnapshot(CalendarSnapshot snapshot)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // The snapshot already contains every queued journal record. They are only kept
+        // around in case writing the snapshot fails.
+        m_journalBeforeSnapshot += m_pendingJournal;
+        m_pendingJournal.clear();
+        m_pendingSnapshot = std::move(snapshot);
+        m_pendingCache.reset();
+    }
+    schedule();
+}
+
+void CalendarWriter::writeCache(CalendarSnapshot snapshot)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pendingSnapshot.has_value()) {
+            return;
+        }
+        m_pendingCache = std::move(snapshot);
+    }
+    schedule();
+}
+
+void CalendarWriter::writeShards(QHash<QString, CalendarSnapshot> shards,
+                                 QHash<QString, CalendarSnapshot> followUps,
+                                 const QString &indexPath,
+                                 const QByteArray &index)
+{
+    if (shards.isEmpty() && followUps.isEmpty() && indexPath.isEmpty()) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        // Newer contents may join the last queued pass: everything before it still goes first.
+        if (m_pendingShards.empty()) {
+            m_pendingShards.emplace_back();
+        }
+        QHash<QString, CalendarSnapshot> &last = m_pendingShards.back();
+        for (auto it = shards.begin(); it != shards.end(); ++it) {
+            last.insert(it.key(), std::move(it.value()));
+        }
+        if (!followUps.isEmpty()) {
+            m_pendingShards.push_back(std::move(followUps));
+        }
+        if (!indexPath.isEmpty()) {
+            m_pendingIndexPath = indexPath;
+            m_pendingIndex = index;
+        }
+    }
+    schedule();
+}
+
+void CalendarWriter::flush()
+{
+    if (QThread::currentThread() == thread() || !thread()->isRunning()) {
+        m_timer->stop();
+        writePending();
+        return;
+    }
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            m_timer->stop();
+            writePending();
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+void CalendarWriter::schedule()
+{
+    markBusy();
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            if (!m_timer->isActive()) {
+                m_timer->start();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void CalendarWriter::writePending()
+{
+    std::optional<CalendarSnapshot> snapshot;
+    std::optional<CalendarSnapshot> cache;
+    std::vector<QHash<QString, CalendarSnapshot>> shards;
+    QString indexPath;
+    QByteArray index;
+    QByteArray journalBeforeSnapshot;
+    QByteArray journal;
+    {
+        QMutexLocker locker(&m_mutex);
+        snapshot.swap(m_pendingSnapshot);
+        cache.swap(m_pendingCache);
+        shards.swap(m_pendingShards);
+        indexPath.swap(m_pendingIndexPath);
+        index.swap(m_pendingIndex);
+        journalBeforeSnapshot.swap(m_journalBeforeSnapshot);
+        journal.swap(m_pendingJournal);
+    }
+
+    QString errorString;
+    bool success = true;
+    if (snapshot.has_value()) {
+        QHash<QUuid, IcsEventRef> writtenEvents;
+        IcsSourceState writtenState;
+        if (IcsWriter::writeCalendar(m_filePath, *snapshot, &errorString, &writtenEvents, &writtenState)) {
+            QFile::remove(m_journalPath);
+            cache = CalendarSnapshot{{}, snapshot->todos, writtenEvents, {}, writtenState};
+        } else {
+            success = false;
+            journal.prepend(journalBeforeSnapshot);
+            cache.reset();
+        }
+    }
+    // The cache is only an accelerator; if it cannot be written the next start parses the ICS file.
+    if (cache.has_value() && !CalendarCache::write(m_filePath, *cache)) {
+        QFile::remove(CalendarCache::cachePathFor(m_filePath));
+    }
+    for (const QHash<QString, CalendarSnapshot> &pass : shards) {
+        // A later pass may drop events that only a file of this one has now.
+        if (!success) {
+            break;
+        }
+        for (auto it = pass.constBegin(); it != pass.constEnd(); ++it) {
+            const CalendarSnapshot &shard = it.value();
+            if (shard.events.isEmpty() && shard.todos.isEmpty()) {
+                if (QFile::exists(it.key()) && !QFile::remove(it.key())) {
+                    success = false;
+                    errorString = QStringLiteral("%1 could not be removed").arg(it.key());
+                }
+                continue;
+            }
+            QString shardError;
+            if (!IcsWriter::writeCalendar(it.key(), shard, &shardError)) {
+                success = false;
+                errorString = shardError;
+            }
+        }
+    }
+    if (!indexPath.isEmpty()) {
+        QSaveFile indexFile(indexPath);
+        if (!indexFile.open(QIODevice::WriteOnly) || indexFile.write(index) != index.size()
+            || !indexFile.commit()) {
+            success = false;
+            errorString = indexFile.errorString();
+        }
+    }
+    if (!journal.isEmpty()) {
+        QString journalError;
+        if (!appendToJournalFile(journal, &journalError)) {
+            success = false;
+            errorString = journalError;
+        }
+    }
+    if (!success) {
+        emit writeFailed(errorString);
+    }
+
+    bool becameIdle = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_busy && !m_pendingSnapshot.has_value() && !m_pendingCache.has_value()
+            && m_pendingShards.empty() && m_pendingIndexPath.isEmpty() && m_pendingJournal.isEmpty()) {
+            m_busy = false;
+            becameIdle = true;
+        }
+    }
+    if (becameIdle) {
+        emit busyChanged(false);
+    }
+}
+
+bool CalendarWriter::appendToJournalFile(const QByteArray &records, QString *errorString) const
+{
+    QFileInfo info(m_journalPath);
+    QDir dir = info.dir();
+    if (!dir.exists()) {
+        dir.mkpath(QStringLiteral("."));
+    }
+
+    QFile journal(m_journalPath);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        *errorString = journal.errorString();
+        return false;
+    }
+    if (journal.write(records) != records.size() || !journal.flush()) {
+        *errorString = journal.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool CalendarWriter::isBusy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_busy;
+}
+
+void CalendarWriter::markBusy()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_busy) {
+            return;
+        }
+        m_busy = true;
+    }
+    emit busyChanged(true);
+}
+
+} // namespace data
+} // namespace calendar
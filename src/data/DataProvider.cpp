@@ -1,16 +1,50 @@
 #include "calendar/data/DataProvider.hpp"
 
+#include "calendar/data/CalendarSearch.hpp"
 #include "calendar/data/FileCalendarStorage.hpp"
 #include "calendar/data/FileEventRepository.hpp"
 #include "calendar/data/FileTodoRepository.hpp"
+#include "calendar/data/ObservableEventRepository.hpp"
+#include "calendar/data/ObservableTodoRepository.hpp"
+#include "calendar/data/RecurringEventRepository.hpp"
+#include "calendar/data/RepositoryBatch.hpp"
+#include "calendar/data/SqliteDatabase.hpp"
+#include "calendar/data/SqliteEventRepository.hpp"
+#include "calendar/data/SqliteTodoRepository.hpp"
 #include "calendar/data/TodoRepository.hpp"
 
 #include <QDir>
+#include <QFileInfo>
+#include <QSettings>
 #include <QStandardPaths>
 
 namespace calendar {
 namespace data {
 
+namespace {
+constexpr auto BACKEND_SETTING = "storage/backend";
+constexpr auto SQLITE_BACKEND = "sqlite";
+constexpr auto MONTHLY_BACKEND = "monthly";
+
+// Copies the calendar of an existing single-file storage into freshly created repositories.
+// Going through the storage instead of IcsExchange also picks up uncompacted journal records.
+void seedFromIcs(const QString &icsPath, EventRepository &events, TodoRepository &todos)
+{
+    if (!QFileInfo::exists(icsPath)) {
+        return;
+    }
+    const FileCalendarStorage legacy(icsPath);
+    RepositoryBatch batch(events, todos);
+    const QHash<QUuid, CalendarEvent> allEvents = legacy.allEvents();
+    for (auto it = allEvents.constBegin(); it != allEvents.constEnd(); ++it) {
+        events.addEvent(it.value());
+    }
+    for (auto it = legacy.todos().constBegin(); it != legacy.todos().constEnd(); ++it) {
+        todos.addTodo(it.value());
+    }
+}
+} // namespace
+
 DataProvider::DataProvider()
 {
     QString storageFolder = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
@@ -21,24 +55,101 @@ DataProvider::DataProvider()
     if (!dir.exists()) {
         dir.mkpath(QStringLiteral("."));
     }
+    openBackend(dir);
+    // Everything above the data layer goes through these, so every change gets reported and
+    // recurring events are seen as their occurrences.
+    m_observableTodos = std::make_unique<ObservableTodoRepository>(*m_todoRepository);
+    m_recurringEvents = std::make_unique<RecurringEventRepository>(*m_eventRepository);
+    m_observableEvents = std::make_unique<ObservableEventRepository>(*m_recurringEvents);
+    if (m_calendarStorage) {
+        QObject::connect(m_calendarStorage.get(),
+                         &FileCalendarStorage::eventsChangedExternally,
+                         m_observableEvents.get(),
+                         &ObservableEventRepository::publishChanges);
+        QObject::connect(m_calendarStorage.get(),
+                         &FileCalendarStorage::todosChangedExternally,
+                         m_observableTodos.get(),
+                         &ObservableTodoRepository::publishChanges);
+    }
+    // Connected before any view, so views that search again on a change see the updated index.
+    m_search = std::make_unique<CalendarSearch>(*m_eventRepository,
+                                                *m_todoRepository,
+                                                *m_observableEvents,
+                                                *m_observableTodos);
+}
+
+DataProvider::~DataProvider()
+{
+    // Make sure everything queued for the writer thread reaches the disk before exit.
+    if (m_calendarStorage) {
+        m_calendarStorage->flush();
+    }
+}
+
+void DataProvider::openBackend(const QDir &dir)
+{
     const QString filePath = dir.filePath(QStringLiteral("default.ics"));
 
+    QSettings settings;
+    const QString backend = settings.value(QLatin1String(BACKEND_SETTING)).toString();
+    if (backend == QLatin1String(SQLITE_BACKEND)
+        && openSqliteBackend(dir.filePath(QStringLiteral("default.sqlite")), filePath)) {
+        return;
+    }
+
+    if (backend == QLatin1String(MONTHLY_BACKEND)) {
+        const QString shardFolder = dir.filePath(QStringLiteral("default"));
+        const bool created = !QFileInfo::exists(shardFolder);
+        m_calendarStorage =
+            std::make_shared<FileCalendarStorage>(shardFolder, FileCalendarStorage::Layout::Monthly);
+        m_todoRepository = std::make_unique<FileTodoRepository>(m_calendarStorage);
+        m_eventRepository = std::make_unique<FileEventRepository>(m_calendarStorage);
+        if (created) {
+            seedFromIcs(filePath, *m_eventRepository, *m_todoRepository);
+        }
+        return;
+    }
+
     m_calendarStorage = std::make_shared<FileCalendarStorage>(filePath);
     m_todoRepository = std::make_unique<FileTodoRepository>(m_calendarStorage);
     m_eventRepository = std::make_unique<FileEventRepository>(m_calendarStorage);
+}
+
+bool DataProvider::openSqliteBackend(const QString &databasePath, const QString &icsPath)
+{
+    const bool created = !QFileInfo::exists(databasePath);
+    auto database = std::make_shared<SqliteDatabase>(databasePath);
+    if (!database->isOpen()) {
+        // Keep working with the ICS file rather than starting without any data.
+        return false;
+    }
+    m_database = database;
+    m_todoRepository = std::make_unique<SqliteTodoRepository>(m_database);
+    m_eventRepository = std::make_unique<SqliteEventRepository>(m_database);
+    if (created) {
+        seedFromIcs(icsPath, *m_eventRepository, *m_todoRepository);
+    }
+    return true;
+}
 
+ObservableTodoRepository &DataProvider::todoRepository()
+{
+    return *m_observableTodos;
 }
 
-DataProvider::~DataProvider() = default;
+ObservableEventRepository &DataProvider::eventRepository()
+{
+    return *m_observableEvents;
+}
 
-TodoRepository &DataProvider::todoRepository()
+FileCalendarStorage *DataProvider::calendarStorage()
 {
-    return *m_todoRepository;
+    return m_calendarStorage.get();
 }
 
-EventRepository &DataProvider::eventRepository()
+CalendarSearch &DataProvider::search()
 {
-    return *m_eventRepository;
+    return *m_search;
 }
 
 } // namespace data
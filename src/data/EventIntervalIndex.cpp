@@ -0,0 +1,172 @@
+#include "calendar/data/EventIntervalIndex.hpp"
+
+#include <algorithm>
+
+namespace calendar {
+namespace data {
+
+void EventIntervalIndex::insert(const QUuid &id, qint64 start, qint64 end)
+{
+    remove(id);
+
+    int nodeIndex = -1;
+    if (!m_freeNodes.empty()) {
+        nodeIndex = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    } else {
+        nodeIndex = static_cast<int>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    Node &node = m_nodes[static_cast<size_t>(nodeIndex)];
+    node.start = start;
+    node.end = end;
+    node.maxEnd = end;
+    node.id = id;
+    node.priority = nextPriority();
+    node.left = -1;
+    node.right = -1;
+
+    int left = -1;
+    int right = -1;
+    split(m_root, m_nodes[static_cast<size_t>(nodeIndex)], false, left, right);
+    m_root = merge(merge(left, nodeIndex), right);
+    m_nodeById.insert(id, nodeIndex);
+}
+
+bool EventIntervalIndex::remove(const QUuid &id)
+{
+    const auto it = m_nodeById.constFind(id);
+    if (it == m_nodeById.constEnd()) {
+        return false;
+    }
+    const int nodeIndex = it.value();
+    m_nodeById.erase(it);
+
+    const Node key = m_nodes[static_cast<size_t>(nodeIndex)];
+    int left = -1;
+    int rest = -1;
+    split(m_root, key, false, left, rest);
+    int match = -1;
+    int right = -1;
+    split(rest, key, true, match, right);
+    m_root = merge(left, right);
+
+    m_freeNodes.push_back(nodeIndex);
+    return true;
+}
+
+void EventIntervalIndex::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_nodeById.clear();
+    m_root = -1;
+}
+
+int EventIntervalIndex::size() const
+{
+    return m_nodeById.size();
+}
+
+std::vector<QUuid> EventIntervalIndex::overlapping(qint64 from, qint64 to) const
+{
+    std::vector<QUuid> result;
+    collect(m_root, from, to, result);
+    return result;
+}
+
+bool EventIntervalIndex::lessThan(const Node &node, qint64 start, qint64 end, const QUuid &id) const
+{
+    if (node.start != start) {
+        return node.start < start;
+    }
+    if (node.end != end) {
+        return node.end < end;
+    }
+    return node.id < id;
+}
+
+void EventIntervalIndex::update(int nodeIndex)
+{
+    Node &node = m_nodes[static_cast<size_t>(nodeIndex)];
+    node.maxEnd = node.end;
+    if (node.left >= 0) {
+        node.maxEnd = std::max(node.maxEnd, m_nodes[static_cast<size_t>(node.left)].maxEnd);
+    }
+    if (node.right >= 0) {
+        node.maxEnd = std::max(node.maxEnd, m_nodes[static_cast<size_t>(node.right)].maxEnd);
+    }
+}
+
+// Splits the subtree into nodes ordered before the key (left) and the remaining ones
+// (right). With keyGoesLeft, a node equal to the key ends up on the left side.
+void EventIntervalIndex::split(int nodeIndex, const Node &key, bool keyGoesLeft, int &left, int &right)
+{
+    if (nodeIndex < 0) {
+        left = -1;
+        right = -1;
+        return;
+    }
+    Node &node = m_nodes[static_cast<size_t>(nodeIndex)];
+    const bool goesLeft = lessThan(node, key.start, key.end, key.id)
+                          || (keyGoesLeft && node.id == key.id);
+    if (goesLeft) {
+        split(node.right, key, keyGoesLeft, node.right, right);
+        left = nodeIndex;
+    } else {
+        split(node.left, key, keyGoesLeft, left, node.left);
+        right = nodeIndex;
+    }
+    update(nodeIndex);
+}
+
+int EventIntervalIndex::merge(int left, int right)
+{
+    if (left < 0) {
+        return right;
+    }
+    if (right < 0) {
+        return left;
+    }
+    Node &leftNode = m_nodes[static_cast<size_t>(left)];
+    Node &rightNode = m_nodes[static_cast<size_t>(right)];
+    if (leftNode.priority > rightNode.priority) {
+        leftNode.right = merge(leftNode.right, right);
+        update(left);
+        return left;
+    }
+    rightNode.left = merge(left, rightNode.left);
+    update(right);
+    return right;
+}
+
+void EventIntervalIndex::collect(int nodeIndex, qint64 from, qint64 to, std::vector<QUuid> &result) const
+{
+    if (nodeIndex < 0) {
+        return;
+    }
+    const Node &node = m_nodes[static_cast<size_t>(nodeIndex)];
+    if (node.maxEnd < from) {
+        return;
+    }
+    collect(node.left, from, to, result);
+    if (node.start > to) {
+        return;
+    }
+    if (node.end >= from) {
+        result.push_back(node.id);
+    }
+    collect(node.right, from, to, result);
+}
+
+quint32 EventIntervalIndex::nextPriority()
+{
+    // xorshift32; the treap only needs well-distributed, not unpredictable, priorities.
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+} // namespace data
+} // namespace calendar
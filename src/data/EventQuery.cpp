@@ -0,0 +1,54 @@
+#include "calendar/data/EventQuery.hpp"
+
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+namespace calendar {
+namespace data {
+
+CancellationToken::CancellationToken()
+    : m_cancelled(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+void CancellationToken::cancel()
+{
+    m_cancelled->store(true);
+}
+
+bool CancellationToken::isCancelled() const
+{
+    return m_cancelled->load();
+}
+
+QFuture<EventSnapshot> finishedEventQuery(EventSnapshot snapshot)
+{
+    QFutureInterface<EventSnapshot> result;
+    result.reportStarted();
+    result.reportResult(snapshot);
+    result.reportFinished();
+    return result.future();
+}
+
+QFuture<EventSnapshot> continueEventQuery(const QFuture<EventSnapshot> &query,
+                                         std::function<EventSnapshot(const EventSnapshot &)> next)
+{
+    QFutureInterface<EventSnapshot> result;
+    result.reportStarted();
+    auto *watcher = new QFutureWatcher<EventSnapshot>();
+    QObject::connect(watcher, &QFutureWatcher<EventSnapshot>::finished, watcher, [watcher, result, next]() {
+        watcher->deleteLater();
+        const QFuture<EventSnapshot> finished = watcher->future();
+        const EventSnapshot stored = finished.resultCount() > 0 ? finished.result() : EventSnapshot();
+        QtConcurrent::run([result, next, stored]() mutable {
+            result.reportResult(next(stored));
+            result.reportFinished();
+        });
+    });
+    watcher->setFuture(query);
+    return result.future();
+}
+
+} // namespace data
+} // namespace calendar
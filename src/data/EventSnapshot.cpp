@@ -0,0 +1,92 @@
+#include "calendar/data/EventSnapshot.hpp"
+
+namespace calendar {
+namespace data {
+
+namespace {
+const std::vector<EventHandle> &emptyHandles()
+{
+    static const std::vector<EventHandle> handles;
+    return handles;
+}
+} // namespace
+
+EventSnapshot::EventSnapshot(std::vector<EventHandle> events)
+    : m_events(std::make_shared<const std::vector<EventHandle>>(std::move(events)))
+{
+}
+
+EventSnapshot EventSnapshot::fromEvents(std::vector<CalendarEvent> events)
+{
+    std::vector<EventHandle> handles;
+    handles.reserve(events.size());
+    for (CalendarEvent &event : events) {
+        handles.push_back(std::make_shared<const CalendarEvent>(std::move(event)));
+    }
+    return EventSnapshot(std::move(handles));
+}
+
+bool EventSnapshot::empty() const
+{
+    return handles().empty();
+}
+
+std::size_t EventSnapshot::size() const
+{
+    return handles().size();
+}
+
+const CalendarEvent &EventSnapshot::operator[](std::size_t index) const
+{
+    return *handles()[index];
+}
+
+const CalendarEvent &EventSnapshot::front() const
+{
+    return *handles().front();
+}
+
+const CalendarEvent &EventSnapshot::back() const
+{
+    return *handles().back();
+}
+
+EventSnapshot::const_iterator EventSnapshot::begin() const
+{
+    return const_iterator(handles().begin());
+}
+
+EventSnapshot::const_iterator EventSnapshot::end() const
+{
+    return const_iterator(handles().end());
+}
+
+const std::vector<EventHandle> &EventSnapshot::handles() const
+{
+    return m_events ? *m_events : emptyHandles();
+}
+
+EventSnapshot EventSnapshot::withReplaced(CalendarEvent event) const
+{
+    std::vector<EventHandle> result = handles();
+    for (EventHandle &handle : result) {
+        if (handle->id == event.id) {
+            handle = std::make_shared<const CalendarEvent>(std::move(event));
+            return EventSnapshot(std::move(result));
+        }
+    }
+    return *this;
+}
+
+std::vector<CalendarEvent> EventSnapshot::toVector() const
+{
+    std::vector<CalendarEvent> result;
+    result.reserve(size());
+    for (const EventHandle &handle : handles()) {
+        result.push_back(*handle);
+    }
+    return result;
+}
+
+} // namespace data
+} // namespace calendar
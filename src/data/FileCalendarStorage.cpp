@@ -1,57 +1,221 @@
 #include "calendar/data/FileCalendarStorage.hpp"
 
+#include "calendar/data/CalendarCache.hpp"
+#include "calendar/data/CalendarWriter.hpp"
+#include "calendar/data/IcsParser.hpp"
+#include "calendar/data/IcsWriter.hpp"
+#include "calendar/data/Recurrence.hpp"
+
 #include <QDate>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
-#include <QSaveFile>
-#include <QTextStream>
-#include <QTime>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent>
 #include <algorithm>
 
 namespace calendar {
 namespace data {
 
 namespace {
-constexpr auto DATE_FORMAT = "yyyyMMdd";
-constexpr auto DATE_TIME_FORMAT = "yyyyMMdd'T'hhmmss'Z'";
+constexpr auto JOURNAL_SUFFIX = ".journal";
+// Number of journal records after which the journal is folded back into the ICS file.
+constexpr int JOURNAL_COMPACTION_THRESHOLD = 256;
+constexpr int DEFAULT_WRITE_COALESCING_INTERVAL_MS = 250;
+constexpr int DEFAULT_MATERIALIZED_EVENT_BUDGET = 2000;
+constexpr auto SPANNING_SHARD = "spanning.ics";
+constexpr auto TODO_SHARD = "todos.ics";
+constexpr auto SHARD_INDEX = "shards.index";
+// Month of the events in the spanning file in the shard index.
+constexpr auto SPANNING_INDEX_ENTRY = "spanning";
+// Other programs often write a file in several steps; wait for them to settle before reading.
+constexpr int EXTERNAL_RELOAD_DELAY_MS = 200;
 
 QString prepareUid(const QUuid &id)
 {
     return id.toString(QUuid::WithoutBraces);
 }
 
-QUuid parseUid(const QString &value)
+QHash<QUuid, EventHandle> toHandles(QHash<QUuid, CalendarEvent> events)
+{
+    QHash<QUuid, EventHandle> handles;
+    handles.reserve(events.size());
+    for (auto it = events.begin(); it != events.end(); ++it) {
+        handles.insert(it.key(), std::make_shared<const CalendarEvent>(std::move(it.value())));
+    }
+    return handles;
+}
+
+// Events belong to the month they start in. Events that reach into another month go to the
+// spanning file instead, so a range query never has to read months before its start.
+QDate shardMonthFor(const CalendarEvent &event)
 {
-    const QString withBraces = QStringLiteral("{%1}").arg(value);
-    QUuid id(withBraces);
-    if (id.isNull()) {
-        return QUuid::createUuid();
+    // Series may have occurrences in any month, so they are kept with the spanning events,
+    // which are always loaded.
+    if (!event.start.isValid() || !event.end.isValid() || Recurrence::belongsToSeries(event)) {
+        return {};
+    }
+    const QDate start = event.start.date();
+    const QDate end = event.end.date();
+    if (start.year() != end.year() || start.month() != end.month()) {
+        return {};
     }
-    return id;
+    return QDate(start.year(), start.month(), 1);
 }
 
-QStringList splitList(const QString &value)
+std::optional<CalendarEvent> parseReference(const QByteArray &source, const IcsEventRef &ref)
 {
-    const QStringList parts = value.split(',', Qt::SkipEmptyParts);
-    QStringList cleaned;
-    cleaned.reserve(parts.size());
-    for (const QString &part : parts) {
-        cleaned << part.trimmed();
+    if (ref.offset < 0 || ref.offset + ref.length > source.size()) {
+        return std::nullopt;
     }
-    return cleaned;
+    auto event = IcsParser::parseEvent(source.constData() + ref.offset, ref.length);
+    if (event) {
+        event->id = ref.id;
+    }
+    return event;
 }
+
+// Replays journal records into a collector and remembers which items they touched.
+class JournalReplay : public IcsParser::Handler
+{
+public:
+    JournalReplay(IcsParser::Collector &collector, QSet<QUuid> &ids)
+        : m_collector(collector)
+        , m_ids(ids)
+    {
+    }
+
+    void eventParsed(CalendarEvent event) override
+    {
+        m_ids.insert(event.id);
+        m_collector.eventParsed(std::move(event));
+    }
+
+    void todoParsed(TodoItem todo) override
+    {
+        m_ids.insert(todo.id);
+        m_collector.todoParsed(std::move(todo));
+    }
+
+    void eventRemoved(const QUuid &id) override
+    {
+        m_ids.insert(id);
+        m_collector.eventRemoved(id);
+    }
+
+    void todoRemoved(const QUuid &id) override
+    {
+        m_ids.insert(id);
+        m_collector.todoRemoved(id);
+    }
+
+private:
+    IcsParser::Collector &m_collector;
+    QSet<QUuid> &m_ids;
+};
 } // namespace
 
-FileCalendarStorage::FileCalendarStorage(QString filePath)
-    : m_filePath(std::move(filePath))
+// Result of indexing the ICS file after it was changed by another program.
+struct FileCalendarStorage::ExternalState {
+    QByteArray source;
+    IcsParser::Collector contents;
+    // False if the file could not be read or was caught in the middle of being written.
+    bool complete = false;
+};
+
+FileCalendarStorage::FileCalendarStorage(QString filePath, QObject *parent)
+    : FileCalendarStorage(std::move(filePath), Layout::SingleFile, parent)
+{
+}
+
+FileCalendarStorage::FileCalendarStorage(QString filePath, Layout layout, QObject *parent)
+    : QObject(parent)
+    , m_filePath(std::move(filePath))
+    , m_layout(layout)
+    , m_materializedEventBudget(DEFAULT_MATERIALIZED_EVENT_BUDGET)
+    , m_writeCoalescingInterval(DEFAULT_WRITE_COALESCING_INTERVAL_MS)
 {
     load();
+    if (m_layout == Layout::SingleFile && !m_filePath.isEmpty()) {
+        watchFile();
+    }
 }
 
-const QHash<QUuid, CalendarEvent> &FileCalendarStorage::events() const
+FileCalendarStorage::~FileCalendarStorage()
 {
-    return m_events;
+    if (m_layout == Layout::Monthly) {
+        if (m_journalNeedsCompaction) {
+            compact();
+        } else {
+            writeDirtyShards();
+        }
+    } else if (m_journalRecords > 0 || m_pendingRecords > 0) {
+        compact();
+    }
+    if (m_writer) {
+        m_writer->flush();
+        m_writerThread->quit();
+        m_writerThread->wait();
+    }
+}
+
+std::optional<CalendarEvent> FileCalendarStorage::event(const QUuid &id) const
+{
+    EventHandle event = materialize(id);
+    if (!event && loadShardOf(id)) {
+        event = materialize(id);
+    }
+    if (!event) {
+        return std::nullopt;
+    }
+    CalendarEvent result = *event;
+    evictColdEvents();
+    return result;
+}
+
+bool FileCalendarStorage::containsEvent(const QUuid &id) const
+{
+    if (m_events.contains(id) || m_eventRefs.contains(id)) {
+        return true;
+    }
+    return loadShardOf(id) && m_events.contains(id);
+}
+
+int FileCalendarStorage::eventCount() const
+{
+    if (m_layout == Layout::Monthly && m_shardIndexComplete) {
+        // Every event is in the shard index, whether its month has been read or not.
+        return m_indexedShards.size();
+    }
+    loadAllShards();
+    return m_eventRefs.size() + m_events.size() - m_eventAccess.size();
+}
+
+QHash<QUuid, CalendarEvent> FileCalendarStorage::allEvents() const
+{
+    loadAllShards();
+    QHash<QUuid, CalendarEvent> events;
+    events.reserve(m_events.size() + m_eventRefs.size());
+    for (auto it = m_events.constBegin(); it != m_events.constEnd(); ++it) {
+        events.insert(it.key(), *it.value());
+    }
+    for (auto it = m_eventRefs.constBegin(); it != m_eventRefs.constEnd(); ++it) {
+        if (events.contains(it.key())) {
+            continue;
+        }
+        const IcsEventRef &ref = it.value();
+        if (ref.offset + ref.length > m_source.size()) {
+            continue;
+        }
+        if (auto event = IcsParser::parseEvent(m_source.constData() + ref.offset, ref.length)) {
+            event->id = ref.id;
+            events.insert(ref.id, *event);
+        }
+    }
+    return events;
 }
 
 const QHash<QUuid, TodoItem> &FileCalendarStorage::todos() const
@@ -59,6 +223,195 @@ const QHash<QUuid, TodoItem> &FileCalendarStorage::todos() const
     return m_todos;
 }
 
+std::vector<TodoItem> FileCalendarStorage::orderedTodos() const
+{
+    std::vector<TodoItem> result;
+    result.reserve(static_cast<size_t>(m_todos.size()));
+    for (const QUuid &id : m_todoOrder.ids()) {
+        result.push_back(m_todos.value(id));
+    }
+    return result;
+}
+
+std::vector<CalendarEvent> FileCalendarStorage::eventsInRange(const QDate &from, const QDate &to) const
+{
+    return eventSnapshot(from, to).toVector();
+}
+
+EventSnapshot FileCalendarStorage::eventSnapshot(const QDate &from, const QDate &to) const
+{
+    if (!from.isValid() || !to.isValid()) {
+        return {};
+    }
+    loadShardsInRange(from, to);
+    const qint64 fromMs = from.startOfDay().toMSecsSinceEpoch();
+    const qint64 toMs = to.addDays(1).startOfDay().toMSecsSinceEpoch() - 1;
+    const auto ids = m_eventIndex.overlapping(fromMs, toMs);
+    std::vector<EventHandle> result;
+    result.reserve(ids.size());
+    for (const QUuid &id : ids) {
+        if (EventHandle event = materialize(id)) {
+            result.push_back(std::move(event));
+        }
+    }
+    evictColdEvents();
+    return EventSnapshot(std::move(result));
+}
+
+QFuture<EventSnapshot> FileCalendarStorage::eventSnapshotAsync(const QDate &from,
+                                                              const QDate &to,
+                                                              const CancellationToken &token) const
+{
+    if (!from.isValid() || !to.isValid() || token.isCancelled()) {
+        return finishedEventQuery({});
+    }
+    loadShardsInRange(from, to);
+    const qint64 fromMs = from.startOfDay().toMSecsSinceEpoch();
+    const qint64 toMs = to.addDays(1).startOfDay().toMSecsSinceEpoch() - 1;
+    const auto ids = m_eventIndex.overlapping(fromMs, toMs);
+    std::vector<EventHandle> events(ids.size());
+    std::vector<std::pair<size_t, IcsEventRef>> pending;
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const auto event = m_events.constFind(ids[i]);
+        if (event != m_events.constEnd()) {
+            const auto access = m_eventAccess.find(ids[i]);
+            if (access != m_eventAccess.end()) {
+                access.value() = ++m_accessClock;
+            }
+            events[i] = event.value();
+            continue;
+        }
+        const auto ref = m_eventRefs.constFind(ids[i]);
+        if (ref != m_eventRefs.constEnd()) {
+            pending.emplace_back(i, ref.value());
+        }
+    }
+    if (pending.empty()) {
+        events.erase(std::remove(events.begin(), events.end(), nullptr), events.end());
+        return finishedEventQuery(EventSnapshot(std::move(events)));
+    }
+
+    // The source is never modified in place, so the worker can keep reading its copy even
+    // after a reload replaced it.
+    const QByteArray source = m_source;
+    return QtConcurrent::run([events, pending, source, token]() {
+        std::vector<EventHandle> result = events;
+        for (const auto &entry : pending) {
+            if (token.isCancelled()) {
+                return EventSnapshot();
+            }
+            if (auto event = parseReference(source, entry.second)) {
+                result[entry.first] = std::make_shared<const CalendarEvent>(std::move(*event));
+            }
+        }
+        result.erase(std::remove(result.begin(), result.end(), nullptr), result.end());
+        return EventSnapshot(std::move(result));
+    });
+}
+
+QFuture<EventSnapshot> FileCalendarStorage::allEventsAsync(const CancellationToken &token) const
+{
+    if (token.isCancelled()) {
+        return finishedEventQuery({});
+    }
+    std::vector<EventHandle> events;
+    events.reserve(static_cast<size_t>(m_events.size()));
+    QSet<QUuid> known;
+    known.reserve(m_events.size() + m_eventRefs.size());
+    for (auto it = m_events.constBegin(); it != m_events.constEnd(); ++it) {
+        events.push_back(it.value());
+        known.insert(it.key());
+    }
+    std::vector<IcsEventRef> pending;
+    for (auto it = m_eventRefs.constBegin(); it != m_eventRefs.constEnd(); ++it) {
+        if (!known.contains(it.key())) {
+            pending.push_back(it.value());
+            known.insert(it.key());
+        }
+    }
+    QStringList unreadShards;
+    for (auto it = m_monthShards.constBegin(); it != m_monthShards.constEnd(); ++it) {
+        if (!it.value()) {
+            unreadShards.append(shardPath(it.key()));
+        }
+    }
+    if (pending.empty() && unreadShards.isEmpty()) {
+        return finishedEventQuery(EventSnapshot(std::move(events)));
+    }
+
+    // Files of months not read yet are not written before they are read, and the source is
+    // never modified in place, so the worker reads them undisturbed.
+    const QByteArray source = m_source;
+    return QtConcurrent::run([events, pending, unreadShards, known, source, token]() {
+        std::vector<EventHandle> result = events;
+        for (const IcsEventRef &ref : pending) {
+            if (token.isCancelled()) {
+                return EventSnapshot();
+            }
+            if (auto event = parseReference(source, ref)) {
+                result.push_back(std::make_shared<const CalendarEvent>(std::move(*event)));
+            }
+        }
+        // Events in memory win over the files; of two file copies the newer one wins, as in
+        // loadShard().
+        QHash<QUuid, std::pair<qint64, EventHandle>> shardEvents;
+        for (const QString &path : unreadShards) {
+            if (token.isCancelled()) {
+                return EventSnapshot();
+            }
+            IcsParser::Collector collector;
+            IcsParser::parseFile(path, collector);
+            for (auto it = collector.events.begin(); it != collector.events.end(); ++it) {
+                const auto existing = shardEvents.constFind(it.key());
+                if (known.contains(it.key())
+                    || (existing != shardEvents.constEnd() && existing->first >= collector.revision)) {
+                    continue;
+                }
+                shardEvents.insert(it.key(),
+                                   {collector.revision,
+                                    std::make_shared<const CalendarEvent>(std::move(it.value()))});
+            }
+        }
+        for (auto it = shardEvents.constBegin(); it != shardEvents.constEnd(); ++it) {
+            result.push_back(it->second);
+        }
+        return EventSnapshot(std::move(result));
+    });
+}
+
+std::vector<CalendarEvent> FileCalendarStorage::seriesEvents() const
+{
+    std::vector<CalendarEvent> result;
+    result.reserve(static_cast<size_t>(m_seriesIds.size()));
+    for (const QUuid &id : m_seriesIds) {
+        if (const EventHandle event = materialize(id)) {
+            result.push_back(*event);
+        }
+    }
+    evictColdEvents();
+    return result;
+}
+
+void FileCalendarStorage::setMaterializedEventBudget(int events)
+{
+    m_materializedEventBudget = qMax(0, events);
+    evictColdEvents();
+}
+
+int FileCalendarStorage::materializedEventCount() const
+{
+    return m_eventAccess.size();
+}
+
+int FileCalendarStorage::loadedShardCount() const
+{
+    int count = 0;
+    for (auto it = m_monthShards.constBegin(); it != m_monthShards.constEnd(); ++it) {
+        count += it.value() ? 1 : 0;
+    }
+    return count;
+}
+
 CalendarEvent FileCalendarStorage::addOrUpdateEvent(CalendarEvent event)
 {
     if (event.id.isNull()) {
@@ -67,15 +420,37 @@ CalendarEvent FileCalendarStorage::addOrUpdateEvent(CalendarEvent event)
     if (!event.end.isValid() || event.end <= event.start) {
         event.end = event.start.addSecs(30 * 60);
     }
-    m_events.insert(event.id, event);
-    save();
+    markModified(event.id);
+    if (m_layout == Layout::Monthly) {
+        // An event of a month that was not read yet is moved out of its old file.
+        if (m_indexedShards.contains(event.id) && !m_eventShards.contains(event.id)) {
+            loadShardOf(event.id);
+        }
+        m_changedEvents.insert(event.id);
+        assignShard(event.id, shardMonthFor(event));
+    }
+    m_events.insert(event.id, std::make_shared<const CalendarEvent>(event));
+    indexEvent(event.id, event.start, event.end, Recurrence::belongsToSeries(event));
+    persistChange(event.id, IcsWriter::eventRecord(event));
     return event;
 }
 
 bool FileCalendarStorage::removeEvent(const QUuid &id)
 {
-    if (m_events.remove(id) > 0) {
-        save();
+    if (!m_events.contains(id)) {
+        loadShardOf(id);
+    }
+    releaseShard(id);
+    m_indexedShards.remove(id);
+    m_movedEvents.remove(id);
+    const bool removedMaterialized = m_events.remove(id) > 0;
+    const bool removedReference = m_eventRefs.remove(id) > 0;
+    m_eventAccess.remove(id);
+    if (removedMaterialized || removedReference) {
+        unindexEvent(id);
+        persistChange(id,
+                      QStringLiteral("%1:%2\n")
+                          .arg(QLatin1String(IcsParser::DeletedEventProperty), prepareUid(id)));
         return true;
     }
     return false;
@@ -87,352 +462,755 @@ TodoItem FileCalendarStorage::addOrUpdateTodo(TodoItem todo)
         todo.id = QUuid::createUuid();
     }
     m_todos.insert(todo.id, todo);
-    save();
+    m_todoOrder.insert(todo);
+    m_todosDirty = true;
+    persistChange(todo.id, IcsWriter::todoRecord(todo));
     return todo;
 }
 
 bool FileCalendarStorage::removeTodo(const QUuid &id)
 {
     if (m_todos.remove(id) > 0) {
-        save();
+        m_todoOrder.remove(id);
+        m_todosDirty = true;
+        persistChange(id,
+                      QStringLiteral("%1:%2\n")
+                          .arg(QLatin1String(IcsParser::DeletedTodoProperty), prepareUid(id)));
         return true;
     }
     return false;
 }
 
-void FileCalendarStorage::load()
+void FileCalendarStorage::beginBatch()
 {
-    m_events.clear();
-    m_todos.clear();
+    ++m_batchDepth;
+}
 
-    QFile file(m_filePath);
-    if (!file.exists()) {
+void FileCalendarStorage::commitBatch()
+{
+    if (m_batchDepth == 0) {
         return;
     }
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (--m_batchDepth == 0) {
+        flushPendingChanges();
+    }
+}
+
+void FileCalendarStorage::compact()
+{
+    if (m_filePath.isEmpty()) {
         return;
     }
+    if (m_layout == Layout::Monthly) {
+        // Month files that have not been read cannot contain changes.
+        for (auto it = m_monthShards.constBegin(); it != m_monthShards.constEnd(); ++it) {
+            if (it.value()) {
+                m_dirtyShards.insert(it.key());
+            }
+        }
+        m_dirtyShards.insert(QDate());
+        m_todosDirty = true;
+        writeDirtyShards();
+    } else {
+        writer()->writeSnapshot(CalendarSnapshot{m_events, m_todos, m_eventRefs, m_source});
+        m_journaledIds.clear();
+    }
+    m_journalRecords = 0;
+    m_journalNeedsCompaction = false;
+    m_pendingJournal.clear();
+    m_pendingRecords = 0;
+}
 
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
+void FileCalendarStorage::flush()
+{
+    if (m_batchDepth == 0) {
+        flushPendingChanges();
+    }
+    if (m_writer) {
+        m_writer->flush();
+    }
+}
 
-    enum class Section {
-        None,
-        Event,
-        Todo
-    };
+bool FileCalendarStorage::isWriting() const
+{
+    return m_writer && m_writer->isBusy();
+}
 
-    Section currentSection = Section::None;
-    CalendarEvent currentEvent;
-    TodoItem currentTodo;
+void FileCalendarStorage::setWriteCoalescingInterval(int msecs)
+{
+    m_writeCoalescingInterval = msecs;
+    if (m_writer) {
+        m_writer->setCoalescingInterval(msecs);
+    }
+}
 
-    auto finalizeEvent = [&]() {
-        if (currentEvent.id.isNull()) {
-            currentEvent.id = QUuid::createUuid();
-        }
-        if (!currentEvent.end.isValid() || currentEvent.end <= currentEvent.start) {
-            currentEvent.end = currentEvent.start.addSecs(30 * 60);
-        }
-        m_events.insert(currentEvent.id, currentEvent);
-        currentEvent = CalendarEvent{};
-    };
+QString FileCalendarStorage::journalPath() const
+{
+    return m_filePath + QLatin1String(JOURNAL_SUFFIX);
+}
 
-    auto finalizeTodo = [&]() {
-        if (currentTodo.id.isNull()) {
-            currentTodo.id = QUuid::createUuid();
-        }
-        m_todos.insert(currentTodo.id, currentTodo);
-        currentTodo = TodoItem{};
-    };
+void FileCalendarStorage::load()
+{
+    if (m_layout == Layout::Monthly) {
+        loadShards();
+        return;
+    }
 
-    auto handleLine = [&](const QString &line) {
-        if (line == QLatin1String("BEGIN:VEVENT")) {
-            currentSection = Section::Event;
-            currentEvent = CalendarEvent{};
-            return;
-        }
-        if (line == QLatin1String("END:VEVENT")) {
-            finalizeEvent();
-            currentSection = Section::None;
-            return;
-        }
-        if (line == QLatin1String("BEGIN:VTODO")) {
-            currentSection = Section::Todo;
-            currentTodo = TodoItem{};
-            return;
-        }
-        if (line == QLatin1String("END:VTODO")) {
-            finalizeTodo();
-            currentSection = Section::None;
-            return;
-        }
+    const IcsSourceState sourceState = CalendarCache::readSource(m_filePath, &m_source);
 
-        if (currentSection == Section::None) {
-            return;
+    IcsParser::Collector collector;
+    if (auto cached = CalendarCache::read(m_filePath, m_source, sourceState)) {
+        collector.eventRefs = std::move(cached->eventRefs);
+        collector.todos = std::move(cached->todos);
+    } else if (!m_source.isEmpty()) {
+        const char *source = m_source.constData();
+        IcsParser::indexConcurrently(source, source + m_source.size(), collector);
+        // The offsets refer to the bytes just read, so the cache is stamped with their state
+        // and hashed from them, not from whatever the file holds when the cache is written.
+        if (sourceState.isValid()) {
+            writer()->writeCache(
+                CalendarSnapshot{{}, collector.todos, collector.eventRefs, m_source, sourceState});
         }
+    }
 
-        const int colonIndex = line.indexOf(':');
-        if (colonIndex <= 0) {
-            return;
-        }
+    // Changes that have not been compacted yet are replayed on top of the ICS contents.
+    m_journaledIds.clear();
+    JournalReplay replay(collector, m_journaledIds);
+    const IcsParser::Result journal = IcsParser::parseFile(journalPath(), replay);
+    m_journalRecords = journal.records;
+    // A record without its END line was cut off while being written.
+    m_journalNeedsCompaction = !journal.complete;
 
-        const QString property = line.left(colonIndex);
-        const QString rawValue = line.mid(colonIndex + 1);
-        const QString name = property.section(';', 0, 0).toUpper();
-        const QString parameters = property.contains(';') ? property.section(';', 1) : QString();
-        const QString value = decodeText(rawValue);
-
-        const bool dateOnlyParam = parameters.contains(QLatin1String("VALUE=DATE"), Qt::CaseInsensitive);
-
-        if (currentSection == Section::Event) {
-            if (name == QLatin1String("UID")) {
-                currentEvent.id = parseUid(value);
-            } else if (name == QLatin1String("SUMMARY")) {
-                currentEvent.title = value;
-            } else if (name == QLatin1String("DESCRIPTION")) {
-                currentEvent.description = value;
-            } else if (name == QLatin1String("LOCATION")) {
-                currentEvent.location = value;
-            } else if (name == QLatin1String("DTSTART")) {
-                currentEvent.start = parseDateTime(rawValue);
-                currentEvent.allDay = dateOnlyParam || rawValue.size() == 8;
-                if (currentEvent.allDay && currentEvent.start.isValid()) {
-                    currentEvent.start.setTime(QTime(0, 0));
-                }
-            } else if (name == QLatin1String("DTEND")) {
-                currentEvent.end = parseDateTime(rawValue);
-                if (currentEvent.allDay && currentEvent.end.isValid()) {
-                    currentEvent.end.setTime(QTime(0, 0));
-                }
-            } else if (name == QLatin1String("CATEGORIES")) {
-                currentEvent.categories = splitList(value);
-            } else if (name == QLatin1String("RRULE")) {
-                currentEvent.recurrenceRule = rawValue;
-            } else if (name == QLatin1String("X-TASKMASTER-REMINDER")) {
-                currentEvent.reminderMinutes = rawValue.toInt();
-            } else if (name == QLatin1String("X-TASKMASTER-ALLDAY")) {
-                currentEvent.allDay = rawValue.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0;
+    m_events = toHandles(std::move(collector.events));
+    m_eventRefs = std::move(collector.eventRefs);
+    m_eventAccess.clear();
+    m_todos = std::move(collector.todos);
+    indexTodos();
+
+    m_eventIndex.clear();
+    m_seriesIds.clear();
+    for (auto it = m_eventRefs.constBegin(); it != m_eventRefs.constEnd(); ++it) {
+        indexEvent(it.key(), it.value().start, it.value().end, it.value().inSeries);
+    }
+    for (auto it = m_events.constBegin(); it != m_events.constEnd(); ++it) {
+        indexEvent(it.key(), it.value()->start, it.value()->end, Recurrence::belongsToSeries(*it.value()));
+    }
+}
+
+void FileCalendarStorage::loadShards()
+{
+    m_monthShards.clear();
+    m_eventShards.clear();
+    m_shardEvents.clear();
+    m_dirtyShards.clear();
+    m_shardRevisions.clear();
+    m_shardRevision = 0;
+    m_indexedShards.clear();
+    m_shardIndexComplete = false;
+    m_changedEvents.clear();
+    m_movedEvents.clear();
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+
+    const QDir root(m_filePath);
+    const QStringList years = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &year : years) {
+        const QDir yearDir(root.filePath(year));
+        const QStringList files = yearDir.entryList({QStringLiteral("*.ics")}, QDir::Files);
+        for (const QString &file : files) {
+            const QDate month =
+                QDate::fromString(QFileInfo(file).completeBaseName(), QStringLiteral("yyyy-MM"));
+            if (month.isValid()) {
+                m_monthShards.insert(month, false);
             }
-            return;
         }
+    }
 
-        if (currentSection == Section::Todo) {
-            if (name == QLatin1String("UID")) {
-                currentTodo.id = parseUid(value);
-            } else if (name == QLatin1String("SUMMARY")) {
-                currentTodo.title = value;
-            } else if (name == QLatin1String("DESCRIPTION")) {
-                currentTodo.description = value;
-            } else if (name == QLatin1String("LOCATION")) {
-                currentTodo.location = value;
-            } else if (name == QLatin1String("DUE")) {
-                currentTodo.dueDate = parseDateTime(rawValue);
-                if (dateOnlyParam && currentTodo.dueDate.isValid()) {
-                    currentTodo.dueDate.setTime(QTime(0, 0));
-                }
-            } else if (name == QLatin1String("PRIORITY")) {
-                currentTodo.priority = rawValue.toInt();
-            } else if (name == QLatin1String("STATUS")) {
-                currentTodo.status = statusFromString(rawValue);
-            } else if (name == QLatin1String("CATEGORIES")) {
-                currentTodo.tags = splitList(value);
-            } else if (name == QLatin1String("X-TASKMASTER-SCHEDULED")) {
-                currentTodo.scheduled = rawValue.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0;
-            } else if (name == QLatin1String("X-TASKMASTER-DURATION")) {
-                currentTodo.durationMinutes = rawValue.toInt();
+    IcsParser::Collector todos;
+    IcsParser::parseFile(root.filePath(QLatin1String(TODO_SHARD)), todos);
+    m_todos = std::move(todos.todos);
+    indexTodos();
+    loadShardIndex();
+    // Without month files there is nothing the index could miss.
+    m_shardIndexComplete = m_shardIndexComplete || m_monthShards.isEmpty();
+    loadShard(QDate());
+}
+
+void FileCalendarStorage::loadShard(const QDate &month) const
+{
+    IcsParser::Collector collector;
+    IcsParser::parseFile(shardPath(month), collector);
+    m_shardRevisions.insert(month, collector.revision);
+    m_shardRevision = qMax(m_shardRevision, collector.revision);
+    for (auto it = collector.events.begin(); it != collector.events.end(); ++it) {
+        const auto owner = m_eventShards.constFind(it.key());
+        if (owner != m_eventShards.constEnd()) {
+            // Left behind by an interrupted move. A copy changed in memory wins, otherwise the
+            // one from the newer file, and on a tie the one in the file the event belongs in.
+            // Rewriting the losing file drops its copy.
+            const QDate ownerMonth = owner.value();
+            const qint64 ownerRevision = m_shardRevisions.value(ownerMonth);
+            const EventHandle loaded = m_events.value(it.key());
+            const bool replaces = !m_changedEvents.contains(it.key())
+                                  && (collector.revision > ownerRevision
+                                      || (collector.revision == ownerRevision
+                                          && shardMonthFor(it.value()) == month
+                                          && (!loaded || shardMonthFor(*loaded) != ownerMonth)));
+            if (!replaces) {
+                m_dirtyShards.insert(month);
+                continue;
             }
+            m_shardEvents[ownerMonth].remove(it.key());
+            m_dirtyShards.insert(ownerMonth);
         }
-    };
+        m_eventShards.insert(it.key(), month);
+        m_indexedShards.insert(it.key(), month);
+        m_shardEvents[month].insert(it.key());
+        indexEvent(it.key(), it.value().start, it.value().end, Recurrence::belongsToSeries(it.value()));
+        m_events.insert(it.key(), std::make_shared<const CalendarEvent>(std::move(it.value())));
+    }
+}
 
-    QString accumulator;
-    bool hasAccumulator = false;
-    while (!stream.atEnd()) {
-        QString line = stream.readLine();
-        if (!line.isEmpty() && (line.startsWith(' ') || line.startsWith('\t'))) {
-            if (hasAccumulator) {
-                accumulator += line.mid(1);
-            }
-        } else {
-            if (hasAccumulator) {
-                handleLine(accumulator);
-            }
-            accumulator = line;
-            hasAccumulator = true;
+void FileCalendarStorage::loadShardsInRange(const QDate &from, const QDate &to) const
+{
+    const QDate firstMonth(from.year(), from.month(), 1);
+    for (auto it = m_monthShards.lowerBound(firstMonth); it != m_monthShards.end() && it.key() <= to; ++it) {
+        if (!it.value()) {
+            it.value() = true;
+            loadShard(it.key());
         }
     }
-    if (hasAccumulator) {
-        handleLine(accumulator);
+}
+
+bool FileCalendarStorage::loadShardOf(const QUuid &id) const
+{
+    const auto indexed = m_indexedShards.constFind(id);
+    if (indexed == m_indexedShards.constEnd()) {
+        // A complete index knows every event, so the id is not stored anywhere.
+        return !m_shardIndexComplete && loadAllShards();
+    }
+    const auto shard = m_monthShards.find(indexed.value());
+    if (shard == m_monthShards.end() || shard.value()) {
+        return false;
     }
+    shard.value() = true;
+    loadShard(shard.key());
+    return true;
 }
 
-void FileCalendarStorage::save() const
+bool FileCalendarStorage::loadAllShards() const
 {
-    if (m_filePath.isEmpty()) {
-        return;
+    m_shardIndexComplete = true;
+    bool loaded = false;
+    for (auto it = m_monthShards.begin(); it != m_monthShards.end(); ++it) {
+        if (!it.value()) {
+            it.value() = true;
+            loadShard(it.key());
+            loaded = true;
+        }
     }
+    return loaded;
+}
 
-    QFileInfo info(m_filePath);
-    QDir dir = info.dir();
-    if (!dir.exists()) {
-        dir.mkpath(QStringLiteral("."));
+QString FileCalendarStorage::shardPath(const QDate &month) const
+{
+    if (!month.isValid()) {
+        return QDir(m_filePath).filePath(QLatin1String(SPANNING_SHARD));
     }
+    const QString year = QStringLiteral("%1").arg(month.year(), 4, 10, QLatin1Char('0'));
+    return QDir(m_filePath).filePath(
+        QStringLiteral("%1/%1-%2.ics").arg(year).arg(month.month(), 2, 10, QLatin1Char('0')));
+}
 
-    QSaveFile file(m_filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+QString FileCalendarStorage::shardIndexPath() const
+{
+    return QDir(m_filePath).filePath(QLatin1String(SHARD_INDEX));
+}
+
+void FileCalendarStorage::loadShardIndex()
+{
+    // Without an index, looking up an event by id reads every month once. An entry naming the
+    // wrong month only costs reading that file for nothing; copies left in two files are
+    // sorted out by loadShard().
+    QFile file(shardIndexPath());
+    if (!file.open(QIODevice::ReadOnly)) {
         return;
     }
+    m_shardIndexComplete = true;
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    m_indexedShards.reserve(lines.size());
+    for (const QByteArray &line : lines) {
+        const int separator = line.indexOf(' ');
+        const QUuid id(line.left(separator));
+        if (separator < 0 || id.isNull()) {
+            continue;
+        }
+        const QString month = QString::fromLatin1(line.mid(separator + 1));
+        m_indexedShards.insert(id, QDate::fromString(month, QStringLiteral("yyyy-MM")));
+    }
+}
 
-    QTextStream stream(&file);
-    stream.setCodec("UTF-8");
+QByteArray FileCalendarStorage::shardIndex() const
+{
+    QByteArray index;
+    index.reserve(m_indexedShards.size() * 48);
+    for (auto it = m_indexedShards.constBegin(); it != m_indexedShards.constEnd(); ++it) {
+        index += it.key().toByteArray(QUuid::WithoutBraces);
+        index += ' ';
+        index += it.value().isValid() ? it.value().toString(QStringLiteral("yyyy-MM")).toLatin1()
+                                      : QByteArray(SPANNING_INDEX_ENTRY);
+        index += '\n';
+    }
+    return index;
+}
 
-    stream << "BEGIN:VCALENDAR\n";
-    stream << "VERSION:2.0\n";
-    stream << "PRODID:-//Block Master//EN\n";
+qint64 FileCalendarStorage::nextShardRevision()
+{
+    // Following the clock gives files written in a later session higher revisions than those
+    // of files not read in this one.
+    m_shardRevision = qMax(m_shardRevision + 1, QDateTime::currentMSecsSinceEpoch());
+    return m_shardRevision;
+}
 
-    auto events = m_events.values();
-    std::sort(events.begin(), events.end(), [](const CalendarEvent &lhs, const CalendarEvent &rhs) {
-        return lhs.start < rhs.start;
-    });
-    for (const CalendarEvent &event : events) {
-        stream << "BEGIN:VEVENT\n";
-        stream << "UID:" << prepareUid(event.id) << '\n';
-        stream << "SUMMARY:" << encodeText(event.title) << '\n';
-        if (!event.description.isEmpty()) {
-            stream << "DESCRIPTION:" << encodeText(event.description) << '\n';
-        }
-        if (!event.location.isEmpty()) {
-            stream << "LOCATION:" << encodeText(event.location) << '\n';
-        }
-        if (event.allDay) {
-            stream << "DTSTART;VALUE=DATE:" << event.start.date().toString(DATE_FORMAT) << '\n';
-            stream << "DTEND;VALUE=DATE:" << event.end.date().toString(DATE_FORMAT) << '\n';
-        } else {
-            stream << "DTSTART:" << formatDateTime(event.start) << '\n';
-            stream << "DTEND:" << formatDateTime(event.end) << '\n';
+void FileCalendarStorage::assignShard(const QUuid &id, const QDate &month)
+{
+    const auto current = m_eventShards.constFind(id);
+    if (current != m_eventShards.constEnd() && current.value() == month) {
+        m_dirtyShards.insert(month);
+        return;
+    }
+    if (current != m_eventShards.constEnd()) {
+        // The file the event was last written to is the one that has to keep it.
+        if (!m_movedEvents.contains(id)) {
+            m_movedEvents.insert(id, current.value());
+        } else if (m_movedEvents.value(id) == month) {
+            m_movedEvents.remove(id);
+        }
+    }
+    releaseShard(id);
+    if (month.isValid()) {
+        // The whole month is rewritten, so it has to be read first.
+        const auto shard = m_monthShards.find(month);
+        if (shard == m_monthShards.end()) {
+            m_monthShards.insert(month, true);
+        } else if (!shard.value()) {
+            shard.value() = true;
+            loadShard(month);
+        }
+    }
+    m_eventShards.insert(id, month);
+    m_indexedShards.insert(id, month);
+    m_shardEvents[month].insert(id);
+    m_dirtyShards.insert(month);
+}
+
+void FileCalendarStorage::releaseShard(const QUuid &id)
+{
+    const auto it = m_eventShards.find(id);
+    if (it == m_eventShards.end()) {
+        return;
+    }
+    m_shardEvents[it.value()].remove(id);
+    m_dirtyShards.insert(it.value());
+    m_eventShards.erase(it);
+}
+
+void FileCalendarStorage::writeDirtyShards()
+{
+    if (m_filePath.isEmpty() || (m_dirtyShards.isEmpty() && !m_todosDirty)) {
+        return;
+    }
+    QHash<QString, CalendarSnapshot> shards;
+    QString indexPath;
+    QByteArray index;
+    if (!m_dirtyShards.isEmpty()) {
+        const qint64 revision = nextShardRevision();
+        for (const QDate &month : qAsConst(m_dirtyShards)) {
+            CalendarSnapshot shard;
+            shard.revision = revision;
+            for (const QUuid &id : m_shardEvents.value(month)) {
+                shard.events.insert(id, m_events.value(id));
+            }
+            shards.insert(shardPath(month), std::move(shard));
+            m_shardRevisions.insert(month, revision);
         }
-        if (!event.categories.isEmpty()) {
-            stream << "CATEGORIES:" << encodeText(event.categories.join(',')) << '\n';
+        // An index written before every month was seen would hide the events of the others.
+        if (m_shardIndexComplete) {
+            indexPath = shardIndexPath();
+            index = shardIndex();
         }
-        if (!event.recurrenceRule.isEmpty()) {
-            stream << "RRULE:" << event.recurrenceRule << '\n';
+    }
+    // A moved event is written to its old file as well and only dropped from it once every
+    // new file has been written, so an interruption cannot lose it. The old file was marked
+    // dirty when the event left it.
+    QHash<QString, CalendarSnapshot> followUps;
+    if (!m_movedEvents.isEmpty()) {
+        const qint64 revision = nextShardRevision();
+        for (auto it = m_movedEvents.constBegin(); it != m_movedEvents.constEnd(); ++it) {
+            const QString path = shardPath(it.value());
+            const auto shard = shards.find(path);
+            if (shard == shards.end()) {
+                continue;
+            }
+            if (!followUps.contains(path)) {
+                CalendarSnapshot followUp = shard.value();
+                followUp.revision = revision;
+                followUps.insert(path, std::move(followUp));
+                m_shardRevisions.insert(it.value(), revision);
+            }
+            shard->events.insert(it.key(), m_events.value(it.key()));
         }
-        if (event.reminderMinutes > 0) {
-            stream << "X-TASKMASTER-REMINDER:" << event.reminderMinutes << '\n';
+        m_movedEvents.clear();
+    }
+    if (m_todosDirty) {
+        shards.insert(QDir(m_filePath).filePath(QLatin1String(TODO_SHARD)),
+                      CalendarSnapshot{{}, m_todos, {}, {}});
+    }
+    m_dirtyShards.clear();
+    m_todosDirty = false;
+    writer()->writeShards(std::move(shards), std::move(followUps), indexPath, index);
+}
+
+void FileCalendarStorage::watchFile()
+{
+    m_watcher = new QFileSystemWatcher(this);
+    m_reloadTimer = new QTimer(this);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(EXTERNAL_RELOAD_DELAY_MS);
+    connect(m_reloadTimer, &QTimer::timeout, this, &FileCalendarStorage::startExternalReload);
+
+    // Saving through a temporary file (as QSaveFile does) replaces the file and ends its watch,
+    // so the directory is watched as well to pick the file up again.
+    const auto rewatch = [this]() {
+        if (!m_watcher->files().contains(m_filePath) && QFile::exists(m_filePath)) {
+            m_watcher->addPath(m_filePath);
+            return true;
         }
-        if (event.allDay) {
-            stream << "X-TASKMASTER-ALLDAY:TRUE\n";
+        return false;
+    };
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, [this, rewatch]() {
+        rewatch();
+        m_reloadTimer->start();
+    });
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, [this, rewatch]() {
+        if (rewatch()) {
+            m_reloadTimer->start();
         }
-        stream << "END:VEVENT\n";
+    });
+
+    const QString directory = QFileInfo(m_filePath).absolutePath();
+    if (QFileInfo::exists(directory)) {
+        m_watcher->addPath(directory);
+    }
+    rewatch();
+}
+
+void FileCalendarStorage::startExternalReload()
+{
+    // Our own writes are awaited first; the file is read once the writer is idle.
+    if (m_reloadRunning || isWriting()) {
+        m_reloadPending = true;
+        return;
     }
+    m_reloadRunning = true;
+    m_reloadPending = false;
 
-    auto todos = m_todos.values();
-    std::sort(todos.begin(), todos.end(), [](const TodoItem &lhs, const TodoItem &rhs) {
-        return lhs.priority > rhs.priority;
+    auto *watcher = new QFutureWatcher<ExternalState>(this);
+    connect(watcher, &QFutureWatcher<ExternalState>::finished, this, [this, watcher]() {
+        m_reloadRunning = false;
+        watcher->deleteLater();
+        // The file changed again while it was read; only the newest contents are applied.
+        if (m_reloadPending || isWriting()) {
+            m_reloadPending = true;
+            if (!isWriting()) {
+                m_reloadTimer->start();
+            }
+            return;
+        }
+        const ExternalState state = watcher->result();
+        if (state.complete) {
+            applyExternalState(state);
+        }
     });
-    for (const TodoItem &todo : todos) {
-        stream << "BEGIN:VTODO\n";
-        stream << "UID:" << prepareUid(todo.id) << '\n';
-        stream << "SUMMARY:" << encodeText(todo.title) << '\n';
-        if (!todo.description.isEmpty()) {
-            stream << "DESCRIPTION:" << encodeText(todo.description) << '\n';
+    const QString filePath = m_filePath;
+    watcher->setFuture(QtConcurrent::run([filePath]() {
+        ExternalState state;
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return state;
         }
-        if (!todo.location.isEmpty()) {
-            stream << "LOCATION:" << encodeText(todo.location) << '\n';
+        state.source = file.readAll();
+        const char *source = state.source.constData();
+        const IcsParser::Result result =
+            IcsParser::index(source, source + state.source.size(), state.contents);
+        // A file that is rewritten in place may be read before its last line is written.
+        state.complete = result.complete && state.source.lastIndexOf("END:VCALENDAR") >= 0;
+        return state;
+    }));
+}
+
+void FileCalendarStorage::applyExternalState(const ExternalState &state)
+{
+    QHash<QUuid, IcsEventRef> refs = state.contents.eventRefs;
+    QHash<QUuid, TodoItem> todos = state.contents.todos;
+    // The journal is replayed over the file on the next start, so its changes win here as well.
+    for (const QUuid &id : qAsConst(m_journaledIds)) {
+        refs.remove(id);
+        todos.remove(id);
+    }
+
+    std::vector<QUuid> knownIds;
+    knownIds.reserve(static_cast<size_t>(m_eventRefs.size() + m_events.size()));
+    for (auto it = m_eventRefs.constBegin(); it != m_eventRefs.constEnd(); ++it) {
+        knownIds.push_back(it.key());
+    }
+    for (auto it = m_events.constBegin(); it != m_events.constEnd(); ++it) {
+        if (!m_eventRefs.contains(it.key())) {
+            knownIds.push_back(it.key());
         }
-        if (todo.dueDate.isValid()) {
-            stream << "DUE:" << formatDateTime(todo.dueDate) << '\n';
+    }
+
+    EventChangeSet eventChanges;
+    for (const QUuid &id : knownIds) {
+        if (m_journaledIds.contains(id) || refs.contains(id)) {
+            continue;
         }
-        if (todo.priority > 0) {
-            stream << "PRIORITY:" << todo.priority << '\n';
+        if (const EventHandle event = materialize(id)) {
+            eventChanges.removed.push_back(*event);
         }
-        stream << "STATUS:" << statusToString(todo.status) << '\n';
-        if (!todo.tags.isEmpty()) {
-            stream << "CATEGORIES:" << encodeText(todo.tags.join(',')) << '\n';
+        unindexEvent(id);
+    }
+    for (auto it = refs.constBegin(); it != refs.constEnd(); ++it) {
+        const bool known = m_eventRefs.contains(it.key()) || m_events.contains(it.key());
+        if (known && hasSameContent(it.key(), state.source, it.value())) {
+            continue;
         }
-        if (todo.scheduled) {
-            stream << "X-TASKMASTER-SCHEDULED:TRUE\n";
+        const auto after = parseReference(state.source, it.value());
+        const EventHandle before = known ? materialize(it.key()) : nullptr;
+        if (before && after) {
+            eventChanges.updated.push_back({*before, *after});
+        } else if (after) {
+            eventChanges.inserted.push_back(*after);
         }
-        if (todo.durationMinutes > 0) {
-            stream << "X-TASKMASTER-DURATION:" << todo.durationMinutes << '\n';
+        indexEvent(it.key(), it.value().start, it.value().end, it.value().inSeries);
+    }
+
+    TodoChangeSet todoChanges;
+    for (auto it = m_todos.constBegin(); it != m_todos.constEnd(); ++it) {
+        if (!m_journaledIds.contains(it.key()) && !todos.contains(it.key())) {
+            todoChanges.removed.push_back(it.value());
+        }
+    }
+    for (auto it = todos.constBegin(); it != todos.constEnd(); ++it) {
+        const auto current = m_todos.constFind(it.key());
+        if (current == m_todos.constEnd()) {
+            todoChanges.inserted.push_back(it.value());
+        } else if (IcsWriter::todoRecord(current.value()) != IcsWriter::todoRecord(it.value())) {
+            todoChanges.updated.push_back({current.value(), it.value()});
         }
-        stream << "END:VTODO\n";
     }
 
-    stream << "END:VCALENDAR\n";
+    // Only the journaled items stay in memory; everything else now refers to the new file.
+    QHash<QUuid, EventHandle> journaledEvents;
+    for (const QUuid &id : qAsConst(m_journaledIds)) {
+        const auto event = m_events.constFind(id);
+        if (event != m_events.constEnd()) {
+            journaledEvents.insert(id, event.value());
+        }
+        const auto todo = m_todos.constFind(id);
+        if (todo != m_todos.constEnd()) {
+            todos.insert(id, todo.value());
+        }
+    }
+    m_source = state.source;
+    m_eventRefs = std::move(refs);
+    m_events = std::move(journaledEvents);
+    m_eventAccess.clear();
+    m_todos = std::move(todos);
+    indexTodos();
 
-    stream.flush();
-    file.commit();
+    if (!eventChanges.isEmpty()) {
+        emit eventsChangedExternally(eventChanges);
+    }
+    if (!todoChanges.isEmpty()) {
+        emit todosChangedExternally(todoChanges);
+    }
 }
 
-QString FileCalendarStorage::encodeText(const QString &text)
+bool FileCalendarStorage::hasSameContent(const QUuid &id,
+                                         const QByteArray &source,
+                                         const IcsEventRef &ref) const
 {
-    QString encoded = text;
-    encoded.replace('\\', "\\\\");
-    encoded.replace('\n', "\\n");
-    encoded.replace(',', "\\,");
-    encoded.replace(';', "\\;");
-    return encoded;
+    if (ref.offset < 0 || ref.offset + ref.length > source.size()) {
+        return false;
+    }
+    const QByteArray record = QByteArray::fromRawData(source.constData() + ref.offset, ref.length);
+    // Records we wrote ourselves are usually byte-identical; only the others are parsed.
+    const auto current = m_eventRefs.constFind(id);
+    if (current != m_eventRefs.constEnd()) {
+        const IcsEventRef &currentRef = current.value();
+        if (currentRef.offset + currentRef.length <= m_source.size()
+            && QByteArray::fromRawData(m_source.constData() + currentRef.offset, currentRef.length)
+                   == record) {
+            return true;
+        }
+    }
+    const EventHandle event = materialize(id);
+    const auto updated = parseReference(source, ref);
+    if (!event || !updated) {
+        return !event && !updated;
+    }
+    return IcsWriter::eventRecord(*event) == IcsWriter::eventRecord(*updated);
 }
 
-QString FileCalendarStorage::decodeText(const QString &text)
+void FileCalendarStorage::persistChange(const QUuid &id, const QString &record)
 {
-    QString decoded = text;
-    decoded.replace("\\n", "\n", Qt::CaseInsensitive);
-    decoded.replace("\\,", ",");
-    decoded.replace("\\;", ";");
-    decoded.replace("\\\\", "\\");
-    return decoded;
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+    if (m_layout == Layout::SingleFile) {
+        m_pendingJournal += record;
+        m_journaledIds.insert(id);
+    }
+    ++m_pendingRecords;
+    if (m_batchDepth == 0) {
+        flushPendingChanges();
+    }
 }
 
-QString FileCalendarStorage::formatDateTime(const QDateTime &dt)
+void FileCalendarStorage::flushPendingChanges()
 {
-    if (!dt.isValid()) {
-        return {};
+    if (m_pendingRecords == 0) {
+        return;
     }
-    return dt.toUTC().toString(QLatin1String(DATE_TIME_FORMAT));
+    if (m_layout == Layout::Monthly && !m_journalNeedsCompaction) {
+        writeDirtyShards();
+        m_pendingRecords = 0;
+        return;
+    }
+    // Large batches (e.g. imports) are cheaper as a single rewrite than as journal records.
+    if (m_journalNeedsCompaction
+        || m_journalRecords + m_pendingRecords > JOURNAL_COMPACTION_THRESHOLD) {
+        compact();
+        return;
+    }
+    writer()->appendJournal(m_pendingJournal.toUtf8());
+    m_journalRecords += m_pendingRecords;
+    m_pendingJournal.clear();
+    m_pendingRecords = 0;
 }
 
-QDateTime FileCalendarStorage::parseDateTime(const QString &value)
+void FileCalendarStorage::indexEvent(const QUuid &id,
+                                     const QDateTime &start,
+                                     const QDateTime &end,
+                                     bool inSeries) const
 {
-    if (value.length() == 8) {
-        const QDate date = QDate::fromString(value, DATE_FORMAT);
-        return QDateTime(date.startOfDay());
+    if (inSeries) {
+        m_seriesIds.insert(id);
+    } else {
+        m_seriesIds.remove(id);
     }
-    if (value.endsWith('Z')) {
-        QDateTime dt = QDateTime::fromString(value, DATE_TIME_FORMAT);
-        dt.setTimeSpec(Qt::UTC);
-        return dt.toLocalTime();
+    // Events without a valid time span can never match a date range.
+    if (!start.isValid() || !end.isValid()) {
+        m_eventIndex.remove(id);
+        return;
     }
-    QDateTime dt = QDateTime::fromString(value, "yyyyMMdd'T'hhmmss");
-    if (!dt.isValid()) {
-        dt = QDateTime::fromString(value, Qt::ISODate);
+    m_eventIndex.insert(id, start.toMSecsSinceEpoch(), end.toMSecsSinceEpoch());
+}
+
+void FileCalendarStorage::unindexEvent(const QUuid &id) const
+{
+    m_eventIndex.remove(id);
+    m_seriesIds.remove(id);
+}
+
+void FileCalendarStorage::indexTodos()
+{
+    m_todoOrder.clear();
+    for (auto it = m_todos.constBegin(); it != m_todos.constEnd(); ++it) {
+        m_todoOrder.insert(it.value());
     }
-    return dt;
 }
 
-QString FileCalendarStorage::statusToString(TodoStatus status)
+void FileCalendarStorage::markModified(const QUuid &id)
+{
+    // A modified event has no up-to-date source any more and stays materialized.
+    m_eventRefs.remove(id);
+    m_eventAccess.remove(id);
+}
+
+EventHandle FileCalendarStorage::materialize(const QUuid &id) const
 {
-    switch (status) {
-    case TodoStatus::Completed:
-        return QStringLiteral("COMPLETED");
-    case TodoStatus::InProgress:
-        return QStringLiteral("IN-PROCESS");
-    case TodoStatus::Pending:
-    default:
-        return QStringLiteral("NEEDS-ACTION");
+    const auto it = m_events.constFind(id);
+    if (it != m_events.constEnd()) {
+        const auto access = m_eventAccess.find(id);
+        if (access != m_eventAccess.end()) {
+            access.value() = ++m_accessClock;
+        }
+        return it.value();
+    }
+
+    const auto ref = m_eventRefs.constFind(id);
+    if (ref == m_eventRefs.constEnd() || ref->offset + ref->length > m_source.size()) {
+        return nullptr;
     }
+    auto event = IcsParser::parseEvent(m_source.constData() + ref->offset, ref->length);
+    if (!event) {
+        return nullptr;
+    }
+    // Records without a usable UID were given an id while indexing.
+    event->id = id;
+    m_eventAccess.insert(id, ++m_accessClock);
+    return m_events.insert(id, std::make_shared<const CalendarEvent>(std::move(*event))).value();
 }
 
-TodoStatus FileCalendarStorage::statusFromString(const QString &value)
+void FileCalendarStorage::evictColdEvents() const
 {
-    const QString normalized = value.toUpper();
-    if (normalized == QLatin1String("COMPLETED")) {
-        return TodoStatus::Completed;
+    if (m_eventAccess.size() <= m_materializedEventBudget) {
+        return;
+    }
+
+    std::vector<std::pair<quint64, QUuid>> byAccess;
+    byAccess.reserve(static_cast<size_t>(m_eventAccess.size()));
+    for (auto it = m_eventAccess.constBegin(); it != m_eventAccess.constEnd(); ++it) {
+        byAccess.emplace_back(it.value(), it.key());
+    }
+    // Shrink to three quarters of the budget so that scrolling does not evict on every fetch.
+    const auto keep = static_cast<size_t>(m_materializedEventBudget) * 3 / 4;
+    const auto evictCount = static_cast<std::ptrdiff_t>(byAccess.size() - keep);
+    std::nth_element(byAccess.begin(),
+                     byAccess.begin() + evictCount,
+                     byAccess.end(),
+                     [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+    for (auto it = byAccess.begin(); it != byAccess.begin() + evictCount; ++it) {
+        m_events.remove(it->second);
+        m_eventAccess.remove(it->second);
     }
-    if (normalized == QLatin1String("IN-PROCESS")) {
-        return TodoStatus::InProgress;
+}
+
+CalendarWriter *FileCalendarStorage::writer()
+{
+    if (!m_writer) {
+        m_writer = std::make_unique<CalendarWriter>(m_filePath, journalPath(), m_writeCoalescingInterval);
+        connect(m_writer.get(), &CalendarWriter::busyChanged, this, [this]() {
+            const bool writing = isWriting();
+            if (!writing && m_reloadPending && m_reloadTimer) {
+                m_reloadTimer->start();
+            }
+            emit writingChanged(writing);
+        });
+        connect(m_writer.get(), &CalendarWriter::writeFailed, this, [this](const QString &errorString) {
+            // The journal can no longer be trusted to be complete; rewrite everything next time.
+            m_journalNeedsCompaction = true;
+            emit writeFailed(errorString);
+        });
+        m_writerThread = std::make_unique<QThread>();
+        m_writerThread->setObjectName(QStringLiteral("CalendarWriter"));
+        m_writer->moveToThread(m_writerThread.get());
+        m_writerThread->start();
     }
-    return TodoStatus::Pending;
+    return m_writer.get();
 }
 
 } // namespace data
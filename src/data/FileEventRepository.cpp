@@ -1,7 +1,5 @@
 #include "calendar/data/FileEventRepository.hpp"
 
-#include <algorithm>
-
 namespace calendar {
 namespace data {
 
@@ -12,27 +10,44 @@ FileEventRepository::FileEventRepository(std::shared_ptr<FileCalendarStorage> st
 
 std::vector<CalendarEvent> FileEventRepository::fetchEvents(const QDate &from, const QDate &to) const
 {
-    std::vector<CalendarEvent> result;
     if (!m_storage) {
-        return result;
+        return {};
     }
+    return m_storage->eventsInRange(from, to);
+}
 
-    const auto &events = m_storage->events();
-    result.reserve(static_cast<size_t>(events.size()));
-    for (auto it = events.constBegin(); it != events.constEnd(); ++it) {
-        const auto &event = it.value();
-        if (event.end.date() < from || event.start.date() > to) {
-            continue;
-        }
-        result.push_back(event);
+EventSnapshot FileEventRepository::fetchEventSnapshot(const QDate &from, const QDate &to) const
+{
+    if (!m_storage) {
+        return {};
     }
-    std::sort(result.begin(), result.end(), [](const CalendarEvent &lhs, const CalendarEvent &rhs) {
-        if (lhs.start == rhs.start) {
-            return lhs.end < rhs.end;
-        }
-        return lhs.start < rhs.start;
-    });
-    return result;
+    return m_storage->eventSnapshot(from, to);
+}
+
+QFuture<EventSnapshot> FileEventRepository::fetchEventsAsync(const QDate &from,
+                                                            const QDate &to,
+                                                            const CancellationToken &token) const
+{
+    if (!m_storage) {
+        return finishedEventQuery({});
+    }
+    return m_storage->eventSnapshotAsync(from, to, token);
+}
+
+QFuture<EventSnapshot> FileEventRepository::fetchAllEventsAsync(const CancellationToken &token) const
+{
+    if (!m_storage) {
+        return finishedEventQuery({});
+    }
+    return m_storage->allEventsAsync(token);
+}
+
+std::vector<CalendarEvent> FileEventRepository::fetchSeriesEvents() const
+{
+    if (!m_storage) {
+        return {};
+    }
+    return m_storage->seriesEvents();
 }
 
 std::optional<CalendarEvent> FileEventRepository::findById(const QUuid &id) const
@@ -40,11 +55,7 @@ std::optional<CalendarEvent> FileEventRepository::findById(const QUuid &id) cons
     if (!m_storage) {
         return std::nullopt;
     }
-    const auto &events = m_storage->events();
-    if (events.contains(id)) {
-        return events.value(id);
-    }
-    return std::nullopt;
+    return m_storage->event(id);
 }
 
 CalendarEvent FileEventRepository::addEvent(CalendarEvent event)
@@ -60,8 +71,7 @@ bool FileEventRepository::updateEvent(const CalendarEvent &event)
     if (!m_storage) {
         return false;
     }
-    const auto &events = m_storage->events();
-    if (!events.contains(event.id)) {
+    if (!m_storage->containsEvent(event.id)) {
         return false;
     }
     m_storage->addOrUpdateEvent(event);
@@ -76,6 +86,19 @@ bool FileEventRepository::removeEvent(const QUuid &id)
     return m_storage->removeEvent(id);
 }
 
+void FileEventRepository::beginBatch()
+{
+    if (m_storage) {
+        m_storage->beginBatch();
+    }
+}
+
+void FileEventRepository::commitBatch()
+{
+    if (m_storage) {
+        m_storage->commitBatch();
+    }
+}
+
 } // namespace data
 } // namespace calendar
-
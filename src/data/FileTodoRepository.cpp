@@ -1,7 +1,5 @@
 #include "calendar/data/FileTodoRepository.hpp"
 
-#include <algorithm>
-
 namespace calendar {
 namespace data {
 
@@ -12,22 +10,10 @@ FileTodoRepository::FileTodoRepository(std::shared_ptr<FileCalendarStorage> stor
 
 std::vector<TodoItem> FileTodoRepository::fetchTodos() const
 {
-    std::vector<TodoItem> result;
     if (!m_storage) {
-        return result;
-    }
-    const auto &todos = m_storage->todos();
-    result.reserve(static_cast<size_t>(todos.size()));
-    for (auto it = todos.constBegin(); it != todos.constEnd(); ++it) {
-        result.push_back(it.value());
+        return {};
     }
-    std::sort(result.begin(), result.end(), [](const TodoItem &lhs, const TodoItem &rhs) {
-        if (lhs.priority == rhs.priority) {
-            return lhs.title.toLower() < rhs.title.toLower();
-        }
-        return lhs.priority > rhs.priority;
-    });
-    return result;
+    return m_storage->orderedTodos();
 }
 
 std::optional<TodoItem> FileTodoRepository::findById(const QUuid &id) const
@@ -71,6 +57,19 @@ bool FileTodoRepository::removeTodo(const QUuid &id)
     return m_storage->removeTodo(id);
 }
 
+void FileTodoRepository::beginBatch()
+{
+    if (m_storage) {
+        m_storage->beginBatch();
+    }
+}
+
+void FileTodoRepository::commitBatch()
+{
+    if (m_storage) {
+        m_storage->commitBatch();
+    }
+}
+
 } // namespace data
 } // namespace calendar
-
@@ -0,0 +1,221 @@
+#include "calendar/data/IcsDateTime.hpp"
+
+#include <QHash>
+#include <QTime>
+#include <optional>
+
+namespace calendar {
+namespace data {
+
+namespace {
+constexpr auto DATE_FORMAT = "yyyyMMdd";
+constexpr auto DATE_TIME_FORMAT = "yyyyMMdd'T'hhmmss'Z'";
+constexpr qint64 MSECS_PER_DAY = 24 * 60 * 60 * 1000;
+constexpr qint64 JULIAN_DAY_OF_EPOCH = 2440588;
+// The offset table of a thread is cleared when it grows beyond this many days.
+constexpr int MAX_OFFSET_SAMPLES = 1 << 16;
+
+qint64 floorDiv(qint64 value, qint64 divisor)
+{
+    return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+}
+
+bool readDigits(const char *data, int count, int &value)
+{
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        const char c = data[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+void writeDigits(QChar *out, int value, int count)
+{
+    for (int i = count - 1; i >= 0; --i) {
+        out[i] = QLatin1Char(static_cast<char>('0' + value % 10));
+        value /= 10;
+    }
+}
+
+bool isValidDate(int year, int month, int day)
+{
+    static constexpr int DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (year < 1 || month < 1 || month > 12 || day < 1) {
+        return false;
+    }
+    const int length = month == 2 && QDate::isLeapYear(year) ? 29 : DAYS_IN_MONTH[month - 1];
+    return day <= length;
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar (Howard Hinnant's algorithm).
+qint64 daysFromCivil(int year, int month, int day)
+{
+    const qint64 y = month <= 2 ? year - 1 : year;
+    const qint64 era = (y >= 0 ? y : y - 399) / 400;
+    const qint64 yearOfEra = y - era * 400;
+    const qint64 dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const qint64 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+void civilFromDays(qint64 days, int &year, int &month, int &day)
+{
+    days += 719468;
+    const qint64 era = (days >= 0 ? days : days - 146096) / 146097;
+    const qint64 dayOfEra = days - era * 146097;
+    const qint64 yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const qint64 dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const qint64 shiftedMonth = (5 * dayOfYear + 2) / 153;
+    day = static_cast<int>(dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+    month = static_cast<int>(shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+    year = static_cast<int>(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+// UTC offset in seconds of local time at the start of the given UTC day.
+qint32 offsetAtDayStart(qint64 day)
+{
+    // Parsing runs on several threads, so every thread keeps its own table.
+    thread_local QHash<qint64, qint32> samples;
+    const auto it = samples.constFind(day);
+    if (it != samples.constEnd()) {
+        return it.value();
+    }
+    if (samples.size() >= MAX_OFFSET_SAMPLES) {
+        samples.clear();
+    }
+    const qint32 offset = QDateTime::fromMSecsSinceEpoch(day * MSECS_PER_DAY).offsetFromUtc();
+    samples.insert(day, offset);
+    return offset;
+}
+
+// The offset of a UTC day if it holds from the start of the previous day to the end of the
+// next one. Local times near a transition may be ambiguous or skipped and are left to Qt.
+std::optional<qint32> stableOffset(qint64 day)
+{
+    const qint32 offset = offsetAtDayStart(day);
+    for (qint64 other = day - 1; other <= day + 2; ++other) {
+        if (other != day && offsetAtDayStart(other) != offset) {
+            return std::nullopt;
+        }
+    }
+    return offset;
+}
+
+std::optional<qint64> localToUtc(qint64 localMsecs)
+{
+    const qint64 localDay = floorDiv(localMsecs, MSECS_PER_DAY);
+    const auto offset = stableOffset(localDay);
+    if (!offset) {
+        return std::nullopt;
+    }
+    const qint64 utc = localMsecs - *offset * qint64(1000);
+    const qint64 utcDay = floorDiv(utc, MSECS_PER_DAY);
+    if (utcDay != localDay && stableOffset(utcDay) != offset) {
+        return std::nullopt;
+    }
+    return utc;
+}
+} // namespace
+
+QDateTime IcsDateTime::parse(const char *data, int size)
+{
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (size >= 8 && readDigits(data, 4, year) && readDigits(data + 4, 2, month)
+        && readDigits(data + 6, 2, day)) {
+        if (size == 8) {
+            if (!isValidDate(year, month, day)) {
+                return {};
+            }
+            if (const auto utc = localToUtc(daysFromCivil(year, month, day) * MSECS_PER_DAY)) {
+                return QDateTime::fromMSecsSinceEpoch(*utc);
+            }
+            return QDate(year, month, day).startOfDay();
+        }
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+        const bool utc = size == 16 && data[15] == 'Z';
+        if ((size == 15 || utc) && data[8] == 'T' && readDigits(data + 9, 2, hour)
+            && readDigits(data + 11, 2, minute) && readDigits(data + 13, 2, second)) {
+            if (!isValidDate(year, month, day) || hour > 23 || minute > 59 || second > 59) {
+                return {};
+            }
+            const qint64 msecs = daysFromCivil(year, month, day) * MSECS_PER_DAY
+                                 + ((hour * 60 + minute) * 60 + second) * qint64(1000);
+            // A local QDateTime always asks the C library for its offset once. Building it from
+            // the UTC instant costs one localtime() call; the QDate/QTime constructor would call
+            // mktime() instead, so local times are moved to UTC with the offset table first.
+            if (utc) {
+                return QDateTime::fromMSecsSinceEpoch(msecs);
+            }
+            if (const auto local = localToUtc(msecs)) {
+                return QDateTime::fromMSecsSinceEpoch(*local);
+            }
+            return QDateTime(QDate(year, month, day), QTime(hour, minute, second));
+        }
+    }
+    return QDateTime::fromString(QString::fromLatin1(data, size), Qt::ISODate);
+}
+
+QString IcsDateTime::format(const QDateTime &dateTime)
+{
+    if (!dateTime.isValid()) {
+        return {};
+    }
+    std::optional<qint64> utc;
+    if (dateTime.timeSpec() == Qt::LocalTime) {
+        // date() and time() are plain arithmetic; only toMSecsSinceEpoch() asks the C library.
+        const qint64 localDay = dateTime.date().toJulianDay() - JULIAN_DAY_OF_EPOCH;
+        utc = localToUtc(localDay * MSECS_PER_DAY + dateTime.time().msecsSinceStartOfDay());
+    } else if (dateTime.timeSpec() == Qt::UTC || dateTime.timeSpec() == Qt::OffsetFromUTC) {
+        utc = dateTime.toMSecsSinceEpoch();
+    }
+
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    const qint64 utcDay = utc ? floorDiv(*utc, MSECS_PER_DAY) : 0;
+    if (utc) {
+        civilFromDays(utcDay, year, month, day);
+    }
+    if (!utc || year < 1 || year > 9999) {
+        return dateTime.toUTC().toString(QLatin1String(DATE_TIME_FORMAT));
+    }
+
+    const auto secondOfDay = static_cast<int>((*utc - utcDay * MSECS_PER_DAY) / 1000);
+    QChar text[16];
+    writeDigits(text, year, 4);
+    writeDigits(text + 4, month, 2);
+    writeDigits(text + 6, day, 2);
+    text[8] = QLatin1Char('T');
+    writeDigits(text + 9, secondOfDay / 3600, 2);
+    writeDigits(text + 11, secondOfDay / 60 % 60, 2);
+    writeDigits(text + 13, secondOfDay % 60, 2);
+    text[15] = QLatin1Char('Z');
+    return QString(text, 16);
+}
+
+QString IcsDateTime::formatDate(const QDate &date)
+{
+    if (!date.isValid() || date.year() < 1 || date.year() > 9999) {
+        return date.toString(QLatin1String(DATE_FORMAT));
+    }
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    date.getDate(&year, &month, &day);
+    QChar text[8];
+    writeDigits(text, year, 4);
+    writeDigits(text + 4, month, 2);
+    writeDigits(text + 6, day, 2);
+    return QString(text, 8);
+}
+
+} // namespace data
+} // namespace calendar
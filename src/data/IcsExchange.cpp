@@ -0,0 +1,51 @@
+#include "calendar/data/IcsExchange.hpp"
+
+#include "calendar/data/CalendarSnapshot.hpp"
+#include "calendar/data/EventRepository.hpp"
+#include "calendar/data/IcsParser.hpp"
+#include "calendar/data/IcsWriter.hpp"
+#include "calendar/data/RepositoryBatch.hpp"
+#include "calendar/data/TodoRepository.hpp"
+
+#include <QFileInfo>
+
+namespace calendar {
+namespace data {
+
+int IcsExchange::importFile(const QString &icsPath, EventRepository &events, TodoRepository &todos)
+{
+    if (!QFileInfo(icsPath).isReadable()) {
+        return -1;
+    }
+    IcsParser::Collector collector;
+    const IcsParser::Result result = IcsParser::parseFileConcurrently(icsPath, collector);
+
+    RepositoryBatch batch(events, todos);
+    for (auto it = collector.events.constBegin(); it != collector.events.constEnd(); ++it) {
+        events.addEvent(it.value());
+    }
+    for (auto it = collector.todos.constBegin(); it != collector.todos.constEnd(); ++it) {
+        todos.addTodo(it.value());
+    }
+    return result.records;
+}
+
+bool IcsExchange::exportFile(const QString &icsPath,
+                             const EventRepository &events,
+                             const TodoRepository &todos,
+                             QString *errorString)
+{
+    CalendarSnapshot snapshot;
+    // The widest range QDate::startOfDay() still maps to a valid QDateTime on every platform.
+    const EventSnapshot stored = events.fetchEventSnapshot(QDate(100, 1, 1), QDate(9999, 12, 31));
+    for (const EventHandle &event : stored.handles()) {
+        snapshot.events.insert(event->id, event);
+    }
+    for (const TodoItem &todo : todos.fetchTodos()) {
+        snapshot.todos.insert(todo.id, todo);
+    }
+    return IcsWriter::writeCalendar(icsPath, snapshot, errorString);
+}
+
+} // namespace data
+} // namespace calendar
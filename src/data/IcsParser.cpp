@@ -0,0 +1,801 @@
+#include "calendar/data/IcsParser.hpp"
+
+#include "calendar/data/IcsDateTime.hpp"
+#include "calendar/data/Recurrence.hpp"
+
+#include <QByteArray>
+#include <QDate>
+#include <QFile>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <QTime>
+#include <QtConcurrent>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+namespace calendar {
+namespace data {
+
+namespace {
+// Inputs smaller than this per worker are not worth splitting.
+constexpr qint64 MIN_CONCURRENT_CHUNK_BYTES = 256 * 1024;
+// Namespace of the ids derived from UIDs that are not UUIDs.
+const QUuid UID_NAMESPACE(0x4d2f8c1a, 0x93b7, 0x4e05, 0xa6, 0x1d, 0x58, 0xc3, 0x0b, 0x7e, 0x92, 0xf4);
+
+struct Token {
+    const char *data = nullptr;
+    int size = 0;
+};
+
+bool equals(const Token &token, const char *literal)
+{
+    const int length = static_cast<int>(std::strlen(literal));
+    return token.size == length && std::memcmp(token.data, literal, static_cast<size_t>(length)) == 0;
+}
+
+bool equalsIgnoreCase(const Token &token, const char *literal)
+{
+    const int length = static_cast<int>(std::strlen(literal));
+    return token.size == length && qstrnicmp(token.data, literal, static_cast<uint>(length)) == 0;
+}
+
+bool containsIgnoreCase(const Token &token, const char *literal)
+{
+    const int length = static_cast<int>(std::strlen(literal));
+    for (int i = 0; i + length <= token.size; ++i) {
+        if (qstrnicmp(token.data + i, literal, static_cast<uint>(length)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Token trimmed(Token token)
+{
+    while (token.size > 0 && (token.data[0] == ' ' || token.data[0] == '\t')) {
+        ++token.data;
+        --token.size;
+    }
+    while (token.size > 0 && (token.data[token.size - 1] == ' ' || token.data[token.size - 1] == '\t')) {
+        --token.size;
+    }
+    return token;
+}
+
+int toInt(const Token &token)
+{
+    return QByteArray::fromRawData(token.data, token.size).toInt();
+}
+
+QUuid parseUid(const Token &token)
+{
+    QUuid id;
+    if (token.size == 36) {
+        char braced[38];
+        braced[0] = '{';
+        std::memcpy(braced + 1, token.data, 36);
+        braced[37] = '}';
+        id = QUuid::fromString(QLatin1String(braced, 38));
+    } else if (token.size > 0) {
+        id = QUuid::fromString(QLatin1String(token.data, token.size));
+    }
+    if (id.isNull() && token.size > 0) {
+        // UIDs of other programs are arbitrary text. The id derived from it has to be the same
+        // for every component sharing the UID, e.g. the overrides of a series.
+        return QUuid::createUuidV5(UID_NAMESPACE, QByteArray::fromRawData(token.data, token.size));
+    }
+    if (id.isNull()) {
+        return QUuid::createUuid();
+    }
+    return id;
+}
+
+QStringList splitList(const QString &value)
+{
+    const QStringList parts = value.split(',', Qt::SkipEmptyParts);
+    QStringList cleaned;
+    cleaned.reserve(parts.size());
+    for (const QString &part : parts) {
+        cleaned << part.trimmed();
+    }
+    return cleaned;
+}
+
+// Date-times separated by commas, as in EXDATE.
+void appendDateTimes(const Token &token, bool dateOnly, QList<QDateTime> &dateTimes)
+{
+    const char *cursor = token.data;
+    const char *end = token.data + token.size;
+    while (cursor < end) {
+        const auto *comma =
+            static_cast<const char *>(std::memchr(cursor, ',', static_cast<size_t>(end - cursor)));
+        const char *itemEnd = comma ? comma : end;
+        const Token item = trimmed(Token{cursor, static_cast<int>(itemEnd - cursor)});
+        QDateTime dateTime = IcsParser::parseDateTime(item.data, item.size);
+        if (dateTime.isValid()) {
+            if (dateOnly) {
+                dateTime.setTime(QTime(0, 0));
+            }
+            dateTimes.append(dateTime);
+        }
+        cursor = comma ? comma + 1 : end;
+    }
+}
+
+bool isTrue(const Token &token)
+{
+    return equalsIgnoreCase(token, "TRUE");
+}
+
+class LineParser
+{
+public:
+    // With indexEvents set, VEVENTs are reported as IcsEventRef with offsets relative to origin
+    // and only the properties needed for the index are decoded.
+    LineParser(IcsParser::Handler &handler, const char *origin, bool indexEvents)
+        : m_handler(handler)
+        , m_origin(origin)
+        , m_indexEvents(indexEvents)
+    {
+    }
+
+    // rawStart/rawEnd delimit the line in the input including folds and the line break.
+    void handleLine(const char *line, int size, const char *rawStart, const char *rawEnd)
+    {
+        const Token whole{line, size};
+        if (equals(whole, "BEGIN:VEVENT")) {
+            m_section = Section::Event;
+            m_event = CalendarEvent{};
+            m_componentOffset = rawStart - m_origin;
+            return;
+        }
+        if (equals(whole, "END:VEVENT")) {
+            finalizeEvent(rawEnd);
+            m_section = Section::None;
+            return;
+        }
+        if (equals(whole, "BEGIN:VTODO")) {
+            m_section = Section::Todo;
+            m_todo = TodoItem{};
+            return;
+        }
+        if (equals(whole, "END:VTODO")) {
+            finalizeTodo();
+            m_section = Section::None;
+            return;
+        }
+
+        const char *colon = static_cast<const char *>(std::memchr(line, ':', static_cast<size_t>(size)));
+        if (!colon || colon == line) {
+            return;
+        }
+        const Token property{line, static_cast<int>(colon - line)};
+        const Token value{colon + 1, static_cast<int>(line + size - colon - 1)};
+        const char *semicolon = static_cast<const char *>(
+            std::memchr(property.data, ';', static_cast<size_t>(property.size)));
+        const Token name{property.data, semicolon ? static_cast<int>(semicolon - property.data) : property.size};
+        const Token parameters = semicolon
+                                     ? Token{semicolon + 1, static_cast<int>(property.data + property.size - semicolon - 1)}
+                                     : Token{};
+
+        switch (m_section) {
+        case Section::None:
+            handleTopLevel(name, value);
+            break;
+        case Section::Event:
+            if (!m_indexEvents || isIndexedEventProperty(name)) {
+                handleEventProperty(name, parameters, value);
+            }
+            break;
+        case Section::Todo:
+            handleTodoProperty(name, parameters, value);
+            break;
+        }
+    }
+
+    IcsParser::Result result() const
+    {
+        IcsParser::Result result;
+        result.records = m_records;
+        result.complete = m_section == Section::None;
+        return result;
+    }
+
+private:
+    enum class Section {
+        None,
+        Event,
+        Todo
+    };
+
+    // RRULE and RECURRENCE-ID tell whether the event belongs to a series, and the latter is
+    // part of the id of an override.
+    static bool isIndexedEventProperty(const Token &name)
+    {
+        return equalsIgnoreCase(name, "UID") || equalsIgnoreCase(name, "DTSTART")
+               || equalsIgnoreCase(name, "DTEND") || equalsIgnoreCase(name, "RRULE")
+               || equalsIgnoreCase(name, "RECURRENCE-ID");
+    }
+
+    void handleTopLevel(const Token &name, const Token &value)
+    {
+        if (equalsIgnoreCase(name, IcsParser::DeletedEventProperty)) {
+            m_handler.eventRemoved(parseUid(trimmed(value)));
+            ++m_records;
+        } else if (equalsIgnoreCase(name, IcsParser::DeletedTodoProperty)) {
+            m_handler.todoRemoved(parseUid(trimmed(value)));
+            ++m_records;
+        } else if (equalsIgnoreCase(name, IcsParser::RevisionProperty)) {
+            const Token revision = trimmed(value);
+            m_handler.revisionParsed(QByteArray::fromRawData(revision.data, revision.size).toLongLong());
+        }
+    }
+
+    void handleEventProperty(const Token &name, const Token &parameters, const Token &value)
+    {
+        if (equalsIgnoreCase(name, "UID")) {
+            m_event.id = parseUid(value);
+        } else if (equalsIgnoreCase(name, "SUMMARY")) {
+            m_event.title = IcsParser::decodeText(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "DESCRIPTION")) {
+            m_event.description = IcsParser::decodeText(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "LOCATION")) {
+            m_event.location = IcsParser::decodeText(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "DTSTART")) {
+            m_event.start = IcsParser::parseDateTime(value.data, value.size);
+            m_event.allDay = containsIgnoreCase(parameters, "VALUE=DATE") || value.size == 8;
+            if (m_event.allDay && m_event.start.isValid()) {
+                m_event.start.setTime(QTime(0, 0));
+            }
+        } else if (equalsIgnoreCase(name, "DTEND")) {
+            m_event.end = IcsParser::parseDateTime(value.data, value.size);
+            if (m_event.allDay && m_event.end.isValid()) {
+                m_event.end.setTime(QTime(0, 0));
+            }
+        } else if (equalsIgnoreCase(name, "CATEGORIES")) {
+            m_event.categories = splitList(IcsParser::decodeText(value.data, value.size));
+        } else if (equalsIgnoreCase(name, "RRULE")) {
+            m_event.recurrenceRule = QString::fromUtf8(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "RECURRENCE-ID")) {
+            m_event.recurrenceId = IcsParser::parseDateTime(value.data, value.size);
+            if ((containsIgnoreCase(parameters, "VALUE=DATE") || value.size == 8)
+                && m_event.recurrenceId.isValid()) {
+                m_event.recurrenceId.setTime(QTime(0, 0));
+            }
+        } else if (equalsIgnoreCase(name, "EXDATE")) {
+            appendDateTimes(value, containsIgnoreCase(parameters, "VALUE=DATE"), m_event.exceptionDates);
+        } else if (equalsIgnoreCase(name, "X-TASKMASTER-REMINDER")) {
+            m_event.reminderMinutes = toInt(value);
+        } else if (equalsIgnoreCase(name, "X-TASKMASTER-ALLDAY")) {
+            m_event.allDay = isTrue(value);
+        }
+    }
+
+    void handleTodoProperty(const Token &name, const Token &parameters, const Token &value)
+    {
+        if (equalsIgnoreCase(name, "UID")) {
+            m_todo.id = parseUid(value);
+        } else if (equalsIgnoreCase(name, "SUMMARY")) {
+            m_todo.title = IcsParser::decodeText(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "DESCRIPTION")) {
+            m_todo.description = IcsParser::decodeText(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "LOCATION")) {
+            m_todo.location = IcsParser::decodeText(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "DUE")) {
+            m_todo.dueDate = IcsParser::parseDateTime(value.data, value.size);
+            if (containsIgnoreCase(parameters, "VALUE=DATE") && m_todo.dueDate.isValid()) {
+                m_todo.dueDate.setTime(QTime(0, 0));
+            }
+        } else if (equalsIgnoreCase(name, "PRIORITY")) {
+            m_todo.priority = toInt(value);
+        } else if (equalsIgnoreCase(name, "STATUS")) {
+            m_todo.status = IcsParser::statusFromString(value.data, value.size);
+        } else if (equalsIgnoreCase(name, "CATEGORIES")) {
+            m_todo.tags = splitList(IcsParser::decodeText(value.data, value.size));
+        } else if (equalsIgnoreCase(name, "X-TASKMASTER-SCHEDULED")) {
+            m_todo.scheduled = isTrue(value);
+        } else if (equalsIgnoreCase(name, "X-TASKMASTER-DURATION")) {
+            m_todo.durationMinutes = toInt(value);
+        }
+    }
+
+    void finalizeEvent(const char *rawEnd)
+    {
+        if (m_event.id.isNull()) {
+            m_event.id = QUuid::createUuid();
+        }
+        if (!m_event.end.isValid() || m_event.end <= m_event.start) {
+            m_event.end = m_event.start.addSecs(30 * 60);
+        }
+        // An override shares its UID with the series; its own id is the one of the occurrence
+        // it replaces.
+        if (m_event.recurrenceId.isValid()) {
+            m_event.seriesId = m_event.id;
+            m_event.id = Recurrence::occurrenceId(m_event.seriesId, m_event.recurrenceId);
+        }
+        if (m_indexEvents) {
+            IcsEventRef ref;
+            ref.id = m_event.id;
+            ref.start = m_event.start;
+            ref.end = m_event.end;
+            ref.inSeries = Recurrence::belongsToSeries(m_event);
+            ref.offset = m_componentOffset;
+            ref.length = static_cast<int>(rawEnd - m_origin - m_componentOffset);
+            m_handler.eventIndexed(ref);
+        } else {
+            m_handler.eventParsed(std::move(m_event));
+        }
+        m_event = CalendarEvent{};
+        ++m_records;
+    }
+
+    void finalizeTodo()
+    {
+        if (m_todo.id.isNull()) {
+            m_todo.id = QUuid::createUuid();
+        }
+        m_handler.todoParsed(std::move(m_todo));
+        m_todo = TodoItem{};
+        ++m_records;
+    }
+
+    IcsParser::Handler &m_handler;
+    const char *m_origin = nullptr;
+    const bool m_indexEvents = false;
+    qint64 m_componentOffset = 0;
+    Section m_section = Section::None;
+    CalendarEvent m_event;
+    TodoItem m_todo;
+    int m_records = 0;
+};
+
+template <typename Char>
+Char *findLineEnd(Char *from, Char *end)
+{
+    auto *newline = static_cast<Char *>(std::memchr(from, '\n', static_cast<size_t>(end - from)));
+    return newline ? newline : end;
+}
+
+template <typename Char>
+Char *stripCarriageReturn(Char *lineStart, Char *lineEnd)
+{
+    if (lineEnd > lineStart && lineEnd[-1] == '\r') {
+        return lineEnd - 1;
+    }
+    return lineEnd;
+}
+
+bool startsComponent(const char *line, const char *end)
+{
+    static constexpr char beginEvent[] = "BEGIN:VEVENT";
+    static constexpr char beginTodo[] = "BEGIN:VTODO";
+    const auto available = static_cast<size_t>(end - line);
+    return (available >= sizeof(beginEvent) - 1 && std::memcmp(line, beginEvent, sizeof(beginEvent) - 1) == 0)
+           || (available >= sizeof(beginTodo) - 1 && std::memcmp(line, beginTodo, sizeof(beginTodo) - 1) == 0);
+}
+
+// First line at or after from that begins a component, or end. Such a line is never a folded
+// continuation, so every chunk can be unfolded without touching its neighbours.
+const char *nextComponentStart(const char *from, const char *begin, const char *end)
+{
+    const char *cursor = from;
+    if (cursor > begin && cursor[-1] != '\n') {
+        cursor = findLineEnd(cursor, end);
+        cursor = cursor < end ? cursor + 1 : end;
+    }
+    while (cursor < end) {
+        if (startsComponent(cursor, end)) {
+            return cursor;
+        }
+        cursor = findLineEnd(cursor, end);
+        cursor = cursor < end ? cursor + 1 : end;
+    }
+    return end;
+}
+
+const char *skipByteOrderMark(const char *begin, const char *end)
+{
+    if (end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0) {
+        return begin + 3;
+    }
+    return begin;
+}
+
+// RFC 5545 unfolding: continuation lines start with a space or tab. Their contents are moved
+// directly behind the line they continue, which never overlaps unread input.
+void scanInPlace(char *begin, char *end, LineParser &parser)
+{
+    char *cursor = begin;
+    while (cursor < end) {
+        char *lineStart = cursor;
+        char *newline = findLineEnd(cursor, end);
+        char *lineEnd = stripCarriageReturn(lineStart, newline);
+        cursor = newline < end ? newline + 1 : end;
+
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+            char *continuationStart = cursor + 1;
+            char *continuationNewline = findLineEnd(continuationStart, end);
+            char *continuationEnd = stripCarriageReturn(continuationStart, continuationNewline);
+            const auto length = static_cast<size_t>(continuationEnd - continuationStart);
+            std::memmove(lineEnd, continuationStart, length);
+            lineEnd += length;
+            cursor = continuationNewline < end ? continuationNewline + 1 : end;
+        }
+
+        parser.handleLine(lineStart, static_cast<int>(lineEnd - lineStart), lineStart, cursor);
+    }
+}
+
+// Same as scanInPlace for input that must not be modified; folded lines are joined in a
+// scratch buffer instead.
+void scanReadOnly(const char *begin, const char *end, LineParser &parser)
+{
+    QByteArray scratch;
+    scratch.reserve(256);
+    const char *cursor = begin;
+    while (cursor < end) {
+        const char *lineStart = cursor;
+        const char *newline = findLineEnd(cursor, end);
+        const char *lineEnd = stripCarriageReturn(lineStart, newline);
+        cursor = newline < end ? newline + 1 : end;
+
+        if (cursor >= end || (*cursor != ' ' && *cursor != '\t')) {
+            parser.handleLine(lineStart, static_cast<int>(lineEnd - lineStart), lineStart, cursor);
+            continue;
+        }
+
+        scratch.resize(0);
+        scratch.append(lineStart, static_cast<int>(lineEnd - lineStart));
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+            const char *continuationStart = cursor + 1;
+            const char *continuationNewline = findLineEnd(continuationStart, end);
+            const char *continuationEnd = stripCarriageReturn(continuationStart, continuationNewline);
+            scratch.append(continuationStart, static_cast<int>(continuationEnd - continuationStart));
+            cursor = continuationNewline < end ? continuationNewline + 1 : end;
+        }
+        parser.handleLine(scratch.constData(), scratch.size(), lineStart, cursor);
+    }
+}
+
+class SingleEventHandler : public IcsParser::Handler
+{
+public:
+    void eventParsed(CalendarEvent parsed) override { event = std::move(parsed); }
+    void todoParsed(TodoItem todo) override { Q_UNUSED(todo); }
+
+    std::optional<CalendarEvent> event;
+};
+
+// Collects one chunk. Removals are remembered so they can be replayed against the chunks
+// before it during the merge.
+class ChunkCollector : public IcsParser::Collector
+{
+public:
+    void eventParsed(CalendarEvent event) override
+    {
+        removedEvents.remove(event.id);
+        Collector::eventParsed(std::move(event));
+    }
+
+    void eventIndexed(const IcsEventRef &ref) override
+    {
+        removedEvents.remove(ref.id);
+        Collector::eventIndexed(ref);
+    }
+
+    void todoParsed(TodoItem todo) override
+    {
+        removedTodos.remove(todo.id);
+        Collector::todoParsed(std::move(todo));
+    }
+
+    void eventRemoved(const QUuid &id) override
+    {
+        Collector::eventRemoved(id);
+        removedEvents.insert(id);
+    }
+
+    void todoRemoved(const QUuid &id) override
+    {
+        Collector::todoRemoved(id);
+        removedTodos.insert(id);
+    }
+
+    QSet<QUuid> removedEvents;
+    QSet<QUuid> removedTodos;
+};
+
+struct Chunk {
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    ChunkCollector collector;
+    IcsParser::Result result;
+};
+
+// Writable view of a file: a private mapping when possible, otherwise a copy.
+class FileBuffer
+{
+public:
+    explicit FileBuffer(const QString &filePath)
+        : m_file(filePath)
+    {
+        if (!m_file.exists() || !m_file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        const qint64 size = m_file.size();
+        if (size <= 0) {
+            return;
+        }
+        // A private mapping is copy-on-write: unfolding lines in place only copies the touched
+        // pages and never changes the file.
+        m_mapped = m_file.map(0, size, QFileDevice::MapPrivateOption);
+        if (m_mapped) {
+            m_begin = reinterpret_cast<char *>(m_mapped);
+            m_end = m_begin + size;
+            return;
+        }
+        m_copy = m_file.readAll();
+        m_begin = m_copy.data();
+        m_end = m_begin + m_copy.size();
+    }
+
+    ~FileBuffer()
+    {
+        if (m_mapped) {
+            m_file.unmap(m_mapped);
+        }
+    }
+
+    FileBuffer(const FileBuffer &) = delete;
+    FileBuffer &operator=(const FileBuffer &) = delete;
+
+    bool isEmpty() const { return m_begin == m_end; }
+    char *begin() const { return m_begin; }
+    char *end() const { return m_end; }
+
+private:
+    QFile m_file;
+    uchar *m_mapped = nullptr;
+    QByteArray m_copy;
+    char *m_begin = nullptr;
+    char *m_end = nullptr;
+};
+} // namespace
+
+void IcsParser::Handler::eventRemoved(const QUuid &id)
+{
+    Q_UNUSED(id);
+}
+
+void IcsParser::Handler::todoRemoved(const QUuid &id)
+{
+    Q_UNUSED(id);
+}
+
+void IcsParser::Handler::eventIndexed(const IcsEventRef &ref)
+{
+    Q_UNUSED(ref);
+}
+
+void IcsParser::Handler::revisionParsed(qint64 revision)
+{
+    Q_UNUSED(revision);
+}
+
+void IcsParser::Collector::eventParsed(CalendarEvent event)
+{
+    const QUuid id = event.id;
+    eventRefs.remove(id);
+    events.insert(id, std::move(event));
+}
+
+void IcsParser::Collector::eventIndexed(const IcsEventRef &ref)
+{
+    events.remove(ref.id);
+    eventRefs.insert(ref.id, ref);
+}
+
+void IcsParser::Collector::todoParsed(TodoItem todo)
+{
+    const QUuid id = todo.id;
+    todos.insert(id, std::move(todo));
+}
+
+void IcsParser::Collector::eventRemoved(const QUuid &id)
+{
+    events.remove(id);
+    eventRefs.remove(id);
+}
+
+void IcsParser::Collector::todoRemoved(const QUuid &id)
+{
+    todos.remove(id);
+}
+
+void IcsParser::Collector::revisionParsed(qint64 revision)
+{
+    this->revision = revision;
+}
+
+IcsParser::Result IcsParser::parseFile(const QString &filePath, Handler &handler)
+{
+    FileBuffer buffer(filePath);
+    if (buffer.isEmpty()) {
+        return {};
+    }
+    return parse(buffer.begin(), buffer.end(), handler);
+}
+
+IcsParser::Result IcsParser::parseFileConcurrently(const QString &filePath, Collector &collector)
+{
+    FileBuffer buffer(filePath);
+    if (buffer.isEmpty()) {
+        return {};
+    }
+    return parseConcurrently(buffer.begin(), buffer.end(), collector);
+}
+
+IcsParser::Result IcsParser::parse(char *begin, char *end, Handler &handler)
+{
+    LineParser parser(handler, begin, false);
+    const auto byteOrderMark = skipByteOrderMark(begin, end) - begin;
+    scanInPlace(begin + byteOrderMark, end, parser);
+    return parser.result();
+}
+
+IcsParser::Result IcsParser::index(const char *begin, const char *end, Handler &handler)
+{
+    LineParser parser(handler, begin, true);
+    scanReadOnly(skipByteOrderMark(begin, end), end, parser);
+    return parser.result();
+}
+
+std::optional<CalendarEvent> IcsParser::parseEvent(const char *data, int size)
+{
+    QByteArray record(data, size);
+    SingleEventHandler handler;
+    parse(record.data(), record.data() + record.size(), handler);
+    return handler.event;
+}
+
+IcsParser::Result IcsParser::parseConcurrently(char *begin, char *end, Collector &collector)
+{
+    return parseChunks(begin, end, collector, false);
+}
+
+IcsParser::Result IcsParser::indexConcurrently(const char *begin, const char *end, Collector &collector)
+{
+    return parseChunks(begin, end, collector, true);
+}
+
+IcsParser::Result IcsParser::parseChunks(const char *begin,
+                                         const char *end,
+                                         Collector &collector,
+                                         bool indexEvents)
+{
+    const qint64 size = end - begin;
+    const int chunkCount = static_cast<int>(
+        qBound<qint64>(1, size / MIN_CONCURRENT_CHUNK_BYTES, QThread::idealThreadCount()));
+
+    std::vector<Chunk> chunks;
+    chunks.reserve(static_cast<size_t>(chunkCount));
+    const char *chunkBegin = skipByteOrderMark(begin, end);
+    for (int i = 1; i <= chunkCount && chunkBegin < end; ++i) {
+        const char *chunkEnd
+            = i == chunkCount ? end : nextComponentStart(begin + size * i / chunkCount, begin, end);
+        if (chunkEnd <= chunkBegin) {
+            continue;
+        }
+        chunks.emplace_back();
+        chunks.back().begin = chunkBegin;
+        chunks.back().end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    // Offsets are reported relative to begin, whichever chunk a record is in. In full mode the
+    // caller handed in a writable buffer, so every chunk unfolds its own range in place.
+    const auto parseChunk = [begin, indexEvents](Chunk &chunk) {
+        LineParser parser(chunk.collector, begin, indexEvents);
+        if (indexEvents) {
+            scanReadOnly(chunk.begin, chunk.end, parser);
+        } else {
+            scanInPlace(const_cast<char *>(chunk.begin), const_cast<char *>(chunk.end), parser);
+        }
+        chunk.result = parser.result();
+    };
+    if (chunks.size() == 1) {
+        parseChunk(chunks.front());
+    } else {
+        QtConcurrent::blockingMap(chunks, parseChunk);
+    }
+
+    // Chunks are merged in file order, so later records win exactly as in a sequential parse.
+    Result result;
+    for (Chunk &chunk : chunks) {
+        for (const QUuid &id : qAsConst(chunk.collector.removedEvents)) {
+            collector.eventRemoved(id);
+        }
+        for (const QUuid &id : qAsConst(chunk.collector.removedTodos)) {
+            collector.todoRemoved(id);
+        }
+        if (collector.events.isEmpty() && collector.eventRefs.isEmpty() && collector.todos.isEmpty()) {
+            collector.events = std::move(chunk.collector.events);
+            collector.eventRefs = std::move(chunk.collector.eventRefs);
+            collector.todos = std::move(chunk.collector.todos);
+        } else {
+            for (auto it = chunk.collector.events.begin(); it != chunk.collector.events.end(); ++it) {
+                collector.eventParsed(std::move(it.value()));
+            }
+            for (auto it = chunk.collector.eventRefs.constBegin(); it != chunk.collector.eventRefs.constEnd();
+                 ++it) {
+                collector.eventIndexed(it.value());
+            }
+            for (auto it = chunk.collector.todos.begin(); it != chunk.collector.todos.end(); ++it) {
+                collector.todoParsed(std::move(it.value()));
+            }
+        }
+        if (chunk.collector.revision != 0) {
+            collector.revisionParsed(chunk.collector.revision);
+        }
+        result.records += chunk.result.records;
+        result.complete = chunk.result.complete;
+    }
+    return result;
+}
+
+QString IcsParser::decodeText(const char *data, int size)
+{
+    if (!std::memchr(data, '\\', static_cast<size_t>(size))) {
+        return QString::fromUtf8(data, size);
+    }
+
+    QByteArray decoded;
+    decoded.reserve(size);
+    for (int i = 0; i < size; ++i) {
+        const char c = data[i];
+        if (c != '\\' || i + 1 >= size) {
+            decoded.append(c);
+            continue;
+        }
+        const char next = data[i + 1];
+        switch (next) {
+        case 'n':
+        case 'N':
+            decoded.append('\n');
+            ++i;
+            break;
+        case ',':
+        case ';':
+        case '\\':
+            decoded.append(next);
+            ++i;
+            break;
+        default:
+            decoded.append(c);
+            break;
+        }
+    }
+    return QString::fromUtf8(decoded);
+}
+
+QDateTime IcsParser::parseDateTime(const char *data, int size)
+{
+    return IcsDateTime::parse(data, size);
+}
+
+TodoStatus IcsParser::statusFromString(const char *data, int size)
+{
+    const Token token{data, size};
+    if (equalsIgnoreCase(token, "COMPLETED")) {
+        return TodoStatus::Completed;
+    }
+    if (equalsIgnoreCase(token, "IN-PROCESS")) {
+        return TodoStatus::InProgress;
+    }
+    return TodoStatus::Pending;
+}
+
+} // namespace data
+} // namespace calendar
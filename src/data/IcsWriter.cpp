@@ -0,0 +1,247 @@
+#include "calendar/data/IcsWriter.hpp"
+
+#include "calendar/data/CalendarCache.hpp"
+#include "calendar/data/IcsDateTime.hpp"
+#include "calendar/data/IcsParser.hpp"
+#include "calendar/data/Recurrence.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <vector>
+
+namespace calendar {
+namespace data {
+
+namespace {
+QString prepareUid(const QUuid &id)
+{
+    return id.toString(QUuid::WithoutBraces);
+}
+
+QString formatEventTime(const CalendarEvent &event, const QDateTime &dateTime)
+{
+    return event.allDay ? IcsDateTime::formatDate(dateTime.date()) : IcsDateTime::format(dateTime);
+}
+} // namespace
+
+void IcsWriter::writeEvent(QTextStream &stream, const CalendarEvent &event)
+{
+    stream << "BEGIN:VEVENT\n";
+    const bool isOverride = Recurrence::isOverride(event);
+    // An override is identified by the UID of its series plus RECURRENCE-ID.
+    stream << "UID:" << prepareUid(isOverride ? event.seriesId : event.id) << '\n';
+    stream << "SUMMARY:" << encodeText(event.title) << '\n';
+    if (!event.description.isEmpty()) {
+        stream << "DESCRIPTION:" << encodeText(event.description) << '\n';
+    }
+    if (!event.location.isEmpty()) {
+        stream << "LOCATION:" << encodeText(event.location) << '\n';
+    }
+    const char *dateParameter = event.allDay ? ";VALUE=DATE:" : ":";
+    stream << "DTSTART" << dateParameter << formatEventTime(event, event.start) << '\n';
+    stream << "DTEND" << dateParameter << formatEventTime(event, event.end) << '\n';
+    if (isOverride) {
+        stream << "RECURRENCE-ID" << dateParameter << formatEventTime(event, event.recurrenceId) << '\n';
+    }
+    if (!event.categories.isEmpty()) {
+        stream << "CATEGORIES:" << encodeText(event.categories.join(',')) << '\n';
+    }
+    if (!event.recurrenceRule.isEmpty()) {
+        stream << "RRULE:" << event.recurrenceRule << '\n';
+    }
+    for (const QDateTime &exception : event.exceptionDates) {
+        stream << "EXDATE" << dateParameter << formatEventTime(event, exception) << '\n';
+    }
+    if (event.reminderMinutes > 0) {
+        stream << "X-TASKMASTER-REMINDER:" << event.reminderMinutes << '\n';
+    }
+    if (event.allDay) {
+        stream << "X-TASKMASTER-ALLDAY:TRUE\n";
+    }
+    stream << "END:VEVENT\n";
+}
+
+void IcsWriter::writeTodo(QTextStream &stream, const TodoItem &todo)
+{
+    stream << "BEGIN:VTODO\n";
+    stream << "UID:" << prepareUid(todo.id) << '\n';
+    stream << "SUMMARY:" << encodeText(todo.title) << '\n';
+    if (!todo.description.isEmpty()) {
+        stream << "DESCRIPTION:" << encodeText(todo.description) << '\n';
+    }
+    if (!todo.location.isEmpty()) {
+        stream << "LOCATION:" << encodeText(todo.location) << '\n';
+    }
+    if (todo.dueDate.isValid()) {
+        stream << "DUE:" << formatDateTime(todo.dueDate) << '\n';
+    }
+    if (todo.priority > 0) {
+        stream << "PRIORITY:" << todo.priority << '\n';
+    }
+    stream << "STATUS:" << statusToString(todo.status) << '\n';
+    if (!todo.tags.isEmpty()) {
+        stream << "CATEGORIES:" << encodeText(todo.tags.join(',')) << '\n';
+    }
+    if (todo.scheduled) {
+        stream << "X-TASKMASTER-SCHEDULED:TRUE\n";
+    }
+    if (todo.durationMinutes > 0) {
+        stream << "X-TASKMASTER-DURATION:" << todo.durationMinutes << '\n';
+    }
+    stream << "END:VTODO\n";
+}
+
+QString IcsWriter::eventRecord(const CalendarEvent &event)
+{
+    QString record;
+    QTextStream stream(&record);
+    writeEvent(stream, event);
+    stream.flush();
+    return record;
+}
+
+QString IcsWriter::todoRecord(const TodoItem &todo)
+{
+    QString record;
+    QTextStream stream(&record);
+    writeTodo(stream, todo);
+    stream.flush();
+    return record;
+}
+
+bool IcsWriter::writeCalendar(const QString &filePath,
+                              const CalendarSnapshot &snapshot,
+                              QString *errorString,
+                              QHash<QUuid, IcsEventRef> *writtenEvents,
+                              IcsSourceState *writtenState)
+{
+    if (filePath.isEmpty()) {
+        return false;
+    }
+
+    QFileInfo info(filePath);
+    QDir dir = info.dir();
+    if (!dir.exists()) {
+        dir.mkpath(QStringLiteral("."));
+    }
+
+    struct EventEntry {
+        QDateTime start;
+        const CalendarEvent *event = nullptr;
+        const IcsEventRef *ref = nullptr;
+    };
+    std::vector<EventEntry> entries;
+    entries.reserve(static_cast<size_t>(snapshot.events.size() + snapshot.eventRefs.size()));
+    for (auto it = snapshot.events.constBegin(); it != snapshot.events.constEnd(); ++it) {
+        entries.push_back({it.value()->start, it.value().get(), nullptr});
+    }
+    for (auto it = snapshot.eventRefs.constBegin(); it != snapshot.eventRefs.constEnd(); ++it) {
+        const IcsEventRef &ref = it.value();
+        if (!snapshot.events.contains(it.key()) && ref.offset >= 0
+            && ref.offset + ref.length <= snapshot.source.size()) {
+            entries.push_back({ref.start, nullptr, &ref});
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const EventEntry &lhs, const EventEntry &rhs) {
+        return lhs.start < rhs.start;
+    });
+
+    // The file is assembled in memory so the offset of every event is known for the cache.
+    QByteArray contents;
+    contents.reserve(snapshot.source.size() + snapshot.events.size() * 256);
+    contents += "BEGIN:VCALENDAR\n";
+    contents += "VERSION:2.0\n";
+    contents += "PRODID:-//Block Master//EN\n";
+    if (snapshot.revision > 0) {
+        contents += IcsParser::RevisionProperty;
+        contents += ':';
+        contents += QByteArray::number(snapshot.revision);
+        contents += '\n';
+    }
+
+    for (const EventEntry &entry : entries) {
+        const qint64 offset = contents.size();
+        IcsEventRef written;
+        if (entry.event) {
+            contents += eventRecord(*entry.event).toUtf8();
+            written.id = entry.event->id;
+            written.end = entry.event->end;
+            written.inSeries = Recurrence::belongsToSeries(*entry.event);
+        } else {
+            contents.append(snapshot.source.constData() + entry.ref->offset, entry.ref->length);
+            if (!contents.endsWith('\n')) {
+                contents += '\n';
+            }
+            written.id = entry.ref->id;
+            written.end = entry.ref->end;
+            written.inSeries = entry.ref->inSeries;
+        }
+        if (writtenEvents) {
+            written.start = entry.start;
+            written.offset = offset;
+            written.length = static_cast<int>(contents.size() - offset);
+            writtenEvents->insert(written.id, written);
+        }
+    }
+
+    auto sortedTodos = snapshot.todos.values();
+    std::sort(sortedTodos.begin(), sortedTodos.end(), [](const TodoItem &lhs, const TodoItem &rhs) {
+        return lhs.priority > rhs.priority;
+    });
+    for (const TodoItem &todo : sortedTodos) {
+        contents += todoRecord(todo).toUtf8();
+    }
+
+    contents += "END:VCALENDAR\n";
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    if (file.write(contents) != contents.size() || !file.commit()) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    if (writtenState) {
+        *writtenState = CalendarCache::writtenSource(filePath, contents);
+    }
+    return true;
+}
+
+QString IcsWriter::encodeText(const QString &text)
+{
+    QString encoded = text;
+    encoded.replace('\\', "\\\\");
+    encoded.replace('\n', "\\n");
+    encoded.replace(',', "\\,");
+    encoded.replace(';', "\\;");
+    return encoded;
+}
+
+QString IcsWriter::formatDateTime(const QDateTime &dt)
+{
+    return IcsDateTime::format(dt);
+}
+
+QString IcsWriter::statusToString(TodoStatus status)
+{
+    switch (status) {
+    case TodoStatus::Completed:
+        return QStringLiteral("COMPLETED");
+    case TodoStatus::InProgress:
+        return QStringLiteral("IN-PROCESS");
+    case TodoStatus::Pending:
+    default:
+        return QStringLiteral("NEEDS-ACTION");
+    }
+}
+
+} // namespace data
+} // namespace calendar
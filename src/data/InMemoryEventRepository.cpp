@@ -1,5 +1,9 @@
 #include "calendar/data/InMemoryEventRepository.hpp"
 
+#include "calendar/data/Recurrence.hpp"
+
+#include <algorithm>
+
 namespace calendar {
 namespace data {
 
@@ -8,22 +12,54 @@ InMemoryEventRepository::~InMemoryEventRepository() = default;
 
 std::vector<CalendarEvent> InMemoryEventRepository::fetchEvents(const QDate &from, const QDate &to) const
 {
+    if (!from.isValid() || !to.isValid()) {
+        return {};
+    }
+    const qint64 fromMs = from.startOfDay().toMSecsSinceEpoch();
+    const qint64 toMs = to.addDays(1).startOfDay().toMSecsSinceEpoch() - 1;
     std::vector<CalendarEvent> events;
-    for (const auto &event : m_events) {
-        if (event.end.date() < from || event.start.date() > to) {
-            continue;
-        }
+    for (const QUuid &id : m_index.overlapping(fromMs, toMs)) {
+        events.push_back(m_events.value(id));
+    }
+    return events;
+}
+
+QFuture<EventSnapshot> InMemoryEventRepository::fetchAllEventsAsync(const CancellationToken &token) const
+{
+    if (token.isCancelled()) {
+        return finishedEventQuery({});
+    }
+    std::vector<CalendarEvent> events;
+    events.reserve(static_cast<size_t>(m_events.size()));
+    for (const CalendarEvent &event : m_events) {
         events.push_back(event);
     }
+    return finishedEventQuery(EventSnapshot::fromEvents(std::move(events)));
+}
+
+std::vector<CalendarEvent> InMemoryEventRepository::fetchSeriesEvents() const
+{
+    std::vector<CalendarEvent> events;
+    events.reserve(static_cast<size_t>(m_seriesIds.size()));
+    for (const QUuid &id : m_seriesIds) {
+        events.push_back(m_events.value(id));
+    }
+    std::sort(events.begin(), events.end(), [](const CalendarEvent &lhs, const CalendarEvent &rhs) {
+        if (lhs.start == rhs.start) {
+            return lhs.end < rhs.end;
+        }
+        return lhs.start < rhs.start;
+    });
     return events;
 }
 
 std::optional<CalendarEvent> InMemoryEventRepository::findById(const QUuid &id) const
 {
-    if (m_events.contains(id)) {
-        return m_events.value(id);
+    const auto it = m_events.constFind(id);
+    if (it == m_events.constEnd()) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    return it.value();
 }
 
 CalendarEvent InMemoryEventRepository::addEvent(CalendarEvent event)
@@ -38,6 +74,7 @@ CalendarEvent InMemoryEventRepository::addEvent(CalendarEvent event)
         event.reminderMinutes = 0;
     }
     m_events.insert(event.id, event);
+    index(event);
     return event;
 }
 
@@ -47,13 +84,31 @@ bool InMemoryEventRepository::updateEvent(const CalendarEvent &event)
         return false;
     }
     m_events.insert(event.id, event);
+    index(event);
     return true;
 }
 
 bool InMemoryEventRepository::removeEvent(const QUuid &id)
 {
+    m_index.remove(id);
+    m_seriesIds.remove(id);
     return m_events.remove(id) > 0;
 }
 
+void InMemoryEventRepository::index(const CalendarEvent &event)
+{
+    if (Recurrence::belongsToSeries(event)) {
+        m_seriesIds.insert(event.id);
+    } else {
+        m_seriesIds.remove(event.id);
+    }
+    // Events without a valid time span can never match a date range.
+    if (!event.start.isValid() || !event.end.isValid()) {
+        m_index.remove(event.id);
+        return;
+    }
+    m_index.insert(event.id, event.start.toMSecsSinceEpoch(), event.end.toMSecsSinceEpoch());
+}
+
 } // namespace data
 } // namespace calendar
@@ -0,0 +1,116 @@
+#include "calendar/data/ObservableEventRepository.hpp"
+
+namespace calendar {
+namespace data {
+
+ObservableEventRepository::ObservableEventRepository(EventRepository &repository, QObject *parent)
+    : QObject(parent)
+    , m_repository(repository)
+{
+}
+
+ObservableEventRepository::~ObservableEventRepository() = default;
+
+std::vector<CalendarEvent> ObservableEventRepository::fetchEvents(const QDate &from, const QDate &to) const
+{
+    return m_repository.fetchEvents(from, to);
+}
+
+EventSnapshot ObservableEventRepository::fetchEventSnapshot(const QDate &from, const QDate &to) const
+{
+    return m_repository.fetchEventSnapshot(from, to);
+}
+
+QFuture<EventSnapshot> ObservableEventRepository::fetchEventsAsync(const QDate &from,
+                                                                  const QDate &to,
+                                                                  const CancellationToken &token) const
+{
+    return m_repository.fetchEventsAsync(from, to, token);
+}
+
+QFuture<EventSnapshot> ObservableEventRepository::fetchAllEventsAsync(const CancellationToken &token) const
+{
+    return m_repository.fetchAllEventsAsync(token);
+}
+
+std::vector<CalendarEvent> ObservableEventRepository::fetchSeriesEvents() const
+{
+    return m_repository.fetchSeriesEvents();
+}
+
+std::optional<CalendarEvent> ObservableEventRepository::findById(const QUuid &id) const
+{
+    return m_repository.findById(id);
+}
+
+CalendarEvent ObservableEventRepository::addEvent(CalendarEvent event)
+{
+    const CalendarEvent stored = m_repository.addEvent(std::move(event));
+    m_changes.recordInserted(stored);
+    publish();
+    return stored;
+}
+
+bool ObservableEventRepository::updateEvent(const CalendarEvent &event)
+{
+    const auto before = m_repository.findById(event.id);
+    if (!before || !m_repository.updateEvent(event)) {
+        return false;
+    }
+    // Read back what the repository stored, e.g. after fixing an invalid end.
+    m_changes.recordUpdated(*before, m_repository.findById(event.id).value_or(event));
+    publish();
+    return true;
+}
+
+bool ObservableEventRepository::removeEvent(const QUuid &id)
+{
+    const auto before = m_repository.findById(id);
+    if (!before || !m_repository.removeEvent(id)) {
+        return false;
+    }
+    m_changes.recordRemoved(*before);
+    publish();
+    return true;
+}
+
+void ObservableEventRepository::beginBatch()
+{
+    ++m_batchDepth;
+    m_repository.beginBatch();
+}
+
+void ObservableEventRepository::commitBatch()
+{
+    if (m_batchDepth == 0) {
+        return;
+    }
+    --m_batchDepth;
+    m_repository.commitBatch();
+    publish();
+}
+
+void ObservableEventRepository::publishChanges(const EventChangeSet &changes)
+{
+    for (const CalendarEvent &event : changes.inserted) {
+        m_changes.recordInserted(event);
+    }
+    for (const auto &update : changes.updated) {
+        m_changes.recordUpdated(update.before, update.after);
+    }
+    for (const CalendarEvent &event : changes.removed) {
+        m_changes.recordRemoved(event);
+    }
+    publish();
+}
+
+void ObservableEventRepository::publish()
+{
+    if (m_batchDepth > 0 || m_changes.isEmpty()) {
+        return;
+    }
+    emit eventsChanged(m_changes.take());
+}
+
+} // namespace data
+} // namespace calendar
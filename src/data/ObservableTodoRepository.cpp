@@ -0,0 +1,98 @@
+#include "calendar/data/ObservableTodoRepository.hpp"
+
+namespace calendar {
+namespace data {
+
+ObservableTodoRepository::ObservableTodoRepository(TodoRepository &repository, QObject *parent)
+    : QObject(parent)
+    , m_repository(repository)
+{
+}
+
+ObservableTodoRepository::~ObservableTodoRepository() = default;
+
+std::vector<TodoItem> ObservableTodoRepository::fetchTodos() const
+{
+    return m_repository.fetchTodos();
+}
+
+QFuture<std::vector<TodoItem>> ObservableTodoRepository::fetchTodosAsync(const CancellationToken &token) const
+{
+    return m_repository.fetchTodosAsync(token);
+}
+
+std::optional<TodoItem> ObservableTodoRepository::findById(const QUuid &id) const
+{
+    return m_repository.findById(id);
+}
+
+TodoItem ObservableTodoRepository::addTodo(TodoItem todo)
+{
+    const TodoItem stored = m_repository.addTodo(std::move(todo));
+    m_changes.recordInserted(stored);
+    publish();
+    return stored;
+}
+
+bool ObservableTodoRepository::updateTodo(const TodoItem &todo)
+{
+    const auto before = m_repository.findById(todo.id);
+    if (!before || !m_repository.updateTodo(todo)) {
+        return false;
+    }
+    m_changes.recordUpdated(*before, todo);
+    publish();
+    return true;
+}
+
+bool ObservableTodoRepository::removeTodo(const QUuid &id)
+{
+    const auto before = m_repository.findById(id);
+    if (!before || !m_repository.removeTodo(id)) {
+        return false;
+    }
+    m_changes.recordRemoved(*before);
+    publish();
+    return true;
+}
+
+void ObservableTodoRepository::beginBatch()
+{
+    ++m_batchDepth;
+    m_repository.beginBatch();
+}
+
+void ObservableTodoRepository::commitBatch()
+{
+    if (m_batchDepth == 0) {
+        return;
+    }
+    --m_batchDepth;
+    m_repository.commitBatch();
+    publish();
+}
+
+void ObservableTodoRepository::publishChanges(const TodoChangeSet &changes)
+{
+    for (const TodoItem &todo : changes.inserted) {
+        m_changes.recordInserted(todo);
+    }
+    for (const auto &update : changes.updated) {
+        m_changes.recordUpdated(update.before, update.after);
+    }
+    for (const TodoItem &todo : changes.removed) {
+        m_changes.recordRemoved(todo);
+    }
+    publish();
+}
+
+void ObservableTodoRepository::publish()
+{
+    if (m_batchDepth > 0 || m_changes.isEmpty()) {
+        return;
+    }
+    emit todosChanged(m_changes.take());
+}
+
+} // namespace data
+} // namespace calendar
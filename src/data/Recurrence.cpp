@@ -0,0 +1,397 @@
+#include "calendar/data/Recurrence.hpp"
+
+#include "calendar/data/IcsDateTime.hpp"
+
+#include <QByteArray>
+#include <QStringList>
+#include <algorithm>
+
+namespace calendar {
+namespace data {
+
+namespace {
+constexpr qint64 MSECS_PER_DAY = 24 * 60 * 60 * 1000;
+// Stops rules that never match again (e.g. BYMONTH=2;BYMONTHDAY=30) on far away windows.
+constexpr qint64 MAX_PERIODS = 100000;
+constexpr const char *WEEKDAYS[] = {"MO", "TU", "WE", "TH", "FR", "SA", "SU"};
+
+bool contains(const std::vector<int> &values, int value)
+{
+    return std::find(values.begin(), values.end(), value) != values.end();
+}
+
+QDate weekStart(const QDate &date)
+{
+    return date.addDays(1 - date.dayOfWeek());
+}
+
+std::optional<RecurrenceRule::WeekdayNum> parseWeekday(const QString &text)
+{
+    if (text.size() < 2) {
+        return std::nullopt;
+    }
+    const QString day = text.right(2).toUpper();
+    RecurrenceRule::WeekdayNum weekday;
+    weekday.dayOfWeek = 0;
+    for (int i = 0; i < 7; ++i) {
+        if (day == QLatin1String(WEEKDAYS[i])) {
+            weekday.dayOfWeek = i + 1;
+        }
+    }
+    if (weekday.dayOfWeek == 0) {
+        return std::nullopt;
+    }
+    const QString ordinal = text.left(text.size() - 2);
+    if (!ordinal.isEmpty()) {
+        bool ok = false;
+        weekday.ordinal = ordinal.toInt(&ok);
+        if (!ok || weekday.ordinal == 0 || qAbs(weekday.ordinal) > 53) {
+            return std::nullopt;
+        }
+    }
+    return weekday;
+}
+
+std::optional<std::vector<int>> parseNumbers(const QString &text, int limit, bool allowNegative)
+{
+    std::vector<int> numbers;
+    for (const QString &part : text.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int number = part.trimmed().toInt(&ok);
+        if (!ok || number == 0 || number > limit || (number < 0 && (!allowNegative || number < -limit))) {
+            return std::nullopt;
+        }
+        numbers.push_back(number);
+    }
+    return numbers;
+}
+
+// Days in [first, last] matching the BYDAY list; ordinals count within that span.
+std::vector<QDate> matchingWeekdays(const std::vector<RecurrenceRule::WeekdayNum> &byDay,
+                                    const QDate &first,
+                                    const QDate &last)
+{
+    std::vector<QDate> days;
+    for (const auto &weekday : byDay) {
+        const QDate firstMatch = first.addDays((weekday.dayOfWeek - first.dayOfWeek() + 7) % 7);
+        const qint64 matches = firstMatch > last ? 0 : firstMatch.daysTo(last) / 7 + 1;
+        if (weekday.ordinal == 0) {
+            for (qint64 i = 0; i < matches; ++i) {
+                days.push_back(firstMatch.addDays(7 * i));
+            }
+        } else {
+            const qint64 index = weekday.ordinal > 0 ? weekday.ordinal - 1 : matches + weekday.ordinal;
+            if (index >= 0 && index < matches) {
+                days.push_back(firstMatch.addDays(7 * index));
+            }
+        }
+    }
+    return days;
+}
+
+class Expansion
+{
+public:
+    Expansion(const RecurrenceRule &rule, const QDate &startDate)
+        : m_rule(rule)
+        , m_startDate(startDate)
+    {
+    }
+
+    QDate periodStart(qint64 period) const
+    {
+        const qint64 step = period * m_rule.interval;
+        switch (m_rule.frequency) {
+        case RecurrenceRule::Frequency::Daily:
+            return m_startDate.addDays(step);
+        case RecurrenceRule::Frequency::Weekly:
+            return weekStart(m_startDate).addDays(7 * step);
+        case RecurrenceRule::Frequency::Monthly:
+            return QDate(m_startDate.year(), m_startDate.month(), 1).addMonths(static_cast<int>(step));
+        case RecurrenceRule::Frequency::Yearly:
+            return QDate(m_startDate.year(), 1, 1).addYears(static_cast<int>(step));
+        }
+        return {};
+    }
+
+    // The period containing date, which must not be before the start date.
+    qint64 periodOf(const QDate &date) const
+    {
+        switch (m_rule.frequency) {
+        case RecurrenceRule::Frequency::Daily:
+            return m_startDate.daysTo(date) / m_rule.interval;
+        case RecurrenceRule::Frequency::Weekly:
+            return weekStart(m_startDate).daysTo(weekStart(date)) / 7 / m_rule.interval;
+        case RecurrenceRule::Frequency::Monthly:
+            return ((date.year() - m_startDate.year()) * 12 + date.month() - m_startDate.month())
+                   / m_rule.interval;
+        case RecurrenceRule::Frequency::Yearly:
+            return (date.year() - m_startDate.year()) / m_rule.interval;
+        }
+        return 0;
+    }
+
+    // Dates of the period starting at first, in order.
+    std::vector<QDate> candidates(const QDate &first) const
+    {
+        std::vector<QDate> days;
+        switch (m_rule.frequency) {
+        case RecurrenceRule::Frequency::Daily:
+            if (matchesDay(first)) {
+                days.push_back(first);
+            }
+            break;
+        case RecurrenceRule::Frequency::Weekly:
+            if (m_rule.byDay.empty()) {
+                days.push_back(first.addDays(m_startDate.dayOfWeek() - 1));
+            } else {
+                for (const auto &weekday : m_rule.byDay) {
+                    days.push_back(first.addDays(weekday.dayOfWeek - 1));
+                }
+            }
+            if (!m_rule.byMonth.empty()) {
+                const auto outsideMonths = [this](const QDate &day) {
+                    return !contains(m_rule.byMonth, day.month());
+                };
+                days.erase(std::remove_if(days.begin(), days.end(), outsideMonths), days.end());
+            }
+            break;
+        case RecurrenceRule::Frequency::Monthly:
+            if (m_rule.byMonth.empty() || contains(m_rule.byMonth, first.month())) {
+                days = daysOfMonth(first);
+            }
+            break;
+        case RecurrenceRule::Frequency::Yearly:
+            if (m_rule.byMonth.empty() && m_rule.byMonthDay.empty() && !m_rule.byDay.empty()) {
+                days = matchingWeekdays(m_rule.byDay, first, first.addYears(1).addDays(-1));
+            } else if (m_rule.byMonth.empty() && m_rule.byMonthDay.empty()) {
+                days = daysOfMonth(QDate(first.year(), m_startDate.month(), 1));
+            } else if (m_rule.byMonth.empty()) {
+                // BYMONTHDAY without BYMONTH applies to every month of the year.
+                for (int month = 1; month <= 12; ++month) {
+                    const std::vector<QDate> monthDays = daysOfMonth(QDate(first.year(), month, 1));
+                    days.insert(days.end(), monthDays.begin(), monthDays.end());
+                }
+            } else {
+                for (int month : m_rule.byMonth) {
+                    const std::vector<QDate> monthDays = daysOfMonth(QDate(first.year(), month, 1));
+                    days.insert(days.end(), monthDays.begin(), monthDays.end());
+                }
+            }
+            break;
+        }
+        std::sort(days.begin(), days.end());
+        days.erase(std::unique(days.begin(), days.end()), days.end());
+        return days;
+    }
+
+private:
+    // BYDAY and BYMONTHDAY narrow the days of a daily rule.
+    bool matchesDay(const QDate &day) const
+    {
+        if (!m_rule.byMonth.empty() && !contains(m_rule.byMonth, day.month())) {
+            return false;
+        }
+        if (!m_rule.byMonthDay.empty() && !matchesMonthDay(day)) {
+            return false;
+        }
+        if (!m_rule.byDay.empty()) {
+            return std::any_of(m_rule.byDay.begin(), m_rule.byDay.end(), [&day](const auto &weekday) {
+                return weekday.dayOfWeek == day.dayOfWeek();
+            });
+        }
+        return true;
+    }
+
+    bool matchesMonthDay(const QDate &day) const
+    {
+        const int length = day.daysInMonth();
+        return std::any_of(m_rule.byMonthDay.begin(), m_rule.byMonthDay.end(), [&](int monthDay) {
+            return (monthDay > 0 ? monthDay : length + 1 + monthDay) == day.day();
+        });
+    }
+
+    std::vector<QDate> daysOfMonth(const QDate &first) const
+    {
+        std::vector<QDate> days;
+        const QDate last = first.addMonths(1).addDays(-1);
+        if (!m_rule.byDay.empty()) {
+            days = matchingWeekdays(m_rule.byDay, first, last);
+            if (!m_rule.byMonthDay.empty()) {
+                days.erase(std::remove_if(days.begin(),
+                                          days.end(),
+                                          [this](const QDate &day) { return !matchesMonthDay(day); }),
+                           days.end());
+            }
+        } else if (!m_rule.byMonthDay.empty()) {
+            const int length = first.daysInMonth();
+            for (int monthDay : m_rule.byMonthDay) {
+                const int day = monthDay > 0 ? monthDay : length + 1 + monthDay;
+                if (day >= 1 && day <= length) {
+                    days.push_back(first.addDays(day - 1));
+                }
+            }
+        } else if (m_startDate.day() <= first.daysInMonth()) {
+            // Months without that day are skipped, as RFC 5545 requires.
+            days.push_back(first.addDays(m_startDate.day() - 1));
+        }
+        return days;
+    }
+
+    const RecurrenceRule &m_rule;
+    const QDate m_startDate;
+};
+} // namespace
+
+std::optional<RecurrenceRule> RecurrenceRule::parse(const QString &rule)
+{
+    QString text = rule.trimmed();
+    if (text.startsWith(QLatin1String("RRULE:"), Qt::CaseInsensitive)) {
+        text.remove(0, 6);
+    }
+    RecurrenceRule result;
+    bool hasFrequency = false;
+    for (const QString &part : text.split(QLatin1Char(';'), Qt::SkipEmptyParts)) {
+        const int separator = part.indexOf(QLatin1Char('='));
+        if (separator <= 0) {
+            return std::nullopt;
+        }
+        const QString key = part.left(separator).trimmed().toUpper();
+        const QString value = part.mid(separator + 1).trimmed();
+        bool ok = true;
+        if (key == QLatin1String("FREQ")) {
+            const QString frequency = value.toUpper();
+            if (frequency == QLatin1String("DAILY")) {
+                result.frequency = Frequency::Daily;
+            } else if (frequency == QLatin1String("WEEKLY")) {
+                result.frequency = Frequency::Weekly;
+            } else if (frequency == QLatin1String("MONTHLY")) {
+                result.frequency = Frequency::Monthly;
+            } else if (frequency == QLatin1String("YEARLY")) {
+                result.frequency = Frequency::Yearly;
+            } else {
+                return std::nullopt;
+            }
+            hasFrequency = true;
+        } else if (key == QLatin1String("INTERVAL")) {
+            result.interval = value.toInt(&ok);
+            ok = ok && result.interval > 0;
+        } else if (key == QLatin1String("COUNT")) {
+            result.count = value.toInt(&ok);
+            ok = ok && result.count > 0;
+        } else if (key == QLatin1String("UNTIL")) {
+            const QByteArray bytes = value.toLatin1();
+            result.until = IcsDateTime::parse(bytes.constData(), bytes.size());
+            // A date includes the whole day.
+            if (bytes.size() == 8 && result.until.isValid()) {
+                result.until = result.until.addDays(1).addMSecs(-1);
+            }
+            ok = result.until.isValid();
+        } else if (key == QLatin1String("BYDAY")) {
+            for (const QString &item : value.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+                const auto weekday = parseWeekday(item.trimmed());
+                if (!weekday) {
+                    return std::nullopt;
+                }
+                result.byDay.push_back(*weekday);
+            }
+        } else if (key == QLatin1String("BYMONTHDAY")) {
+            const auto days = parseNumbers(value, 31, true);
+            ok = days.has_value();
+            result.byMonthDay = days.value_or(std::vector<int>());
+        } else if (key == QLatin1String("BYMONTH")) {
+            const auto months = parseNumbers(value, 12, false);
+            ok = months.has_value();
+            result.byMonth = months.value_or(std::vector<int>());
+        } else if (key != QLatin1String("WKST")) {
+            return std::nullopt;
+        }
+        if (!ok) {
+            return std::nullopt;
+        }
+    }
+    if (!hasFrequency) {
+        return std::nullopt;
+    }
+    // Ordinals only make sense within a month or a year.
+    if (result.frequency == Frequency::Daily || result.frequency == Frequency::Weekly) {
+        for (const WeekdayNum &weekday : result.byDay) {
+            if (weekday.ordinal != 0) {
+                return std::nullopt;
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<QDateTime> RecurrenceRule::occurrences(const QDateTime &start,
+                                                   qint64 durationMs,
+                                                   const QDateTime &from,
+                                                   const QDateTime &to) const
+{
+    std::vector<QDateTime> result;
+    if (!start.isValid() || !from.isValid() || !to.isValid() || start > to) {
+        return result;
+    }
+    const auto overlaps = [&](const QDateTime &occurrence) {
+        return occurrence <= to && occurrence.addMSecs(durationMs) >= from;
+    };
+    if (overlaps(start)) {
+        result.push_back(start);
+    }
+
+    const QDate startDate = start.date();
+    const Expansion expansion(*this, startDate);
+    qint64 firstPeriod = 0;
+    if (count == 0) {
+        // An occurrence of an earlier period would have to last from before that day.
+        const QDate earliest = from.date().addDays(-(qMax<qint64>(durationMs, 0) / MSECS_PER_DAY + 1));
+        firstPeriod = earliest > startDate ? expansion.periodOf(earliest) : 0;
+    }
+
+    int produced = 1;
+    const QDate lastDate = to.date();
+    for (qint64 period = firstPeriod; period - firstPeriod < MAX_PERIODS; ++period) {
+        const QDate first = expansion.periodStart(period);
+        if (!first.isValid() || first > lastDate) {
+            break;
+        }
+        for (const QDate &day : expansion.candidates(first)) {
+            if (day <= startDate) {
+                continue;
+            }
+            QDateTime occurrence = start;
+            occurrence.setDate(day);
+            if ((until.isValid() && occurrence > until) || (count > 0 && produced >= count)
+                || occurrence > to) {
+                return result;
+            }
+            ++produced;
+            if (overlaps(occurrence)) {
+                result.push_back(occurrence);
+                if (static_cast<int>(result.size()) >= MaxOccurrences) {
+                    return result;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+QUuid Recurrence::occurrenceId(const QUuid &seriesId, const QDateTime &recurrenceId)
+{
+    return QUuid::createUuidV5(seriesId, QByteArray::number(recurrenceId.toMSecsSinceEpoch()));
+}
+
+bool Recurrence::belongsToSeries(const CalendarEvent &event)
+{
+    return !event.recurrenceRule.isEmpty() || isOverride(event);
+}
+
+bool Recurrence::isOverride(const CalendarEvent &event)
+{
+    return !event.seriesId.isNull() && event.recurrenceId.isValid() && event.recurrenceRule.isEmpty();
+}
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,335 @@
+#include "calendar/data/RecurringEventRepository.hpp"
+
+#include <QSet>
+#include <algorithm>
+
+namespace calendar {
+namespace data {
+
+namespace {
+// Windows kept per series; the least recently used one is dropped beyond that.
+constexpr int MAX_WINDOWS_PER_SERIES = 8;
+// Occurrence ids remembered for findById(); the table starts over beyond that.
+constexpr int MAX_REMEMBERED_OCCURRENCES = 50000;
+
+bool startsBefore(const EventHandle &lhs, const EventHandle &rhs)
+{
+    if (lhs->start != rhs->start) {
+        return lhs->start < rhs->start;
+    }
+    return lhs->end < rhs->end;
+}
+
+CalendarEvent occurrenceOf(const CalendarEvent &master, const QDateTime &start)
+{
+    CalendarEvent occurrence = master;
+    occurrence.id = Recurrence::occurrenceId(master.id, start);
+    occurrence.seriesId = master.id;
+    occurrence.recurrenceId = start;
+    occurrence.start = start;
+    occurrence.end = start.addMSecs(master.start.msecsTo(master.end));
+    occurrence.recurrenceRule.clear();
+    occurrence.exceptionDates.clear();
+    return occurrence;
+}
+
+bool isExcluded(const CalendarEvent &master, const QDateTime &start)
+{
+    return std::any_of(master.exceptionDates.begin(),
+                       master.exceptionDates.end(),
+                       [&start](const QDateTime &exception) { return exception == start; });
+}
+
+// Stored events without the expanded masters, plus the occurrences, in order. Touches no
+// repository state, so it may run on a worker thread.
+EventSnapshot mergeOccurrences(const EventSnapshot &stored, const std::vector<EventHandle> &occurrences)
+{
+    // Masters with a rule that cannot be expanded stay a single event.
+    std::vector<EventHandle> result;
+    result.reserve(stored.size() + occurrences.size());
+    for (const EventHandle &event : stored.handles()) {
+        if (event->recurrenceRule.isEmpty() || !RecurrenceRule::parse(event->recurrenceRule)) {
+            result.push_back(event);
+        }
+    }
+    result.insert(result.end(), occurrences.begin(), occurrences.end());
+    std::stable_sort(result.begin(), result.end(), startsBefore);
+    return EventSnapshot(std::move(result));
+}
+} // namespace
+
+RecurringEventRepository::RecurringEventRepository(EventRepository &repository)
+    : m_repository(repository)
+{
+}
+
+RecurringEventRepository::~RecurringEventRepository() = default;
+
+std::vector<CalendarEvent> RecurringEventRepository::fetchEvents(const QDate &from, const QDate &to) const
+{
+    return fetchEventSnapshot(from, to).toVector();
+}
+
+EventSnapshot RecurringEventRepository::fetchEventSnapshot(const QDate &from, const QDate &to) const
+{
+    if (!from.isValid() || !to.isValid()) {
+        return {};
+    }
+    return mergeOccurrences(m_repository.fetchEventSnapshot(from, to), occurrencesInRange(from, to));
+}
+
+QFuture<EventSnapshot> RecurringEventRepository::fetchEventsAsync(const QDate &from,
+                                                                 const QDate &to,
+                                                                 const CancellationToken &token) const
+{
+    if (!from.isValid() || !to.isValid() || token.isCancelled()) {
+        return finishedEventQuery({});
+    }
+    // The expansion cache belongs to this thread; the merge follows the backend query.
+    const std::vector<EventHandle> occurrences = occurrencesInRange(from, to);
+    const QFuture<EventSnapshot> stored = m_repository.fetchEventsAsync(from, to, token);
+    if (stored.isFinished()) {
+        return finishedEventQuery(mergeOccurrences(stored.result(), occurrences));
+    }
+    return continueEventQuery(stored, [occurrences, token](const EventSnapshot &snapshot) {
+        if (token.isCancelled()) {
+            return EventSnapshot();
+        }
+        return mergeOccurrences(snapshot, occurrences);
+    });
+}
+
+std::vector<EventHandle> RecurringEventRepository::occurrencesInRange(const QDate &from,
+                                                                     const QDate &to) const
+{
+    std::vector<EventHandle> result;
+    const std::vector<CalendarEvent> series = m_repository.fetchSeriesEvents();
+    QSet<QUuid> overridden;
+    for (const CalendarEvent &event : series) {
+        if (Recurrence::isOverride(event)) {
+            overridden.insert(event.id);
+        }
+    }
+
+    const QDateTime fromTime = from.startOfDay();
+    const QDateTime toTime = to.addDays(1).startOfDay().addMSecs(-1);
+    QSet<QUuid> masters;
+    for (const CalendarEvent &master : series) {
+        // Overrides have no rule.
+        const auto rule = RecurrenceRule::parse(master.recurrenceRule);
+        if (!rule) {
+            continue;
+        }
+        masters.insert(master.id);
+        for (const QDateTime &start : occurrenceStarts(master, *rule, fromTime, toTime)) {
+            if (isExcluded(master, start)) {
+                continue;
+            }
+            CalendarEvent occurrence = occurrenceOf(master, start);
+            // Overrides come from the repository itself, at their own dates.
+            if (overridden.contains(occurrence.id)) {
+                continue;
+            }
+            rememberOccurrence(occurrence);
+            result.push_back(std::make_shared<const CalendarEvent>(std::move(occurrence)));
+        }
+    }
+    // Series that are gone or no longer recurring.
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (masters.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_cache.erase(it);
+        }
+    }
+    return result;
+}
+
+QFuture<EventSnapshot> RecurringEventRepository::fetchAllEventsAsync(const CancellationToken &token) const
+{
+    return m_repository.fetchAllEventsAsync(token);
+}
+
+std::vector<CalendarEvent> RecurringEventRepository::fetchSeriesEvents() const
+{
+    return m_repository.fetchSeriesEvents();
+}
+
+std::optional<CalendarEvent> RecurringEventRepository::findById(const QUuid &id) const
+{
+    if (auto event = m_repository.findById(id)) {
+        return event;
+    }
+    return generatedOccurrence(id);
+}
+
+CalendarEvent RecurringEventRepository::addEvent(CalendarEvent event)
+{
+    // Copies of an occurrence, e.g. pasted ones, are events of their own.
+    if (Recurrence::isOverride(event)
+        && event.id != Recurrence::occurrenceId(event.seriesId, event.recurrenceId)) {
+        event.seriesId = QUuid();
+        event.recurrenceId = QDateTime();
+    }
+    return m_repository.addEvent(std::move(event));
+}
+
+bool RecurringEventRepository::updateEvent(const CalendarEvent &event)
+{
+    if (m_repository.findById(event.id)) {
+        m_cache.remove(event.id);
+        return m_repository.updateEvent(event);
+    }
+    const auto original = generatedOccurrence(event.id);
+    if (!original) {
+        return false;
+    }
+    // The occurrence becomes an override; it keeps the id the occurrence had.
+    CalendarEvent replacement = event;
+    replacement.seriesId = original->seriesId;
+    replacement.recurrenceId = original->recurrenceId;
+    replacement.recurrenceRule.clear();
+    replacement.exceptionDates.clear();
+    m_repository.addEvent(replacement);
+    return true;
+}
+
+bool RecurringEventRepository::removeEvent(const QUuid &id)
+{
+    const auto stored = m_repository.findById(id);
+    if (stored && !Recurrence::isOverride(*stored)) {
+        m_cache.remove(id);
+        if (stored->recurrenceRule.isEmpty()) {
+            return m_repository.removeEvent(id);
+        }
+        m_repository.beginBatch();
+        for (const CalendarEvent &event : m_repository.fetchSeriesEvents()) {
+            if (event.seriesId == id && Recurrence::isOverride(event)) {
+                m_repository.removeEvent(event.id);
+            }
+        }
+        const bool removed = m_repository.removeEvent(id);
+        m_repository.commitBatch();
+        return removed;
+    }
+
+    const auto occurrence = stored ? stored : generatedOccurrence(id);
+    if (!occurrence) {
+        return false;
+    }
+    auto master = m_repository.findById(occurrence->seriesId);
+    m_repository.beginBatch();
+    if (stored) {
+        m_repository.removeEvent(id);
+    }
+    if (master && !master->recurrenceRule.isEmpty() && !isExcluded(*master, occurrence->recurrenceId)) {
+        master->exceptionDates.append(occurrence->recurrenceId);
+        m_repository.updateEvent(*master);
+    }
+    m_repository.commitBatch();
+    return true;
+}
+
+void RecurringEventRepository::beginBatch()
+{
+    m_repository.beginBatch();
+}
+
+void RecurringEventRepository::commitBatch()
+{
+    m_repository.commitBatch();
+}
+
+int RecurringEventRepository::cachedWindowCount() const
+{
+    int count = 0;
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        count += static_cast<int>(it.value().windows.size());
+    }
+    return count;
+}
+
+std::vector<QDateTime> RecurringEventRepository::occurrenceStarts(const CalendarEvent &master,
+                                                                  const RecurrenceRule &rule,
+                                                                  const QDateTime &from,
+                                                                  const QDateTime &to) const
+{
+    SeriesCache &series = m_cache[master.id];
+    if (series.rule != master.recurrenceRule || series.start != master.start || series.end != master.end) {
+        series = SeriesCache{master.recurrenceRule, master.start, master.end, {}};
+    }
+
+    const qint64 fromMs = from.toMSecsSinceEpoch();
+    const qint64 toMs = to.toMSecsSinceEpoch();
+    const qint64 durationMs = master.start.msecsTo(master.end);
+    for (Window &window : series.windows) {
+        const bool truncated = static_cast<int>(window.starts.size()) >= RecurrenceRule::MaxOccurrences;
+        if (window.from > fromMs || window.to < toMs || (truncated && window.from != fromMs)) {
+            continue;
+        }
+        window.lastUse = ++m_useClock;
+        if (window.from == fromMs && window.to == toMs) {
+            return window.starts;
+        }
+        // A wider window holds every occurrence of this one.
+        std::vector<QDateTime> starts;
+        for (const QDateTime &start : window.starts) {
+            if (start <= to && start.addMSecs(durationMs) >= from) {
+                starts.push_back(start);
+            }
+        }
+        return starts;
+    }
+
+    if (static_cast<int>(series.windows.size()) >= MAX_WINDOWS_PER_SERIES) {
+        const auto oldest = std::min_element(series.windows.begin(),
+                                             series.windows.end(),
+                                             [](const Window &lhs, const Window &rhs) {
+                                                 return lhs.lastUse < rhs.lastUse;
+                                             });
+        series.windows.erase(oldest);
+    }
+    Window window;
+    window.from = fromMs;
+    window.to = toMs;
+    window.starts = rule.occurrences(master.start, durationMs, from, to);
+    window.lastUse = ++m_useClock;
+    series.windows.push_back(window);
+    return window.starts;
+}
+
+std::optional<CalendarEvent> RecurringEventRepository::generatedOccurrence(const QUuid &id) const
+{
+    const auto key = m_occurrences.constFind(id);
+    if (key == m_occurrences.constEnd()) {
+        return std::nullopt;
+    }
+    const auto master = m_repository.findById(key->seriesId);
+    if (!master || master->recurrenceRule.isEmpty() || isExcluded(*master, key->recurrenceId)) {
+        return std::nullopt;
+    }
+    // The master may have changed since the occurrence was handed out.
+    const auto rule = RecurrenceRule::parse(master->recurrenceRule);
+    if (!rule) {
+        return std::nullopt;
+    }
+    const std::vector<QDateTime> starts = rule->occurrences(master->start,
+                                                            master->start.msecsTo(master->end),
+                                                            key->recurrenceId,
+                                                            key->recurrenceId);
+    if (std::find(starts.begin(), starts.end(), key->recurrenceId) == starts.end()) {
+        return std::nullopt;
+    }
+    return occurrenceOf(*master, key->recurrenceId);
+}
+
+void RecurringEventRepository::rememberOccurrence(const CalendarEvent &occurrence) const
+{
+    if (m_occurrences.size() >= MAX_REMEMBERED_OCCURRENCES && !m_occurrences.contains(occurrence.id)) {
+        m_occurrences.clear();
+    }
+    m_occurrences.insert(occurrence.id, {occurrence.seriesId, occurrence.recurrenceId});
+}
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,49 @@
+#include "calendar/data/RepositoryBatch.hpp"
+
+#include "calendar/data/EventRepository.hpp"
+#include "calendar/data/TodoRepository.hpp"
+
+namespace calendar {
+namespace data {
+
+RepositoryBatch::RepositoryBatch(EventRepository &events)
+    : m_events(&events)
+{
+    m_events->beginBatch();
+}
+
+RepositoryBatch::RepositoryBatch(TodoRepository &todos)
+    : m_todos(&todos)
+{
+    m_todos->beginBatch();
+}
+
+RepositoryBatch::RepositoryBatch(EventRepository &events, TodoRepository &todos)
+    : m_events(&events)
+    , m_todos(&todos)
+{
+    m_events->beginBatch();
+    m_todos->beginBatch();
+}
+
+RepositoryBatch::~RepositoryBatch()
+{
+    commit();
+}
+
+void RepositoryBatch::commit()
+{
+    if (m_committed) {
+        return;
+    }
+    m_committed = true;
+    if (m_todos) {
+        m_todos->commitBatch();
+    }
+    if (m_events) {
+        m_events->commitBatch();
+    }
+}
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,118 @@
+#include "calendar/data/SearchIndex.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace calendar {
+namespace data {
+
+namespace {
+constexpr int TRIGRAM_LENGTH = 3;
+} // namespace
+
+void SearchIndex::insert(const QUuid &id, const QString &text)
+{
+    const QString folded = text.toCaseFolded();
+    const auto existing = m_texts.constFind(id);
+    if (existing != m_texts.constEnd()) {
+        if (existing.value() == folded) {
+            return;
+        }
+        remove(id);
+    }
+    for (const quint64 trigram : trigrams(folded)) {
+        m_postings[trigram].insert(id);
+    }
+    m_texts.insert(id, folded);
+}
+
+bool SearchIndex::remove(const QUuid &id)
+{
+    const auto existing = m_texts.find(id);
+    if (existing == m_texts.end()) {
+        return false;
+    }
+    for (const quint64 trigram : trigrams(existing.value())) {
+        const auto posting = m_postings.find(trigram);
+        if (posting == m_postings.end()) {
+            continue;
+        }
+        posting.value().remove(id);
+        if (posting.value().isEmpty()) {
+            m_postings.erase(posting);
+        }
+    }
+    m_texts.erase(existing);
+    return true;
+}
+
+void SearchIndex::clear()
+{
+    m_texts.clear();
+    m_postings.clear();
+}
+
+int SearchIndex::size() const
+{
+    return m_texts.size();
+}
+
+bool SearchIndex::contains(const QUuid &id) const
+{
+    return m_texts.contains(id);
+}
+
+QSet<QUuid> SearchIndex::matching(const QString &query) const
+{
+    QSet<QUuid> result;
+    const QString folded = query.toCaseFolded();
+    if (folded.isEmpty()) {
+        return result;
+    }
+    if (folded.size() < TRIGRAM_LENGTH) {
+        for (auto it = m_texts.constBegin(); it != m_texts.constEnd(); ++it) {
+            if (it.value().contains(folded)) {
+                result.insert(it.key());
+            }
+        }
+        return result;
+    }
+
+    // Intersect starting with the rarest trigram; only its ids are ever looked at.
+    std::vector<const QSet<QUuid> *> postings;
+    for (const quint64 trigram : trigrams(folded)) {
+        const auto posting = m_postings.constFind(trigram);
+        if (posting == m_postings.constEnd()) {
+            return result;
+        }
+        postings.push_back(&posting.value());
+    }
+    std::sort(postings.begin(), postings.end(), [](const QSet<QUuid> *lhs, const QSet<QUuid> *rhs) {
+        return lhs->size() < rhs->size();
+    });
+    for (const QUuid &id : *postings.front()) {
+        const bool inAll = std::all_of(postings.begin() + 1,
+                                       postings.end(),
+                                       [&id](const QSet<QUuid> *posting) { return posting->contains(id); });
+        // Having every trigram does not mean having them in the right order.
+        if (inAll && m_texts.value(id).contains(folded)) {
+            result.insert(id);
+        }
+    }
+    return result;
+}
+
+QSet<quint64> SearchIndex::trigrams(const QString &foldedText)
+{
+    QSet<quint64> result;
+    for (int i = 0; i + TRIGRAM_LENGTH <= foldedText.size(); ++i) {
+        const quint64 trigram = (quint64(foldedText.at(i).unicode()) << 32)
+                                | (quint64(foldedText.at(i + 1).unicode()) << 16)
+                                | quint64(foldedText.at(i + 2).unicode());
+        result.insert(trigram);
+    }
+    return result;
+}
+
+} // namespace data
+} // namespace calendar
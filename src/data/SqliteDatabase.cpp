@@ -0,0 +1,226 @@
+#include "calendar/data/SqliteDatabase.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+#include <QVariant>
+#include <vector>
+
+namespace calendar {
+namespace data {
+
+namespace {
+constexpr auto SQLITE_DRIVER = "QSQLITE";
+
+// Every entry upgrades the schema by one version. Entries must never be changed once
+// released; add a new one instead.
+const std::vector<std::vector<const char *>> &migrations()
+{
+    static const std::vector<std::vector<const char *>> steps = {
+        {
+            "CREATE TABLE events ("
+            " id TEXT PRIMARY KEY NOT NULL,"
+            " title TEXT NOT NULL DEFAULT '',"
+            " description TEXT NOT NULL DEFAULT '',"
+            " location TEXT NOT NULL DEFAULT '',"
+            " start_ms INTEGER,"
+            " end_ms INTEGER,"
+            " all_day INTEGER NOT NULL DEFAULT 0,"
+            " categories TEXT NOT NULL DEFAULT '',"
+            " recurrence_rule TEXT NOT NULL DEFAULT '',"
+            " reminder_minutes INTEGER NOT NULL DEFAULT 0)",
+            "CREATE INDEX events_by_start ON events (start_ms, end_ms)",
+            // Events longer than a week are few; they get their own index so that range
+            // queries can bound the start of all other events.
+            "CREATE INDEX events_long_by_start ON events (start_ms) WHERE end_ms - start_ms > 604800000",
+            "CREATE TABLE todos ("
+            " id TEXT PRIMARY KEY NOT NULL,"
+            " title TEXT NOT NULL DEFAULT '',"
+            " description TEXT NOT NULL DEFAULT '',"
+            " location TEXT NOT NULL DEFAULT '',"
+            " due_ms INTEGER,"
+            " priority INTEGER NOT NULL DEFAULT 0,"
+            " tags TEXT NOT NULL DEFAULT '',"
+            " status INTEGER NOT NULL DEFAULT 0,"
+            " scheduled INTEGER NOT NULL DEFAULT 0,"
+            " duration_minutes INTEGER NOT NULL DEFAULT 0)",
+        },
+        {
+            // Recurring series: exception dates are start times in ms, separated by commas.
+            "ALTER TABLE events ADD COLUMN series_id TEXT NOT NULL DEFAULT ''",
+            "ALTER TABLE events ADD COLUMN recurrence_id_ms INTEGER",
+            "ALTER TABLE events ADD COLUMN exception_dates TEXT NOT NULL DEFAULT ''",
+            "CREATE INDEX events_in_series ON events (start_ms)"
+            " WHERE recurrence_rule != '' OR series_id != ''",
+        },
+    };
+    return steps;
+}
+} // namespace
+
+SqliteDatabase::SqliteDatabase(QString filePath)
+    : m_filePath(std::move(filePath))
+    , m_connectionName(QStringLiteral("calendar-%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces)))
+{
+    if (!QSqlDatabase::isDriverAvailable(QLatin1String(SQLITE_DRIVER))) {
+        m_lastError = QStringLiteral("SQLite driver not available");
+        return;
+    }
+
+    const QFileInfo info(m_filePath);
+    QDir dir = info.dir();
+    if (!dir.exists()) {
+        dir.mkpath(QStringLiteral("."));
+    }
+
+    m_database = QSqlDatabase::addDatabase(QLatin1String(SQLITE_DRIVER), m_connectionName);
+    m_database.setDatabaseName(m_filePath);
+    if (!m_database.open()) {
+        m_lastError = m_database.lastError().text();
+        return;
+    }
+    m_open = configure() && migrate();
+}
+
+SqliteDatabase::~SqliteDatabase()
+{
+    if (m_batchDepth > 0) {
+        m_database.commit();
+    }
+    m_database.close();
+    m_database = QSqlDatabase();
+    if (QSqlDatabase::contains(m_connectionName)) {
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+}
+
+bool SqliteDatabase::isOpen() const
+{
+    return m_open;
+}
+
+QString SqliteDatabase::lastError() const
+{
+    return m_lastError;
+}
+
+QSqlDatabase SqliteDatabase::database() const
+{
+    return m_database;
+}
+
+QString SqliteDatabase::filePath() const
+{
+    return m_filePath;
+}
+
+void SqliteDatabase::readSeparately(const QString &filePath,
+                                    const std::function<void(const QSqlDatabase &)> &read)
+{
+    const QString connectionName =
+        QStringLiteral("calendar-reader-%1").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(QLatin1String(SQLITE_DRIVER), connectionName);
+        database.setDatabaseName(filePath);
+        database.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+        if (database.open()) {
+            read(database);
+        }
+        database.close();
+    }
+    // The connection has to be gone before it can be removed.
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+int SqliteDatabase::schemaVersion() const
+{
+    QSqlQuery query(m_database);
+    if (!query.exec(QStringLiteral("PRAGMA user_version")) || !query.next()) {
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+int SqliteDatabase::latestSchemaVersion()
+{
+    return static_cast<int>(migrations().size());
+}
+
+void SqliteDatabase::beginBatch()
+{
+    if (m_batchDepth++ == 0 && m_open) {
+        m_database.transaction();
+    }
+}
+
+void SqliteDatabase::commitBatch()
+{
+    if (m_batchDepth == 0) {
+        return;
+    }
+    if (--m_batchDepth == 0 && m_open && !m_database.commit()) {
+        m_lastError = m_database.lastError().text();
+    }
+}
+
+bool SqliteDatabase::configure()
+{
+    // WAL keeps readers unblocked while writing and makes small commits cheap; NORMAL
+    // synchronisation is durable across application crashes in WAL mode.
+    return execute(QStringLiteral("PRAGMA journal_mode = WAL"))
+           && execute(QStringLiteral("PRAGMA synchronous = NORMAL"))
+           && execute(QStringLiteral("PRAGMA temp_store = MEMORY"));
+}
+
+bool SqliteDatabase::migrate()
+{
+    const int current = schemaVersion();
+    if (current < 0) {
+        return false;
+    }
+    if (current > latestSchemaVersion()) {
+        m_lastError = QStringLiteral("Database schema %1 is newer than this version of Block Master")
+                          .arg(current);
+        return false;
+    }
+
+    const auto &steps = migrations();
+    for (int version = current; version < latestSchemaVersion(); ++version) {
+        if (!m_database.transaction()) {
+            m_lastError = m_database.lastError().text();
+            return false;
+        }
+        bool success = true;
+        for (const char *statement : steps.at(static_cast<size_t>(version))) {
+            if (!execute(QLatin1String(statement))) {
+                success = false;
+                break;
+            }
+        }
+        success = success && execute(QStringLiteral("PRAGMA user_version = %1").arg(version + 1));
+        if (!success) {
+            m_database.rollback();
+            return false;
+        }
+        if (!m_database.commit()) {
+            m_lastError = m_database.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SqliteDatabase::execute(const QString &statement)
+{
+    QSqlQuery query(m_database);
+    if (!query.exec(statement)) {
+        m_lastError = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+} // namespace data
+} // namespace calendar
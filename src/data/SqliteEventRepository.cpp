@@ -0,0 +1,244 @@
+#include "calendar/data/SqliteEventRepository.hpp"
+
+#include "calendar/data/SqliteDatabase.hpp"
+
+#include <QVariant>
+#include <QtConcurrent>
+
+namespace calendar {
+namespace data {
+
+namespace {
+// Must match the threshold of the events_long_by_start index.
+constexpr qint64 LONG_EVENT_MS = 7LL * 24 * 60 * 60 * 1000;
+constexpr auto CATEGORY_SEPARATOR = "\n";
+constexpr auto EXCEPTION_SEPARATOR = ",";
+
+constexpr auto EVENT_COLUMNS = "id, title, description, location, start_ms, end_ms, all_day, categories, "
+                               "recurrence_rule, reminder_minutes, series_id, recurrence_id_ms, "
+                               "exception_dates";
+
+QString uidString(const QUuid &id)
+{
+    return id.toString(QUuid::WithoutBraces);
+}
+
+QVariant timestamp(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? QVariant(dateTime.toMSecsSinceEpoch()) : QVariant();
+}
+
+QDateTime dateTimeFrom(const QVariant &value)
+{
+    return value.isNull() ? QDateTime() : QDateTime::fromMSecsSinceEpoch(value.toLongLong());
+}
+
+CalendarEvent eventFromQuery(const QSqlQuery &query)
+{
+    CalendarEvent event;
+    event.id = QUuid::fromString(query.value(0).toString());
+    event.title = query.value(1).toString();
+    event.description = query.value(2).toString();
+    event.location = query.value(3).toString();
+    event.start = dateTimeFrom(query.value(4));
+    event.end = dateTimeFrom(query.value(5));
+    event.allDay = query.value(6).toBool();
+    const QString categories = query.value(7).toString();
+    if (!categories.isEmpty()) {
+        event.categories = categories.split(QLatin1String(CATEGORY_SEPARATOR));
+    }
+    event.recurrenceRule = query.value(8).toString();
+    event.reminderMinutes = query.value(9).toInt();
+    const QString seriesId = query.value(10).toString();
+    if (!seriesId.isEmpty()) {
+        event.seriesId = QUuid::fromString(seriesId);
+    }
+    event.recurrenceId = dateTimeFrom(query.value(11));
+    const QStringList exceptions =
+        query.value(12).toString().split(QLatin1String(EXCEPTION_SEPARATOR), Qt::SkipEmptyParts);
+    for (const QString &exception : exceptions) {
+        event.exceptionDates.append(QDateTime::fromMSecsSinceEpoch(exception.toLongLong()));
+    }
+    return event;
+}
+
+QString exceptionString(const QList<QDateTime> &exceptionDates)
+{
+    QStringList values;
+    values.reserve(exceptionDates.size());
+    for (const QDateTime &exception : exceptionDates) {
+        if (exception.isValid()) {
+            values.append(QString::number(exception.toMSecsSinceEpoch()));
+        }
+    }
+    return values.join(QLatin1String(EXCEPTION_SEPARATOR));
+}
+} // namespace
+
+SqliteEventRepository::SqliteEventRepository(std::shared_ptr<SqliteDatabase> database)
+    : m_database(std::move(database))
+    , m_rangeQuery(m_database->database())
+    , m_seriesQuery(m_database->database())
+    , m_findQuery(m_database->database())
+    , m_upsertQuery(m_database->database())
+    , m_updateQuery(m_database->database())
+    , m_deleteQuery(m_database->database())
+{
+    const QString columns = QLatin1String(EVENT_COLUMNS);
+    // Short events can only overlap the range if they start at most LONG_EVENT_MS before it,
+    // which keeps both halves of the query a bounded scan of an index.
+    m_rangeQuery.prepare(QStringLiteral("SELECT %1 FROM events"
+                                        " WHERE start_ms BETWEEN :windowStart AND :to AND end_ms >= :from"
+                                        " AND end_ms - start_ms <= %2"
+                                        " UNION ALL"
+                                        " SELECT %1 FROM events"
+                                        " WHERE end_ms - start_ms > %2 AND start_ms <= :to AND end_ms >= :from"
+                                        " ORDER BY start_ms, end_ms, id")
+                             .arg(columns)
+                             .arg(LONG_EVENT_MS));
+    // Matches the condition of the events_in_series index.
+    m_seriesQuery.prepare(QStringLiteral("SELECT %1 FROM events"
+                                         " WHERE recurrence_rule != '' OR series_id != ''"
+                                         " ORDER BY start_ms, end_ms, id")
+                              .arg(columns));
+    m_findQuery.prepare(QStringLiteral("SELECT %1 FROM events WHERE id = :id").arg(columns));
+    m_upsertQuery.prepare(QStringLiteral("INSERT OR REPLACE INTO events (%1) VALUES (:id, :title, :description,"
+                                         " :location, :start, :end, :allDay, :categories, :rrule, :reminder,"
+                                         " :seriesId, :recurrenceId, :exceptionDates)")
+                              .arg(columns));
+    m_updateQuery.prepare(QStringLiteral(
+        "UPDATE events SET title = :title, description = :description, location = :location,"
+        " start_ms = :start, end_ms = :end, all_day = :allDay, categories = :categories,"
+        " recurrence_rule = :rrule, reminder_minutes = :reminder, series_id = :seriesId,"
+        " recurrence_id_ms = :recurrenceId, exception_dates = :exceptionDates WHERE id = :id"));
+    m_deleteQuery.prepare(QStringLiteral("DELETE FROM events WHERE id = :id"));
+}
+
+SqliteEventRepository::~SqliteEventRepository() = default;
+
+std::vector<CalendarEvent> SqliteEventRepository::fetchEvents(const QDate &from, const QDate &to) const
+{
+    std::vector<CalendarEvent> result;
+    if (!from.isValid() || !to.isValid()) {
+        return result;
+    }
+    const qint64 fromMs = from.startOfDay().toMSecsSinceEpoch();
+    const qint64 toMs = to.addDays(1).startOfDay().toMSecsSinceEpoch() - 1;
+    m_rangeQuery.bindValue(QStringLiteral(":windowStart"), fromMs - LONG_EVENT_MS);
+    m_rangeQuery.bindValue(QStringLiteral(":from"), fromMs);
+    m_rangeQuery.bindValue(QStringLiteral(":to"), toMs);
+    if (!m_rangeQuery.exec()) {
+        return result;
+    }
+    while (m_rangeQuery.next()) {
+        result.push_back(eventFromQuery(m_rangeQuery));
+    }
+    m_rangeQuery.finish();
+    return result;
+}
+
+QFuture<EventSnapshot> SqliteEventRepository::fetchAllEventsAsync(const CancellationToken &token) const
+{
+    if (token.isCancelled()) {
+        return finishedEventQuery({});
+    }
+    const QString filePath = m_database->filePath();
+    return QtConcurrent::run([filePath, token]() {
+        std::vector<CalendarEvent> events;
+        SqliteDatabase::readSeparately(filePath, [&events, &token](const QSqlDatabase &database) {
+            QSqlQuery query(database);
+            query.setForwardOnly(true);
+            if (!query.exec(QStringLiteral("SELECT %1 FROM events").arg(QLatin1String(EVENT_COLUMNS)))) {
+                return;
+            }
+            while (query.next() && !token.isCancelled()) {
+                events.push_back(eventFromQuery(query));
+            }
+        });
+        if (token.isCancelled()) {
+            return EventSnapshot();
+        }
+        return EventSnapshot::fromEvents(std::move(events));
+    });
+}
+
+std::vector<CalendarEvent> SqliteEventRepository::fetchSeriesEvents() const
+{
+    std::vector<CalendarEvent> result;
+    if (!m_seriesQuery.exec()) {
+        return result;
+    }
+    while (m_seriesQuery.next()) {
+        result.push_back(eventFromQuery(m_seriesQuery));
+    }
+    m_seriesQuery.finish();
+    return result;
+}
+
+std::optional<CalendarEvent> SqliteEventRepository::findById(const QUuid &id) const
+{
+    m_findQuery.bindValue(QStringLiteral(":id"), uidString(id));
+    if (!m_findQuery.exec() || !m_findQuery.next()) {
+        m_findQuery.finish();
+        return std::nullopt;
+    }
+    CalendarEvent event = eventFromQuery(m_findQuery);
+    m_findQuery.finish();
+    return event;
+}
+
+CalendarEvent SqliteEventRepository::addEvent(CalendarEvent event)
+{
+    if (event.id.isNull()) {
+        event.id = QUuid::createUuid();
+    }
+    if (!event.end.isValid() || event.end <= event.start) {
+        event.end = event.start.addSecs(30 * 60);
+    }
+    bindEvent(m_upsertQuery, event);
+    m_upsertQuery.exec();
+    return event;
+}
+
+bool SqliteEventRepository::updateEvent(const CalendarEvent &event)
+{
+    bindEvent(m_updateQuery, event);
+    return m_updateQuery.exec() && m_updateQuery.numRowsAffected() > 0;
+}
+
+bool SqliteEventRepository::removeEvent(const QUuid &id)
+{
+    m_deleteQuery.bindValue(QStringLiteral(":id"), uidString(id));
+    return m_deleteQuery.exec() && m_deleteQuery.numRowsAffected() > 0;
+}
+
+void SqliteEventRepository::beginBatch()
+{
+    m_database->beginBatch();
+}
+
+void SqliteEventRepository::commitBatch()
+{
+    m_database->commitBatch();
+}
+
+void SqliteEventRepository::bindEvent(QSqlQuery &query, const CalendarEvent &event) const
+{
+    query.bindValue(QStringLiteral(":id"), uidString(event.id));
+    query.bindValue(QStringLiteral(":title"), event.title);
+    query.bindValue(QStringLiteral(":description"), event.description);
+    query.bindValue(QStringLiteral(":location"), event.location);
+    query.bindValue(QStringLiteral(":start"), timestamp(event.start));
+    query.bindValue(QStringLiteral(":end"), timestamp(event.end));
+    query.bindValue(QStringLiteral(":allDay"), event.allDay);
+    query.bindValue(QStringLiteral(":categories"), event.categories.join(QLatin1String(CATEGORY_SEPARATOR)));
+    query.bindValue(QStringLiteral(":rrule"), event.recurrenceRule);
+    query.bindValue(QStringLiteral(":reminder"), event.reminderMinutes);
+    query.bindValue(QStringLiteral(":seriesId"),
+                    event.seriesId.isNull() ? QString() : uidString(event.seriesId));
+    query.bindValue(QStringLiteral(":recurrenceId"), timestamp(event.recurrenceId));
+    query.bindValue(QStringLiteral(":exceptionDates"), exceptionString(event.exceptionDates));
+}
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,166 @@
+#include "calendar/data/SqliteTodoRepository.hpp"
+
+#include "calendar/data/SqliteDatabase.hpp"
+
+#include <QVariant>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace calendar {
+namespace data {
+
+namespace {
+constexpr auto TAG_SEPARATOR = "\n";
+
+constexpr auto TODO_COLUMNS = "id, title, description, location, due_ms, priority, tags, status, scheduled, "
+                              "duration_minutes";
+
+QString uidString(const QUuid &id)
+{
+    return id.toString(QUuid::WithoutBraces);
+}
+
+TodoItem todoFromQuery(const QSqlQuery &query)
+{
+    TodoItem todo;
+    todo.id = QUuid::fromString(query.value(0).toString());
+    todo.title = query.value(1).toString();
+    todo.description = query.value(2).toString();
+    todo.location = query.value(3).toString();
+    const QVariant due = query.value(4);
+    if (!due.isNull()) {
+        todo.dueDate = QDateTime::fromMSecsSinceEpoch(due.toLongLong());
+    }
+    todo.priority = query.value(5).toInt();
+    const QString tags = query.value(6).toString();
+    if (!tags.isEmpty()) {
+        todo.tags = tags.split(QLatin1String(TAG_SEPARATOR));
+    }
+    const int status = query.value(7).toInt();
+    todo.status = status >= 0 && status <= static_cast<int>(TodoStatus::Completed) ? static_cast<TodoStatus>(status)
+                                                                                   : TodoStatus::Pending;
+    todo.scheduled = query.value(8).toBool();
+    todo.durationMinutes = query.value(9).toInt();
+    return todo;
+}
+} // namespace
+
+SqliteTodoRepository::SqliteTodoRepository(std::shared_ptr<SqliteDatabase> database)
+    : m_database(std::move(database))
+    , m_fetchQuery(m_database->database())
+    , m_findQuery(m_database->database())
+    , m_upsertQuery(m_database->database())
+    , m_updateQuery(m_database->database())
+    , m_deleteQuery(m_database->database())
+{
+    const QString columns = QLatin1String(TODO_COLUMNS);
+    m_fetchQuery.prepare(QStringLiteral("SELECT %1 FROM todos").arg(columns));
+    m_findQuery.prepare(QStringLiteral("SELECT %1 FROM todos WHERE id = :id").arg(columns));
+    m_upsertQuery.prepare(QStringLiteral("INSERT OR REPLACE INTO todos (%1) VALUES (:id, :title, :description,"
+                                         " :location, :due, :priority, :tags, :status, :scheduled, :duration)")
+                              .arg(columns));
+    m_updateQuery.prepare(QStringLiteral(
+        "UPDATE todos SET title = :title, description = :description, location = :location, due_ms = :due,"
+        " priority = :priority, tags = :tags, status = :status, scheduled = :scheduled,"
+        " duration_minutes = :duration WHERE id = :id"));
+    m_deleteQuery.prepare(QStringLiteral("DELETE FROM todos WHERE id = :id"));
+}
+
+SqliteTodoRepository::~SqliteTodoRepository() = default;
+
+std::vector<TodoItem> SqliteTodoRepository::fetchTodos() const
+{
+    std::vector<TodoItem> result;
+    if (!m_fetchQuery.exec()) {
+        return result;
+    }
+    while (m_fetchQuery.next()) {
+        result.push_back(todoFromQuery(m_fetchQuery));
+    }
+    m_fetchQuery.finish();
+    // Sorted here because SQLite's lower() only folds ASCII.
+    std::sort(result.begin(), result.end(), todoListedBefore);
+    return result;
+}
+
+QFuture<std::vector<TodoItem>> SqliteTodoRepository::fetchTodosAsync(const CancellationToken &token) const
+{
+    const QString filePath = m_database->filePath();
+    return QtConcurrent::run([filePath, token]() {
+        std::vector<TodoItem> todos;
+        SqliteDatabase::readSeparately(filePath, [&todos, &token](const QSqlDatabase &database) {
+            QSqlQuery query(database);
+            query.setForwardOnly(true);
+            if (!query.exec(QStringLiteral("SELECT %1 FROM todos").arg(QLatin1String(TODO_COLUMNS)))) {
+                return;
+            }
+            while (query.next() && !token.isCancelled()) {
+                todos.push_back(todoFromQuery(query));
+            }
+        });
+        std::sort(todos.begin(), todos.end(), todoListedBefore);
+        return todos;
+    });
+}
+
+std::optional<TodoItem> SqliteTodoRepository::findById(const QUuid &id) const
+{
+    m_findQuery.bindValue(QStringLiteral(":id"), uidString(id));
+    if (!m_findQuery.exec() || !m_findQuery.next()) {
+        m_findQuery.finish();
+        return std::nullopt;
+    }
+    TodoItem todo = todoFromQuery(m_findQuery);
+    m_findQuery.finish();
+    return todo;
+}
+
+TodoItem SqliteTodoRepository::addTodo(TodoItem todo)
+{
+    if (todo.id.isNull()) {
+        todo.id = QUuid::createUuid();
+    }
+    bindTodo(m_upsertQuery, todo);
+    m_upsertQuery.exec();
+    return todo;
+}
+
+bool SqliteTodoRepository::updateTodo(const TodoItem &todo)
+{
+    bindTodo(m_updateQuery, todo);
+    return m_updateQuery.exec() && m_updateQuery.numRowsAffected() > 0;
+}
+
+bool SqliteTodoRepository::removeTodo(const QUuid &id)
+{
+    m_deleteQuery.bindValue(QStringLiteral(":id"), uidString(id));
+    return m_deleteQuery.exec() && m_deleteQuery.numRowsAffected() > 0;
+}
+
+void SqliteTodoRepository::beginBatch()
+{
+    m_database->beginBatch();
+}
+
+void SqliteTodoRepository::commitBatch()
+{
+    m_database->commitBatch();
+}
+
+void SqliteTodoRepository::bindTodo(QSqlQuery &query, const TodoItem &todo) const
+{
+    query.bindValue(QStringLiteral(":id"), uidString(todo.id));
+    query.bindValue(QStringLiteral(":title"), todo.title);
+    query.bindValue(QStringLiteral(":description"), todo.description);
+    query.bindValue(QStringLiteral(":location"), todo.location);
+    query.bindValue(QStringLiteral(":due"),
+                    todo.dueDate.isValid() ? QVariant(todo.dueDate.toMSecsSinceEpoch()) : QVariant());
+    query.bindValue(QStringLiteral(":priority"), todo.priority);
+    query.bindValue(QStringLiteral(":tags"), todo.tags.join(QLatin1String(TAG_SEPARATOR)));
+    query.bindValue(QStringLiteral(":status"), static_cast<int>(todo.status));
+    query.bindValue(QStringLiteral(":scheduled"), todo.scheduled);
+    query.bindValue(QStringLiteral(":duration"), todo.durationMinutes);
+}
+
+} // namespace data
+} // namespace calendar
@@ -0,0 +1,64 @@
+#include "calendar/data/TodoOrderIndex.hpp"
+
+namespace calendar {
+namespace data {
+
+bool TodoOrderIndex::Key::operator<(const Key &other) const
+{
+    if (priority != other.priority) {
+        return priority > other.priority;
+    }
+    if (foldedTitle != other.foldedTitle) {
+        return foldedTitle < other.foldedTitle;
+    }
+    return id < other.id;
+}
+
+void TodoOrderIndex::insert(const TodoItem &todo)
+{
+    Key key{todo.priority, todo.title.toLower(), todo.id};
+    const auto existing = m_keys.constFind(todo.id);
+    if (existing != m_keys.constEnd()) {
+        // Most updates (status, due date, tags) leave the position alone.
+        if (existing.value()->priority == key.priority && existing.value()->foldedTitle == key.foldedTitle) {
+            return;
+        }
+        m_order.erase(existing.value());
+    }
+    m_keys.insert(todo.id, m_order.insert(std::move(key)).first);
+}
+
+bool TodoOrderIndex::remove(const QUuid &id)
+{
+    const auto it = m_keys.find(id);
+    if (it == m_keys.end()) {
+        return false;
+    }
+    m_order.erase(it.value());
+    m_keys.erase(it);
+    return true;
+}
+
+void TodoOrderIndex::clear()
+{
+    m_order.clear();
+    m_keys.clear();
+}
+
+int TodoOrderIndex::size() const
+{
+    return static_cast<int>(m_order.size());
+}
+
+std::vector<QUuid> TodoOrderIndex::ids() const
+{
+    std::vector<QUuid> result;
+    result.reserve(m_order.size());
+    for (const Key &key : m_order) {
+        result.push_back(key.id);
+    }
+    return result;
+}
+
+} // namespace data
+} // namespace calendar
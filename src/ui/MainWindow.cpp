@@ -38,9 +38,15 @@
 #include "calendar/core/AppContext.hpp"
 #include "calendar/core/UndoCommand.hpp"
 #include "calendar/core/UndoStack.hpp"
+#include "calendar/data/CalendarSearch.hpp"
+#include "calendar/data/DataProvider.hpp"
 #include "calendar/data/Event.hpp"
 #include "calendar/data/EventRepository.hpp"
 #include "calendar/data/FileCalendarStorage.hpp"
+#include "calendar/data/IcsParser.hpp"
+#include "calendar/data/ObservableEventRepository.hpp"
+#include "calendar/data/ObservableTodoRepository.hpp"
+#include "calendar/data/RepositoryBatch.hpp"
 #include "calendar/data/TodoRepository.hpp"
 #include "calendar/ui/models/TodoFilterProxyModel.hpp"
 #include "calendar/ui/models/TodoListModel.hpp"
@@ -232,6 +238,7 @@ public:
 
     void redo() override
     {
+        calendar::data::RepositoryBatch batch(m_repository);
         m_createdItems.clear();
         for (auto item : m_templates) {
             item.id = QUuid();
@@ -241,6 +248,7 @@ public:
 
     void undo() override
     {
+        calendar::data::RepositoryBatch batch(m_repository);
         for (const auto &item : m_createdItems) {
             m_repository.removeTodo(item.id);
         }
@@ -330,12 +338,46 @@ void MainWindow::setupUi()
         connect(m_scheduleViewModel.get(),
                 &ScheduleViewModel::eventsChanged,
                 this,
-                [this](const std::vector<data::CalendarEvent> &events) {
+                [this](const data::EventSnapshot &events) {
                     if (m_calendarView) {
                         m_calendarView->setEvents(events);
                     }
                 });
     }
+    // Mutations are patched into the view models as they happen; no need to re-query afterwards.
+    auto &dataProvider = m_appContext->dataProvider();
+    if (m_scheduleViewModel) {
+        connect(&dataProvider.eventRepository(),
+                &data::ObservableEventRepository::eventsChanged,
+                m_scheduleViewModel.get(),
+                &ScheduleViewModel::applyChanges);
+    }
+    if (m_todoViewModel) {
+        connect(&dataProvider.todoRepository(),
+                &data::ObservableTodoRepository::todosChanged,
+                m_todoViewModel.get(),
+                &TodoListViewModel::applyChanges);
+    }
+    // The search index has seen the change by now; only an active search needs to be redone.
+    connect(&dataProvider.eventRepository(), &data::ObservableEventRepository::eventsChanged, this, [this]() {
+        if (!m_eventSearchFilter.trimmed().isEmpty()) {
+            updateEventSearchFilter();
+        }
+    });
+    connect(&dataProvider.todoRepository(), &data::ObservableTodoRepository::todosChanged, this, [this]() {
+        if (m_todoSearchField && !m_todoSearchField->text().isEmpty()) {
+            updateTodoFilterText(m_todoSearchField->text());
+        }
+    });
+    // Searches made while the index was built compared the texts; the index answers them now.
+    connect(&dataProvider.search(), &data::CalendarSearch::indexReady, this, [this]() {
+        if (!m_eventSearchFilter.trimmed().isEmpty()) {
+            updateEventSearchFilter();
+        }
+        if (m_todoSearchField && !m_todoSearchField->text().isEmpty()) {
+            updateTodoFilterText(m_todoSearchField->text());
+        }
+    });
     updateCalendarRange();
     if (statusBar() && !m_shortcutLabel) {
         m_shortcutLabel = new QLabel(tr("Shortcuts: ⏎ Details • E Inline • Ctrl+C Copy • Ctrl+V Paste • Ctrl+D Duplizieren • Del Löschen • Space Info"),
@@ -346,6 +388,19 @@ void MainWindow::setupUi()
     } else if (statusBar()) {
         statusBar()->showMessage(tr("Bereit"));
     }
+    auto *storage = m_appContext->dataProvider().calendarStorage();
+    if (storage && statusBar()) {
+        m_saveStateLabel = new QLabel(storage->isWriting() ? tr("Speichern…") : tr("Gespeichert"), this);
+        m_saveStateLabel->setObjectName(QStringLiteral("saveStateLabel"));
+        statusBar()->addPermanentWidget(m_saveStateLabel);
+        connect(storage, &data::FileCalendarStorage::writingChanged, this, [this](bool writing) {
+            m_saveStateLabel->setText(writing ? tr("Speichern…") : tr("Gespeichert"));
+        });
+        connect(storage, &data::FileCalendarStorage::writeFailed, this, [this](const QString &errorString) {
+            m_saveStateLabel->setText(tr("Speichern fehlgeschlagen"));
+            statusBar()->showMessage(tr("Kalender konnte nicht gespeichert werden: %1").arg(errorString), 5000);
+        });
+    }
 }
 
 QToolBar *MainWindow::createNavigationBar()
@@ -420,9 +475,7 @@ QWidget *MainWindow::createTodoPanel()
     connect(m_todoSearchField, &QLineEdit::textChanged, this, [this](const QString &text) {
         updateTodoFilterText(text);
         m_eventSearchFilter = text;
-        if (m_calendarView) {
-            m_calendarView->setEventSearchFilter(text);
-        }
+        updateEventSearchFilter();
     });
     m_todoSearchField->installEventFilter(this);
     m_eventSearchFilter = m_todoSearchField->text();
@@ -514,7 +567,7 @@ QWidget *MainWindow::createCalendarView()
     layout->setSpacing(0);
 
     m_calendarView = new CalendarView(panel);
-    m_calendarView->setEventSearchFilter(m_eventSearchFilter);
+    updateEventSearchFilter();
     m_calendarView->setHourHeight(m_savedHourHeight);
     m_calendarView->setVerticalScrollValue(m_savedVerticalScroll);
     connect(m_calendarView, &CalendarView::eventActivated, this, [this](const data::CalendarEvent &event) {
@@ -587,7 +640,6 @@ void MainWindow::setupShortcuts(QToolBar *toolbar)
         if (m_eventDetailDialog->exec() == QDialog::Accepted) {
             auto created = m_eventDetailDialog->event();
             m_appContext->eventRepository().addEvent(created);
-            refreshCalendar();
             statusBar()->showMessage(tr("Termin erstellt"), 1500);
         }
     });
@@ -744,20 +796,31 @@ TodoFilterProxyModel *MainWindow::proxyForView(QListView *view) const
 
 void MainWindow::updateTodoFilterText(const QString &text)
 {
+    const data::TodoMatches matches = m_appContext->dataProvider().search().matchingTodos(text);
     if (m_pendingProxyModel) {
-        m_pendingProxyModel->setFilterText(text);
+        m_pendingProxyModel->setFilterText(text, matches);
     }
     if (m_inProgressProxyModel) {
-        m_inProgressProxyModel->setFilterText(text);
+        m_inProgressProxyModel->setFilterText(text, matches);
     }
     if (m_doneProxyModel) {
-        m_doneProxyModel->setFilterText(text);
+        m_doneProxyModel->setFilterText(text, matches);
     }
 }
 
+void MainWindow::updateEventSearchFilter()
+{
+    if (!m_calendarView) {
+        return;
+    }
+    const QString text = m_eventSearchFilter.trimmed();
+    m_calendarView->setEventSearchFilter(text, m_appContext->dataProvider().search().matchingEvents(text));
+}
+
 void MainWindow::handleTodoStatusDrop(const QList<QUuid> &todoIds, data::TodoStatus status)
 {
     bool changed = false;
+    data::RepositoryBatch batch(m_appContext->todoRepository());
     for (const auto &id : todoIds) {
         auto todo = m_appContext->todoRepository().findById(id);
         if (!todo.has_value()) {
@@ -769,10 +832,10 @@ void MainWindow::handleTodoStatusDrop(const QList<QUuid> &todoIds, data::TodoSta
         todo->status = status;
         changed |= m_appContext->todoRepository().updateTodo(*todo);
     }
+    batch.commit();
     if (changed) {
         clearAllTodoSelections();
         m_selectedTodo.reset();
-        refreshTodos();
         statusBar()->showMessage(tr("TODO-Status aktualisiert"), 1500);
     }
 }
@@ -927,13 +990,15 @@ void MainWindow::deleteSelectedTodos()
         return;
     }
     bool removed = false;
-    for (const auto &todo : todos) {
-        removed |= m_appContext->todoRepository().removeTodo(todo.id);
+    {
+        data::RepositoryBatch batch(m_appContext->todoRepository());
+        for (const auto &todo : todos) {
+            removed |= m_appContext->todoRepository().removeTodo(todo.id);
+        }
     }
     if (removed) {
         clearAllTodoSelections();
         m_selectedTodo.reset();
-        refreshTodos();
         statusBar()->showMessage(tr("Ausgewählte TODOs gelöscht"), 1500);
     }
 }
@@ -1116,7 +1181,6 @@ void MainWindow::saveEventEdits(const data::CalendarEvent &event)
     if (m_calendarView) {
         m_calendarView->clearGhostPreview();
     }
-    refreshCalendar();
     statusBar()->showMessage(created ? tr("Termin erstellt: %1").arg(updated.title)
                                      : tr("Termin gespeichert: %1").arg(updated.title),
                              1500);
@@ -1138,7 +1202,6 @@ void MainWindow::saveTodoEdits(const data::TodoItem &todo)
         m_eventEditor->clearEditor();
         setInlineEditorActive(false);
     }
-    refreshTodos();
     statusBar()->showMessage(tr("TODO gespeichert: %1").arg(updated.title), 1500);
     if (m_previewVisible) {
         showPreviewForSelection();
@@ -1157,7 +1220,6 @@ void MainWindow::applyEventResize(const QUuid &id, const QDateTime &newStart, co
     if (m_selectedEvent && m_selectedEvent->id == id && m_eventEditor && m_eventEditor->isVisible()) {
         m_eventEditor->setEvent(*existing);
     }
-    refreshCalendar();
     statusBar()->showMessage(tr("Termin angepasst: %1").arg(existing->title), 1500);
 }
 
@@ -1198,17 +1260,18 @@ void MainWindow::handleTodoDropped(const QUuid &todoId, const QDateTime &start,
     const int durationMinutes = todoOpt->durationMinutes > 0 ? todoOpt->durationMinutes : 60;
     event.end = start.addSecs(durationMinutes * 60);
     event.location = todoOpt->location;
-    m_appContext->eventRepository().addEvent(event);
-    if (!copy) {
-        m_appContext->todoRepository().removeTodo(todoId);
+    {
+        data::RepositoryBatch batch(m_appContext->eventRepository(), m_appContext->todoRepository());
+        m_appContext->eventRepository().addEvent(event);
+        if (!copy) {
+            m_appContext->todoRepository().removeTodo(todoId);
+        }
     }
 
     if (!copy) {
         clearAllTodoSelections();
         m_selectedTodo.reset();
-        refreshTodos();
     }
-    refreshCalendar();
     statusBar()->showMessage(copy ? tr("TODO \"%1\" dupliziert").arg(todoOpt->title)
                                   : tr("TODO \"%1\" eingeplant").arg(todoOpt->title),
                              2000);
@@ -1285,7 +1348,6 @@ void MainWindow::handleEventDropRequested(const QUuid &eventId, const QDateTime
         m_appContext->eventRepository().updateEvent(eventData);
         statusBar()->showMessage(tr("Termin verschoben"), 1500);
     }
-    refreshCalendar();
 }
 
 void MainWindow::handleEventDroppedToTodo(const data::CalendarEvent &event, data::TodoStatus status)
@@ -1301,13 +1363,14 @@ void MainWindow::handleEventDroppedToTodo(const data::CalendarEvent &event, data
     const qint64 durationMinutes = qMax<qint64>(15, event.start.secsTo(event.end) / 60);
     todo.durationMinutes = static_cast<int>(durationMinutes);
 
-    m_appContext->todoRepository().addTodo(todo);
-    m_appContext->eventRepository().removeEvent(event.id);
+    {
+        data::RepositoryBatch batch(m_appContext->eventRepository(), m_appContext->todoRepository());
+        m_appContext->todoRepository().addTodo(todo);
+        m_appContext->eventRepository().removeEvent(event.id);
+    }
     if (m_selectedEvent && m_selectedEvent->id == event.id) {
         clearSelection();
     }
-    refreshTodos();
-    refreshCalendar();
     clearTodoHoverGhosts();
     statusBar()->showMessage(tr("Termin \"%1\" als TODO erfasst").arg(todo.title), 2000);
 }
@@ -1453,7 +1516,6 @@ void MainWindow::openDetailDialog()
         auto updated = m_eventDetailDialog->event();
         m_appContext->eventRepository().updateEvent(updated);
         m_selectedEvent = updated;
-        refreshCalendar();
         statusBar()->showMessage(tr("Termin aktualisiert"), 1500);
         if (m_previewVisible) {
             showPreviewForSelection();
@@ -1596,6 +1658,7 @@ void MainWindow::pasteClipboardAt(const QDateTime &targetStart)
         return;
     }
     const auto baseStart = m_clipboardEvents.front().start;
+    data::RepositoryBatch batch(m_appContext->eventRepository());
     for (const auto &event : m_clipboardEvents) {
         data::CalendarEvent copy = event;
         copy.id = QUuid::createUuid();
@@ -1605,7 +1668,7 @@ void MainWindow::pasteClipboardAt(const QDateTime &targetStart)
         copy.end = copy.start.addSecs(duration);
         m_appContext->eventRepository().addEvent(copy);
     }
-    refreshCalendar();
+    batch.commit();
     statusBar()->showMessage(tr("%1 Termin(e) eingefügt").arg(m_clipboardEvents.size()), 2000);
 }
 
@@ -1710,7 +1773,6 @@ int MainWindow::insertTodosFromPlainText(const QString &text, data::TodoStatus s
     }
     auto command = std::make_unique<PlainTextInsertCommand>(m_appContext->todoRepository(), std::move(templates));
     m_appContext->undoStack().push(std::move(command));
-    refreshTodos();
     return parsed.size();
 }
 
@@ -1724,9 +1786,10 @@ void MainWindow::performUndo()
         statusBar()->showMessage(tr("Nichts zum Rückgängig machen"), 1500);
         return;
     }
-    stack.undo();
-    refreshTodos();
-    refreshCalendar();
+    {
+        data::RepositoryBatch batch(m_appContext->eventRepository(), m_appContext->todoRepository());
+        stack.undo();
+    }
     statusBar()->showMessage(tr("Aktion rückgängig gemacht"), 2000);
 }
 
@@ -1740,9 +1803,10 @@ void MainWindow::performRedo()
         statusBar()->showMessage(tr("Nichts zum Wiederholen"), 1500);
         return;
     }
-    stack.redo();
-    refreshTodos();
-    refreshCalendar();
+    {
+        data::RepositoryBatch batch(m_appContext->eventRepository(), m_appContext->todoRepository());
+        stack.redo();
+    }
     statusBar()->showMessage(tr("Aktion wiederholt"), 2000);
 }
 
@@ -1757,6 +1821,7 @@ void MainWindow::handleIcsFileDrop(const QStringList &paths)
             continue;
         }
         std::optional<data::CalendarEvent> firstCreated;
+        data::RepositoryBatch batch(m_appContext->eventRepository());
         for (auto event : importedEvents) {
             if (!event.start.isValid()) {
                 continue;
@@ -1766,6 +1831,7 @@ void MainWindow::handleIcsFileDrop(const QStringList &paths)
                 firstCreated = created;
             }
         }
+        batch.commit();
         if (firstCreated.has_value()) {
             statusBar()->showMessage(tr("Termin importiert: %1").arg(firstCreated->title), 2500);
             focusEventForEditing(*firstCreated);
@@ -1781,8 +1847,9 @@ std::vector<data::CalendarEvent> MainWindow::loadEventsFromIcs(const QString &fi
     if (filePath.isEmpty()) {
         return events;
     }
-    data::FileCalendarStorage storage(filePath);
-    const auto hash = storage.events();
+    data::IcsParser::Collector collector;
+    data::IcsParser::parseFileConcurrently(filePath, collector);
+    const auto &hash = collector.events;
     events.reserve(hash.size());
     for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
         events.push_back(it.value());
@@ -1933,7 +2000,6 @@ void MainWindow::deleteSelection()
                 m_previewPanel->clearPreview();
             }
             m_previewVisible = false;
-            refreshCalendar();
         }
         return;
     }
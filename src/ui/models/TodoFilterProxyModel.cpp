@@ -12,12 +12,13 @@ TodoFilterProxyModel::TodoFilterProxyModel(QObject *parent)
     setSortCaseSensitivity(Qt::CaseInsensitive);
 }
 
-void TodoFilterProxyModel::setFilterText(const QString &text)
+void TodoFilterProxyModel::setFilterText(const QString &text, data::TodoMatches matches)
 {
-    if (m_filterText == text) {
+    if (m_filterText.isEmpty() && text.isEmpty()) {
         return;
     }
     m_filterText = text;
+    m_matches = std::move(matches);
     invalidateFilter();
 }
 
@@ -42,11 +43,8 @@ bool TodoFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &so
         return true;
     }
 
-    if (!m_filterText.isEmpty()) {
-        const auto text = m_filterText.toLower();
-        if (!todo->title.toLower().contains(text) && !todo->description.toLower().contains(text)) {
-            return false;
-        }
+    if (!m_filterText.isEmpty() && !m_matches.contains(*todo)) {
+        return false;
     }
 
     if (m_statusFilter.has_value() && todo->status != m_statusFilter.value()) {
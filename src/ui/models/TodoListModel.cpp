@@ -100,6 +100,11 @@ void TodoListModel::setTodos(QVector<data::TodoItem> todos)
     endResetModel();
 }
 
+const QVector<data::TodoItem> &TodoListModel::todos() const
+{
+    return m_todos;
+}
+
 const data::TodoItem *TodoListModel::todoAt(const QModelIndex &index) const
 {
     if (!index.isValid() || index.row() < 0 || index.row() >= m_todos.size()) {
@@ -108,6 +113,44 @@ const data::TodoItem *TodoListModel::todoAt(const QModelIndex &index) const
     return &m_todos.at(index.row());
 }
 
+int TodoListModel::rowOf(const QUuid &id) const
+{
+    for (int row = 0; row < m_todos.size(); ++row) {
+        if (m_todos.at(row).id == id) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+void TodoListModel::insertTodo(int row, data::TodoItem todo)
+{
+    row = qBound(0, row, m_todos.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_todos.insert(row, std::move(todo));
+    endInsertRows();
+}
+
+void TodoListModel::replaceTodo(int row, data::TodoItem todo)
+{
+    if (row < 0 || row >= m_todos.size()) {
+        return;
+    }
+    m_todos[row] = std::move(todo);
+    const QModelIndex changed = index(row, 0);
+    emit dataChanged(changed, changed);
+}
+
+void TodoListModel::removeTodoAt(int row)
+{
+    if (row < 0 || row >= m_todos.size()) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    m_todos.remove(row);
+    endRemoveRows();
+}
+
 void TodoListModel::setKeywordColors(QHash<QString, QColor> colors)
 {
     m_keywordColors = std::move(colors);
@@ -2,20 +2,127 @@
 
 #include "calendar/data/EventRepository.hpp"
 
+#include <QFutureWatcher>
+#include <QTimer>
+#include <algorithm>
+
 namespace calendar {
 namespace ui {
 
+namespace {
+// Day ranges kept in memory; the least recently used one is dropped beyond that.
+constexpr int MAX_CACHED_RANGES = 8;
+
+bool startsBefore(const data::EventHandle &lhs, const data::EventHandle &rhs)
+{
+    if (lhs->start == rhs->start) {
+        return lhs->end < rhs->end;
+    }
+    return lhs->start < rhs->start;
+}
+
+bool isSeriesMaster(const data::CalendarEvent &event)
+{
+    return !event.recurrenceRule.isEmpty();
+}
+
+bool touchesSeriesMaster(const data::EventChangeSet &changes)
+{
+    const auto updatesMaster = [](const auto &update) {
+        return isSeriesMaster(update.before) || isSeriesMaster(update.after);
+    };
+    return std::any_of(changes.inserted.begin(), changes.inserted.end(), isSeriesMaster)
+           || std::any_of(changes.removed.begin(), changes.removed.end(), isSeriesMaster)
+           || std::any_of(changes.updated.begin(), changes.updated.end(), updatesMaster);
+}
+
+bool touchesRange(const data::CalendarEvent &event, const QDate &start, const QDate &end)
+{
+    // Same condition as the repositories use for fetchEvents().
+    return !(event.end.date() < start || event.start.date() > end);
+}
+
+data::EventSnapshot sortedByStart(data::EventSnapshot events)
+{
+    // Repositories return their events sorted already; only then is the snapshot kept as is.
+    const auto &handles = events.handles();
+    if (std::is_sorted(handles.begin(), handles.end(), startsBefore)) {
+        return events;
+    }
+    std::vector<data::EventHandle> sorted = handles;
+    std::stable_sort(sorted.begin(), sorted.end(), startsBefore);
+    return data::EventSnapshot(std::move(sorted));
+}
+
+data::EventSnapshot eventsInRange(const data::EventSnapshot &events, const QDate &start, const QDate &end)
+{
+    std::vector<data::EventHandle> result;
+    for (const data::EventHandle &event : events.handles()) {
+        if (touchesRange(*event, start, end)) {
+            result.push_back(event);
+        }
+    }
+    return data::EventSnapshot(std::move(result));
+}
+
+// Applies removals, then updates and insertions (upserts) to the events of one day range.
+data::EventSnapshot patched(const data::EventSnapshot &events,
+                            const QDate &start,
+                            const QDate &end,
+                            const std::vector<QUuid> &removed,
+                            const std::vector<data::EventHandle> &upserts,
+                            bool &changed)
+{
+    std::vector<data::EventHandle> result = events.handles();
+    const auto erase = [&result](const QUuid &id) {
+        const auto it = std::find_if(result.begin(), result.end(), [&id](const data::EventHandle &event) {
+            return event->id == id;
+        });
+        if (it == result.end()) {
+            return false;
+        }
+        result.erase(it);
+        return true;
+    };
+    bool modified = false;
+    for (const QUuid &id : removed) {
+        modified |= erase(id);
+    }
+    for (const data::EventHandle &event : upserts) {
+        modified |= erase(event->id);
+        if (touchesRange(*event, start, end)) {
+            result.insert(std::upper_bound(result.begin(), result.end(), event, startsBefore), event);
+            modified = true;
+        }
+    }
+    if (!modified) {
+        return events;
+    }
+    changed = true;
+    return data::EventSnapshot(std::move(result));
+}
+} // namespace
+
 ScheduleViewModel::ScheduleViewModel(data::EventRepository &repository, QObject *parent)
     : QObject(parent)
     , m_repository(repository)
 {
 }
 
+ScheduleViewModel::~ScheduleViewModel()
+{
+    m_queryToken.cancel();
+    m_prefetchToken.cancel();
+}
+
 void ScheduleViewModel::setRange(const QDate &start, const QDate &end)
 {
     if (!start.isValid() || !end.isValid()) {
         return;
     }
+    if (m_start.isValid() && start != m_start) {
+        m_direction = start > m_start ? 1 : -1;
+    }
     m_start = start;
     m_end = end;
 }
@@ -25,14 +132,209 @@ void ScheduleViewModel::refresh()
     if (!m_start.isValid() || !m_end.isValid()) {
         return;
     }
-    m_events = m_repository.fetchEvents(m_start, m_end);
-    emit eventsChanged(m_events);
+    m_queryToken.cancel();
+    m_queryToken = data::CancellationToken();
+    const quint64 generation = ++m_queryGeneration;
+    if (auto cached = cachedEvents(m_start, m_end)) {
+        m_queryPending = false;
+        applySnapshot(std::move(*cached));
+        prefetch();
+        return;
+    }
+
+    const QDate start = m_start;
+    const QDate end = m_end;
+    const quint64 cacheGeneration = m_cacheGeneration;
+    const QFuture<data::EventSnapshot> query = m_repository.fetchEventsAsync(start, end, m_queryToken);
+    if (query.isFinished()) {
+        m_queryPending = false;
+        applySnapshot(query.result());
+        storeRange(start, end, m_events);
+        prefetch();
+        return;
+    }
+
+    m_queryPending = true;
+    auto *watcher = new QFutureWatcher<data::EventSnapshot>(this);
+    connect(watcher,
+            &QFutureWatcher<data::EventSnapshot>::finished,
+            this,
+            [this, watcher, generation, cacheGeneration, start, end]() {
+                watcher->deleteLater();
+                // A newer query was issued meanwhile; this result is for a range that is gone.
+                if (generation != m_queryGeneration) {
+                    return;
+                }
+                m_queryPending = false;
+                applySnapshot(watcher->result());
+                // Changes that arrived meanwhile were not patched into the result.
+                if (cacheGeneration == m_cacheGeneration) {
+                    storeRange(start, end, m_events);
+                }
+                prefetch();
+            });
+    watcher->setFuture(query);
 }
 
-const std::vector<data::CalendarEvent> &ScheduleViewModel::events() const
+bool ScheduleViewModel::isLoading() const
+{
+    return m_queryPending;
+}
+
+void ScheduleViewModel::applyChanges(const data::EventChangeSet &changes)
+{
+    if (!m_start.isValid() || !m_end.isValid() || changes.isEmpty()) {
+        return;
+    }
+    // Queries still running may have missed the changes.
+    ++m_cacheGeneration;
+    m_prefetchToken.cancel();
+    m_prefetchStart = QDate();
+    m_prefetchEnd = QDate();
+    // A changed master changes its occurrences, which are not in the change set.
+    if (touchesSeriesMaster(changes)) {
+        clearCache();
+        refresh();
+        return;
+    }
+
+    std::vector<QUuid> removed;
+    removed.reserve(changes.removed.size());
+    for (const auto &event : changes.removed) {
+        removed.push_back(event.id);
+    }
+    std::vector<data::EventHandle> upserts;
+    upserts.reserve(changes.updated.size() + changes.inserted.size());
+    for (const auto &update : changes.updated) {
+        upserts.push_back(std::make_shared<const data::CalendarEvent>(update.after));
+    }
+    for (const auto &event : changes.inserted) {
+        upserts.push_back(std::make_shared<const data::CalendarEvent>(event));
+    }
+    for (CachedRange &range : m_cache) {
+        bool rangeChanged = false;
+        range.events = patched(range.events, range.start, range.end, removed, upserts, rangeChanged);
+    }
+    // The result of a running query would replace any patch.
+    if (m_queryPending) {
+        refresh();
+        return;
+    }
+    bool changed = false;
+    m_events = patched(m_events, m_start, m_end, removed, upserts, changed);
+    if (changed) {
+        emit eventsChanged(m_events);
+    }
+}
+
+const data::EventSnapshot &ScheduleViewModel::events() const
 {
     return m_events;
 }
 
+void ScheduleViewModel::clearCache()
+{
+    m_cache.clear();
+    ++m_cacheGeneration;
+    m_prefetchToken.cancel();
+    m_prefetchStart = QDate();
+    m_prefetchEnd = QDate();
+}
+
+int ScheduleViewModel::cachedRangeCount() const
+{
+    return static_cast<int>(m_cache.size());
+}
+
+void ScheduleViewModel::applySnapshot(data::EventSnapshot events)
+{
+    m_events = sortedByStart(std::move(events));
+    emit eventsChanged(m_events);
+}
+
+std::optional<data::EventSnapshot> ScheduleViewModel::cachedEvents(const QDate &start, const QDate &end)
+{
+    for (CachedRange &range : m_cache) {
+        if (range.start > start || range.end < end) {
+            continue;
+        }
+        range.lastUse = ++m_useClock;
+        if (range.start == start && range.end == end) {
+            return range.events;
+        }
+        return eventsInRange(range.events, start, end);
+    }
+    return std::nullopt;
+}
+
+void ScheduleViewModel::storeRange(const QDate &start, const QDate &end, const data::EventSnapshot &events)
+{
+    for (CachedRange &range : m_cache) {
+        if (range.start == start && range.end == end) {
+            range.events = events;
+            range.lastUse = ++m_useClock;
+            return;
+        }
+    }
+    if (static_cast<int>(m_cache.size()) >= MAX_CACHED_RANGES) {
+        const auto oldest = std::min_element(m_cache.begin(),
+                                             m_cache.end(),
+                                             [](const CachedRange &lhs, const CachedRange &rhs) {
+                                                 return lhs.lastUse < rhs.lastUse;
+                                             });
+        m_cache.erase(oldest);
+    }
+    m_cache.push_back({start, end, events, ++m_useClock});
+}
+
+void ScheduleViewModel::prefetch()
+{
+    // The visible range plus the next one in the direction of navigation, or both neighbours
+    // before the first move, so that moving by up to a whole range stays within it.
+    const qint64 span = m_start.daysTo(m_end) + 1;
+    const QDate start = m_direction > 0 ? m_start : m_start.addDays(-span);
+    const QDate end = m_direction < 0 ? m_end : m_end.addDays(span);
+    const bool cached = std::any_of(m_cache.begin(), m_cache.end(), [&start, &end](const CachedRange &range) {
+        return range.start <= start && range.end >= end;
+    });
+    if (cached || (start == m_prefetchStart && end == m_prefetchEnd)) {
+        return;
+    }
+    m_prefetchToken.cancel();
+    m_prefetchToken = data::CancellationToken();
+    m_prefetchStart = start;
+    m_prefetchEnd = end;
+
+    const data::CancellationToken token = m_prefetchToken;
+    const quint64 cacheGeneration = m_cacheGeneration;
+    const auto store = [this, token, cacheGeneration, start, end](const data::EventSnapshot &events) {
+        if (token.isCancelled()) {
+            return;
+        }
+        m_prefetchStart = QDate();
+        m_prefetchEnd = QDate();
+        if (cacheGeneration == m_cacheGeneration) {
+            storeRange(start, end, sortedByStart(events));
+        }
+    };
+    // Deferred, so that synchronous backends only answer once the visible range is painted.
+    QTimer::singleShot(0, this, [this, token, store, start, end]() {
+        if (token.isCancelled()) {
+            return;
+        }
+        const QFuture<data::EventSnapshot> query = m_repository.fetchEventsAsync(start, end, token);
+        if (query.isFinished()) {
+            store(query.result());
+            return;
+        }
+        auto *watcher = new QFutureWatcher<data::EventSnapshot>(this);
+        connect(watcher, &QFutureWatcher<data::EventSnapshot>::finished, this, [watcher, store]() {
+            watcher->deleteLater();
+            store(watcher->result());
+        });
+        watcher->setFuture(query);
+    });
+}
+
 } // namespace ui
 } // namespace calendar
@@ -1,6 +1,7 @@
 #include "calendar/ui/viewmodels/TodoListViewModel.hpp"
 
 #include <QVector>
+#include <algorithm>
 
 #include "calendar/data/TodoRepository.hpp"
 #include "calendar/ui/models/TodoListModel.hpp"
@@ -32,5 +33,37 @@ void TodoListViewModel::refresh()
     emit todosChanged();
 }
 
+void TodoListViewModel::applyChanges(const data::TodoChangeSet &changes)
+{
+    if (changes.isEmpty()) {
+        return;
+    }
+    for (const auto &todo : changes.removed) {
+        m_model->removeTodoAt(m_model->rowOf(todo.id));
+    }
+    for (const auto &update : changes.updated) {
+        const int row = m_model->rowOf(update.after.id);
+        if (row >= 0 && update.before.priority == update.after.priority
+            && update.before.title.toLower() == update.after.title.toLower()) {
+            m_model->replaceTodo(row, update.after);
+            continue;
+        }
+        m_model->removeTodoAt(row);
+        insertListed(update.after);
+    }
+    for (const auto &todo : changes.inserted) {
+        m_model->removeTodoAt(m_model->rowOf(todo.id));
+        insertListed(todo);
+    }
+    emit todosChanged();
+}
+
+void TodoListViewModel::insertListed(data::TodoItem todo)
+{
+    const auto &todos = m_model->todos();
+    const auto position = std::upper_bound(todos.cbegin(), todos.cend(), todo, data::todoListedBefore);
+    m_model->insertTodo(static_cast<int>(position - todos.cbegin()), std::move(todo));
+}
+
 } // namespace ui
 } // namespace calendar
@@ -26,6 +26,7 @@
 #include <array>
 #include <cmath>
 #include <map>
+#include <numeric>
 #include <limits>
 #include <QFontMetricsF>
 #include <QToolTip>
@@ -40,6 +41,8 @@ namespace ui {
 
 namespace {
 constexpr double MinHourHeight = 20.0;
+// Days beyond the visible range whose layouts are kept for scrolling back.
+constexpr int LayoutCacheMarginDays = 62;
 constexpr double MaxHourHeight = 160.0;
 constexpr double HandleZone = 8.0;
 constexpr int SnapIntervalMinutes = 15;
@@ -234,7 +237,8 @@ void CalendarView::setDateRange(const QDate &start, int days)
     }
     m_startDate = start;
     m_dayCount = days;
-    invalidateLayout();
+    // Buckets are kept per date; days that scrolled in are laid out on demand.
+    m_layoutDirty = true;
     recalculateDayWidth();
     viewport()->update();
     updateScrollBars();
@@ -254,16 +258,51 @@ void CalendarView::setDayOffset(double offsetDays)
         return;
     }
     m_dayOffset = normalized;
-    invalidateLayout();
+    m_layoutDirty = true;
     viewport()->update();
     refreshActiveDragPreview();
 }
 
-void CalendarView::setEvents(std::vector<data::CalendarEvent> events)
+void CalendarView::setEvents(data::EventSnapshot events)
 {
+    const data::EventSnapshot previous = std::move(m_events);
     m_events = std::move(events);
+    m_eventFilterResults.clear();
     m_allowNewEventCreation = true;
-    invalidateLayout();
+    m_layoutDirty = true;
+    if (!m_dayLayouts.isEmpty()) {
+        // Unchanged events keep their handle, so only the days of replaced, added or removed
+        // events need a new layout, and those where unchanged events swapped their order.
+        const auto &previousHandles = previous.handles();
+        QHash<QUuid, int> previousIndex;
+        previousIndex.reserve(static_cast<int>(previousHandles.size()));
+        for (std::size_t idx = 0; idx < previousHandles.size(); ++idx) {
+            previousIndex.insert(previousHandles[idx]->id, static_cast<int>(idx));
+        }
+        std::vector<bool> kept(previousHandles.size(), false);
+        int lastKeptIndex = -1;
+        for (const data::EventHandle &handle : m_events.handles()) {
+            const auto it = previousIndex.constFind(handle->id);
+            if (it == previousIndex.constEnd()) {
+                invalidateLayoutDays(*handle);
+                continue;
+            }
+            const data::EventHandle &before = previousHandles[static_cast<std::size_t>(it.value())];
+            kept[static_cast<std::size_t>(it.value())] = true;
+            if (before != handle) {
+                invalidateLayoutDays(*before);
+                invalidateLayoutDays(*handle);
+            } else if (it.value() < lastKeptIndex) {
+                invalidateLayoutDays(*handle);
+            }
+            lastKeptIndex = qMax(lastKeptIndex, it.value());
+        }
+        for (std::size_t idx = 0; idx < previousHandles.size(); ++idx) {
+            if (!kept[idx]) {
+                invalidateLayoutDays(*previousHandles[idx]);
+            }
+        }
+    }
     if (!m_selectedEvent.isNull()) {
         auto it = std::find_if(m_events.begin(), m_events.end(), [this](const data::CalendarEvent &ev) {
             return ev.id == m_selectedEvent;
@@ -304,13 +343,11 @@ void CalendarView::setVerticalScrollValue(int value)
     }
 }
 
-void CalendarView::setEventSearchFilter(const QString &text)
+void CalendarView::setEventSearchFilter(const QString &text, data::EventMatches matches)
 {
-    QString normalized = text.trimmed();
-    if (m_eventSearchFilter == normalized) {
-        return;
-    }
-    m_eventSearchFilter = normalized;
+    m_eventSearchFilter = text.trimmed();
+    m_eventSearchMatches = std::move(matches);
+    m_eventFilterResults.clear();
     viewport()->update();
 }
 
@@ -333,21 +370,17 @@ bool CalendarView::eventMatchesFilter(const data::CalendarEvent &event) const
     if (m_eventSearchFilter.isEmpty()) {
         return true;
     }
-    const Qt::CaseSensitivity cs = Qt::CaseInsensitive;
-    if (event.title.contains(m_eventSearchFilter, cs)) {
-        return true;
-    }
-    if (event.description.contains(m_eventSearchFilter, cs)) {
-        return true;
-    }
-    if (event.location.contains(m_eventSearchFilter, cs)) {
-        return true;
+    const auto cached = m_eventFilterResults.constFind(event.id);
+    if (cached != m_eventFilterResults.constEnd()) {
+        return cached.value();
     }
-    const QString timeString = QLocale().toString(event.start, QLocale::ShortFormat);
-    if (timeString.contains(m_eventSearchFilter, cs)) {
-        return true;
+    bool matches = m_eventSearchMatches.contains(event);
+    if (!matches) {
+        const QString timeString = QLocale().toString(event.start, QLocale::ShortFormat);
+        matches = timeString.contains(m_eventSearchFilter, Qt::CaseInsensitive);
     }
-    return false;
+    m_eventFilterResults.insert(event.id, matches);
+    return matches;
 }
 
 bool CalendarView::showMonthBand() const
@@ -564,8 +597,9 @@ void CalendarView::paintEvent(QPaintEvent *event)
         return path;
     };
 
-    auto paintSingleEvent = [&](const data::CalendarEvent &eventData) {
-        const auto segments = segmentsForEvent(eventData);
+    auto paintSingleEvent = [&](std::size_t slot) {
+        const data::CalendarEvent &eventData = m_events[slot];
+        const auto segments = segmentsForSlot(slot);
         if (segments.empty()) {
             return;
         }
@@ -624,7 +658,7 @@ void CalendarView::paintEvent(QPaintEvent *event)
         });
 
         for (const auto &segment : segments) {
-            QRectF baseRect = adjustedRectForSegment(eventData, segment);
+            QRectF baseRect = adjustedRectForSegment(slot, segment);
             QRectF rect = baseRect.translated(0, -yOffset);
             if (!rect.intersects(visibleRect)) {
                 continue;
@@ -660,7 +694,7 @@ void CalendarView::paintEvent(QPaintEvent *event)
             } else if (hasAdjacentFollower) {
                 showEndLabel = false;
             } else {
-                endLabel = segment.segmentEnd.time().toString(QStringLiteral("hh:mm"));
+                endLabel = eventData.end.time().toString(QStringLiteral("hh:mm"));
             }
             if (showEndLabel) {
                 painter.drawText(QRectF(rect.left() + 4,
@@ -674,7 +708,7 @@ void CalendarView::paintEvent(QPaintEvent *event)
 
         painter.setPen(Qt::NoPen);
         if (eventData.id == m_hoverTopHandleId) {
-            QRectF translatedTop = adjustedRectForSegment(eventData, segments.front()).translated(0, -yOffset);
+            QRectF translatedTop = adjustedRectForSegment(slot, segments.front()).translated(0, -yOffset);
             if (translatedTop.intersects(visibleRect)) {
                 QRectF topHandle(translatedTop.x() + 6, translatedTop.y() - handleHeight / 2, translatedTop.width() - 12, handleHeight);
                 painter.setBrush(handleColor);
@@ -686,7 +720,7 @@ void CalendarView::paintEvent(QPaintEvent *event)
             }
         }
         if (eventData.id == m_hoverBottomHandleId) {
-            QRectF translatedBottom = adjustedRectForSegment(eventData, segments.back()).translated(0, -yOffset);
+            QRectF translatedBottom = adjustedRectForSegment(slot, segments.back()).translated(0, -yOffset);
             if (translatedBottom.intersects(visibleRect)) {
                 QRectF bottomHandle(translatedBottom.x() + 6, translatedBottom.bottom() - handleHeight / 2, translatedBottom.width() - 12, handleHeight);
                 painter.setBrush(handleColor);
@@ -718,37 +752,39 @@ void CalendarView::paintEvent(QPaintEvent *event)
         painter.drawLine(QPointF(xStart, y), QPointF(xStart + m_dayWidth, y));
     };
 
-    std::vector<const data::CalendarEvent *> baseEvents;
-    std::vector<const data::CalendarEvent *> overlayEvents;
-    const data::CalendarEvent *frontEvent = nullptr;
+    std::vector<std::size_t> baseEvents;
+    std::vector<std::size_t> overlayEvents;
+    std::optional<std::size_t> frontEvent;
     const QUuid frontId = !m_selectedEvent.isNull() ? m_selectedEvent : m_hoveredEventId;
-    for (const auto &event : m_events) {
-        if (!frontId.isNull() && event.id == frontId) {
-            frontEvent = &event;
+    for (std::size_t slot = 0; slot < m_events.size(); ++slot) {
+        if (!frontId.isNull() && m_events[slot].id == frontId) {
+            frontEvent = slot;
             continue;
         }
-        if (eventHasOverlay(event)) {
-            overlayEvents.push_back(&event);
+        if (eventHasOverlay(slot)) {
+            overlayEvents.push_back(slot);
         } else {
-            baseEvents.push_back(&event);
+            baseEvents.push_back(slot);
         }
     }
-    auto sortEvents = [](std::vector<const data::CalendarEvent *> &events) {
-        std::sort(events.begin(), events.end(), [](const data::CalendarEvent *lhs, const data::CalendarEvent *rhs) {
-            if (lhs->start == rhs->start) {
-                return lhs->end < rhs->end;
+    auto sortEvents = [this](std::vector<std::size_t> &order) {
+        std::sort(order.begin(), order.end(), [this](std::size_t lhsSlot, std::size_t rhsSlot) {
+            const data::CalendarEvent &lhs = m_events[lhsSlot];
+            const data::CalendarEvent &rhs = m_events[rhsSlot];
+            if (lhs.start == rhs.start) {
+                return lhs.end < rhs.end;
             }
-            return lhs->start < rhs->start;
+            return lhs.start < rhs.start;
         });
     };
     sortEvents(baseEvents);
     sortEvents(overlayEvents);
 
-    for (const auto *event : baseEvents) {
-        paintSingleEvent(*event);
+    for (const std::size_t slot : baseEvents) {
+        paintSingleEvent(slot);
     }
-    for (const auto *event : overlayEvents) {
-        paintSingleEvent(*event);
+    for (const std::size_t slot : overlayEvents) {
+        paintSingleEvent(slot);
     }
     if (frontEvent) {
         paintSingleEvent(*frontEvent);
@@ -767,6 +803,7 @@ void CalendarView::paintEvent(QPaintEvent *event)
             QPainterPath path = segmentPath(rect, segment.clipTop, segment.clipBottom);
             painter.drawPath(path);
             if (!labelDrawn) {
+                const QTime labelTime = segment.clipTop ? QTime(0, 0) : m_dropPreviewEvent.start.time();
                 QFont original = painter.font();
                 painter.setPen(Qt::white);
                 QTextOption titleOpt(Qt::AlignLeft | Qt::AlignTop);
@@ -785,13 +822,14 @@ void CalendarView::paintEvent(QPaintEvent *event)
                                         rect.width() - 8,
                                         rect.height() * 0.25),
                                  Qt::AlignLeft | Qt::AlignTop,
-                                 segment.segmentStart.time().toString(QStringLiteral("hh:mm")));
+                                 labelTime.toString(QStringLiteral("hh:mm")));
 
                 QFont dateFont = original;
                 dateFont.setBold(true);
                 dateFont.setPointSizeF(dateFont.pointSizeF() * 1.3);
                 painter.setFont(dateFont);
-                const QString dayText = QLocale().toString(segment.segmentStart.date(), QStringLiteral("dddd d."));
+                const QDate labelDate = m_startDate.addDays(segment.dayIndex);
+                const QString dayText = QLocale().toString(labelDate, QStringLiteral("dddd d."));
                 painter.drawText(QRectF(rect.left() + 4,
                                         rect.top() + rect.height() * 0.5,
                                         rect.width() - 8,
@@ -900,57 +938,28 @@ void CalendarView::mousePressEvent(QMouseEvent *event)
         m_pressPos = event->pos();
         resetDragCandidate();
         cancelNewEventDrag();
-        const auto orderedEvents = eventsInHitOrder();
-        for (const auto *evPtr : orderedEvents) {
-            const auto &ev = *evPtr;
-            const auto segments = segmentsForEvent(ev);
-            if (segments.empty()) {
-                continue;
-            }
-            const QRectF topRect = adjustedRectForSegment(ev, segments.front());
-            const bool overTopHandle = scenePos.x() >= topRect.left()
-                && scenePos.x() <= topRect.right()
-                && m_hoverTopHandleId == ev.id;
-            if (overTopHandle) {
-                auto topArea = handleArea(ev, true);
-                if (scenePos.y() >= topArea.first && scenePos.y() <= topArea.second) {
-                    beginResize(ev, true);
-                    m_pendingResizeEvent = ev.id;
-                    m_resizeAdjustStart = true;
-                    m_newEventDragPending = false;
-                    m_newEventAnchorTime = QDateTime();
-                    event->accept();
-                    return;
-                }
+        const auto hit = hitTest(scenePos, [this](std::size_t slot, EventHitPart part) {
+            switch (part) {
+            case EventHitPart::TopHandle:
+                return m_hoverTopHandleId == m_events[slot].id;
+            case EventHitPart::BottomHandle:
+                return m_hoverBottomHandleId == m_events[slot].id;
+            case EventHitPart::Body:
+                break;
             }
-
-            const QRectF bottomRect = adjustedRectForSegment(ev, segments.back());
-            const bool overBottomHandle = scenePos.x() >= bottomRect.left()
-                && scenePos.x() <= bottomRect.right()
-                && m_hoverBottomHandleId == ev.id;
-            if (overBottomHandle) {
-                auto bottomArea = handleArea(ev, false);
-                if (scenePos.y() >= bottomArea.first && scenePos.y() <= bottomArea.second) {
-                    beginResize(ev, false);
-                    m_pendingResizeEvent = ev.id;
-                    m_resizeAdjustStart = false;
-                    m_newEventDragPending = false;
-                    m_newEventAnchorTime = QDateTime();
-                    event->accept();
-                    return;
-                }
-            }
-
-            bool contains = false;
-            for (const auto &segment : segments) {
-                QRectF adjusted = adjustedRectForSegment(ev, segment);
-                if (adjusted.contains(scenePos)) {
-                    contains = true;
-                    break;
-                }
-            }
-            if (!contains) {
-                continue;
+            return true;
+        });
+        if (hit) {
+            const auto &ev = m_events[hit->slot];
+            if (hit->part != EventHitPart::Body) {
+                const bool adjustStart = hit->part == EventHitPart::TopHandle;
+                beginResize(ev, adjustStart);
+                m_pendingResizeEvent = ev.id;
+                m_resizeAdjustStart = adjustStart;
+                m_newEventDragPending = false;
+                m_newEventAnchorTime = QDateTime();
+                event->accept();
+                return;
             }
             m_dragCandidateId = ev.id;
             int rawOffset = 0;
@@ -1356,230 +1365,306 @@ void CalendarView::clearGhostPreview()
     clearDropPreview();
 }
 
-std::vector<CalendarView::EventSegment> CalendarView::segmentsForEvent(const data::CalendarEvent &event) const
+std::vector<CalendarView::SegmentSpan> CalendarView::segmentSpansFor(const data::CalendarEvent &event) const
 {
-    std::vector<EventSegment> segments;
-    if (!event.start.isValid() || !event.end.isValid() || event.start >= event.end || m_dayWidth <= 0.0) {
-        return segments;
+    std::vector<SegmentSpan> spans;
+    if (!event.start.isValid() || !event.end.isValid() || event.start >= event.end) {
+        return spans;
     }
+    // Only the days around the event's dates can hold a segment.
     const int slotCount = daySlotCount();
-    for (int day = 0; day < slotCount; ++day) {
+    const int firstDay = qMax(0, static_cast<int>(m_startDate.daysTo(event.start.date())) - 1);
+    const int lastDay = qMin(slotCount - 1, static_cast<int>(m_startDate.daysTo(event.end.date())) + 1);
+    for (int day = firstDay; day <= lastDay; ++day) {
         const QDate date = m_startDate.addDays(day);
         const QDateTime dayStart(date, QTime(0, 0));
         const QDateTime dayEnd = dayStart.addDays(1);
         if (event.end <= dayStart || event.start >= dayEnd) {
             continue;
         }
-        QDateTime segmentStart = event.start > dayStart ? event.start : dayStart;
-        QDateTime segmentEnd = event.end < dayEnd ? event.end : dayEnd;
-        const double startMinutes = dayStart.secsTo(segmentStart) / 60.0;
-        const double endMinutes = dayStart.secsTo(segmentEnd) / 60.0;
-        const double y = totalHeaderHeight() + (startMinutes / 60.0) * m_hourHeight;
-        const double durationMinutes = qMax(0.0, endMinutes - startMinutes);
-        const double height = qMax((durationMinutes / 60.0) * m_hourHeight, 20.0);
-        const double x = dayColumnLeft(day) + 6.0;
-        const double width = qMax(0.0, m_dayWidth - 12.0);
-
-        EventSegment segment;
-        segment.rect = QRectF(x, y, width, height);
-        segment.segmentStart = segmentStart;
-        segment.segmentEnd = segmentEnd;
-        segment.clipTop = segmentStart > event.start;
-        segment.clipBottom = segmentEnd < event.end;
-        segment.dayIndex = day;
-        segments.push_back(segment);
+        const QDateTime segmentStart = event.start > dayStart ? event.start : dayStart;
+        const QDateTime segmentEnd = event.end < dayEnd ? event.end : dayEnd;
+
+        SegmentSpan span;
+        span.dayIndex = day;
+        span.startMinutes = static_cast<int>(dayStart.secsTo(segmentStart) / 60);
+        span.endMinutes = static_cast<int>(dayStart.secsTo(segmentEnd) / 60);
+        span.clipTop = segmentStart > event.start;
+        span.clipBottom = segmentEnd < event.end;
+        const QTime startTime = segmentStart.time();
+        const QTime endTime = segmentEnd.time();
+        span.layoutSpan.startMinutes =
+            startTime.hour() * 60.0 + startTime.minute() + startTime.second() / 60.0;
+        span.layoutSpan.endMinutes = endTime.hour() * 60.0 + endTime.minute() + endTime.second() / 60.0;
+        if (segmentEnd.date() > segmentStart.date() && endTime == QTime(0, 0)) {
+            span.layoutSpan.endMinutes = 24.0 * 60.0;
+        }
+        spans.push_back(span);
+    }
+    return spans;
+}
+
+CalendarView::EventSegment CalendarView::segmentFromSpan(const SegmentSpan &span) const
+{
+    const double y = totalHeaderHeight() + (span.startMinutes / 60.0) * m_hourHeight;
+    const int durationMinutes = qMax(0, span.endMinutes - span.startMinutes);
+    const double height = qMax((durationMinutes / 60.0) * m_hourHeight, 20.0);
+    const double x = dayColumnLeft(span.dayIndex) + 6.0;
+    const double width = qMax(0.0, m_dayWidth - 12.0);
+
+    EventSegment segment;
+    segment.rect = QRectF(x, y, width, height);
+    segment.clipTop = span.clipTop;
+    segment.clipBottom = span.clipBottom;
+    segment.dayIndex = span.dayIndex;
+    return segment;
+}
+
+std::vector<CalendarView::EventSegment> CalendarView::segmentsForEvent(const data::CalendarEvent &event) const
+{
+    std::vector<EventSegment> segments;
+    if (m_dayWidth <= 0.0) {
+        return segments;
+    }
+    for (const SegmentSpan &span : segmentSpansFor(event)) {
+        segments.push_back(segmentFromSpan(span));
     }
     return segments;
 }
 
+std::vector<CalendarView::EventSegment> CalendarView::segmentsForSlot(std::size_t slot) const
+{
+    std::vector<EventSegment> segments;
+    ensureSegmentSpans();
+    if (m_dayWidth <= 0.0 || slot + 1 >= m_spanOffsets.size()) {
+        return segments;
+    }
+    segments.reserve(m_spanOffsets[slot + 1] - m_spanOffsets[slot]);
+    for (std::size_t idx = m_spanOffsets[slot]; idx < m_spanOffsets[slot + 1]; ++idx) {
+        segments.push_back(segmentFromSpan(m_segmentSpans[idx]));
+    }
+    return segments;
+}
+
+void CalendarView::ensureSegmentSpans() const
+{
+    const int slotCount = daySlotCount();
+    const bool sameRange = m_spanStartDate == m_startDate && m_spanDayCount == slotCount;
+    if (sameRange && &m_spanSource.handles() == &m_events.handles()) {
+        return;
+    }
+    // Unchanged events keep their handle, and with it their spans as long as the range stays.
+    QHash<const data::CalendarEvent *, std::size_t> previousSlots;
+    if (sameRange) {
+        const auto &previousHandles = m_spanSource.handles();
+        previousSlots.reserve(static_cast<int>(previousHandles.size()));
+        for (std::size_t slot = 0; slot < previousHandles.size(); ++slot) {
+            previousSlots.insert(previousHandles[slot].get(), slot);
+        }
+    }
+    std::vector<SegmentSpan> spans;
+    std::vector<std::size_t> offsets;
+    spans.reserve(m_events.size());
+    offsets.reserve(m_events.size() + 1);
+    offsets.push_back(0);
+    for (const data::EventHandle &handle : m_events.handles()) {
+        const auto previous = previousSlots.constFind(handle.get());
+        if (previous != previousSlots.constEnd()) {
+            const auto first = m_segmentSpans.begin();
+            spans.insert(spans.end(),
+                         first + static_cast<std::ptrdiff_t>(m_spanOffsets[previous.value()]),
+                         first + static_cast<std::ptrdiff_t>(m_spanOffsets[previous.value() + 1]));
+        } else {
+            const std::vector<SegmentSpan> eventSpans = segmentSpansFor(*handle);
+            spans.insert(spans.end(), eventSpans.begin(), eventSpans.end());
+        }
+        offsets.push_back(spans.size());
+    }
+    m_segmentSpans = std::move(spans);
+    m_spanOffsets = std::move(offsets);
+    m_spanSource = m_events;
+    m_spanStartDate = m_startDate;
+    m_spanDayCount = slotCount;
+}
+
 void CalendarView::invalidateLayout()
 {
+    for (auto &bucket : m_dayLayouts) {
+        bucket.dirty = true;
+    }
     m_layoutDirty = true;
 }
 
+void CalendarView::invalidateLayoutDays(const data::CalendarEvent &event)
+{
+    m_layoutDirty = true;
+    if (m_dayLayouts.isEmpty() || !event.start.isValid() || !event.end.isValid()) {
+        return;
+    }
+    const QDate first = event.start.date();
+    const QDate last = event.end.date();
+    // Long events visit the buckets instead of their dates.
+    if (first.daysTo(last) >= m_dayLayouts.size()) {
+        for (auto it = m_dayLayouts.begin(); it != m_dayLayouts.end(); ++it) {
+            if (it.key() >= first && it.key() <= last) {
+                it.value().dirty = true;
+            }
+        }
+        return;
+    }
+    for (QDate date = first; date <= last; date = date.addDays(1)) {
+        const auto it = m_dayLayouts.find(date);
+        if (it != m_dayLayouts.end()) {
+            it.value().dirty = true;
+        }
+    }
+}
+
 void CalendarView::ensureLayoutCache() const
 {
     if (!m_layoutDirty) {
         return;
     }
-    m_layoutCache.clear();
+    m_hitIndexDirty = true;
+    m_layoutRecords.assign(m_events.size(), EventLayoutRecord());
+    m_slotById.clear();
+    m_slotById.reserve(static_cast<int>(m_events.size()));
+    for (std::size_t slot = 0; slot < m_events.size(); ++slot) {
+        m_slotById.insert(m_events[slot].id, slot);
+    }
     const int slotCount = daySlotCount();
-    if (slotCount <= 0) {
+    if (slotCount <= 0 || m_dayWidth <= 0.0) {
         m_layoutDirty = false;
         return;
     }
 
-    struct DayEntry
-    {
-        const data::CalendarEvent *event = nullptr;
-        int dayIndex = -1;
-        double startMinutes = 0.0;
-        double endMinutes = 0.0;
-        double width = 1.0;
-        double offset = 0.0;
-        LayoutInfo::Anchor anchor = LayoutInfo::Anchor::Left;
-        bool fromSplit = false;
-        bool isContained = false;
-    };
-
-    std::vector<std::vector<DayEntry>> perDay(static_cast<std::size_t>(slotCount));
-    for (const auto &event : m_events) {
-        const auto segments = segmentsForEvent(event);
-        for (const auto &segment : segments) {
-            if (segment.dayIndex < 0 || segment.dayIndex >= slotCount) {
-                continue;
-            }
-            DayEntry entry;
-            entry.event = &event;
-            entry.dayIndex = segment.dayIndex;
-            const QTime startTime = segment.segmentStart.time();
-            const QTime endTime = segment.segmentEnd.time();
-            entry.startMinutes = startTime.hour() * 60.0 + startTime.minute() + startTime.second() / 60.0;
-            entry.endMinutes = endTime.hour() * 60.0 + endTime.minute() + endTime.second() / 60.0;
-            if (segment.segmentEnd.date() > segment.segmentStart.date()
-                && segment.segmentEnd.time() == QTime(0, 0)) {
-                entry.endMinutes = 24.0 * 60.0;
-            }
-            perDay[static_cast<std::size_t>(segment.dayIndex)].push_back(entry);
+    // Keep the buckets of days near the visible ones for scrolling back.
+    const QDate firstKept = m_startDate.addDays(-LayoutCacheMarginDays);
+    const QDate lastKept = m_startDate.addDays(slotCount - 1 + LayoutCacheMarginDays);
+    for (auto it = m_dayLayouts.begin(); it != m_dayLayouts.end();) {
+        if (it.key() < firstKept || it.key() > lastKept) {
+            it = m_dayLayouts.erase(it);
+        } else {
+            ++it;
         }
     }
 
-    constexpr double containWidth = 0.58;
-    constexpr double containerWidth = 0.88;
-    constexpr double overlapWidth = 0.72;
-    constexpr double epsilon = 0.01;
-
-    for (auto &entries : perDay) {
-        if (entries.empty()) {
-            continue;
-        }
-        std::map<std::pair<int, int>, std::vector<int>> identical;
-        for (int idx = 0; idx < entries.size(); ++idx) {
-            const int startKey = qRound(entries[idx].startMinutes * 10.0);
-            const int endKey = qRound(entries[idx].endMinutes * 10.0);
-            identical[{ startKey, endKey }].push_back(idx);
+    for (int day = 0; day < slotCount; ++day) {
+        const QDate date = m_startDate.addDays(day);
+        if (!m_dayLayouts.contains(date)) {
+            m_dayLayouts.insert(date, DayLayoutBucket());
         }
-        for (auto &[_, indices] : identical) {
-            if (indices.size() <= 1) {
+    }
+    // dirtyBefore[day] counts the visible days before day whose segments have to be gathered.
+    std::vector<DayLayoutBucket *> buckets(static_cast<std::size_t>(slotCount));
+    std::vector<int> dirtyBefore(static_cast<std::size_t>(slotCount) + 1, 0);
+    for (int day = 0; day < slotCount; ++day) {
+        DayLayoutBucket &bucket = m_dayLayouts[m_startDate.addDays(day)];
+        buckets[static_cast<std::size_t>(day)] = &bucket;
+        dirtyBefore[static_cast<std::size_t>(day) + 1] =
+            dirtyBefore[static_cast<std::size_t>(day)] + (bucket.dirty ? 1 : 0);
+    }
+
+    if (dirtyBefore.back() > 0) {
+        std::vector<std::vector<QUuid>> ids(static_cast<std::size_t>(slotCount));
+        std::vector<std::vector<DaySpan>> spans(static_cast<std::size_t>(slotCount));
+        ensureSegmentSpans();
+        for (std::size_t slot = 0; slot < m_events.size(); ++slot) {
+            const std::size_t firstSpan = m_spanOffsets[slot];
+            const std::size_t endSpan = m_spanOffsets[slot + 1];
+            if (firstSpan == endSpan) {
                 continue;
             }
-            const double width = qBound(0.25,
-                                        1.0 / static_cast<double>(indices.size()),
-                                        0.5);
-            for (int position = 0; position < indices.size(); ++position) {
-                auto &entry = entries[indices[position]];
-                entry.width = width;
-                entry.offset = width * position;
-                if (position == 0) {
-                    entry.anchor = LayoutInfo::Anchor::Left;
-                } else if (position == indices.size() - 1) {
-                    entry.anchor = LayoutInfo::Anchor::Right;
-                } else {
-                    entry.anchor = LayoutInfo::Anchor::Center;
+            // Spans are ordered by day.
+            const int firstDay = m_segmentSpans[firstSpan].dayIndex;
+            const int lastDay = m_segmentSpans[endSpan - 1].dayIndex;
+            if (dirtyBefore[static_cast<std::size_t>(lastDay) + 1]
+                == dirtyBefore[static_cast<std::size_t>(firstDay)]) {
+                continue;
+            }
+            for (std::size_t idx = firstSpan; idx < endSpan; ++idx) {
+                const SegmentSpan &span = m_segmentSpans[idx];
+                if (!buckets[static_cast<std::size_t>(span.dayIndex)]->dirty) {
+                    continue;
                 }
-                entry.fromSplit = true;
+                ids[static_cast<std::size_t>(span.dayIndex)].push_back(m_events[slot].id);
+                spans[static_cast<std::size_t>(span.dayIndex)].push_back(span.layoutSpan);
             }
         }
 
-        for (int i = 0; i < entries.size(); ++i) {
-            for (int j = i + 1; j < entries.size(); ++j) {
-                auto &first = entries[i];
-                auto &second = entries[j];
-                bool sameRange = qAbs(first.startMinutes - second.startMinutes) < epsilon
-                    && qAbs(first.endMinutes - second.endMinutes) < epsilon;
-                if (sameRange && first.fromSplit && second.fromSplit) {
-                    continue;
-                }
-                bool firstContainsSecond = first.startMinutes <= second.startMinutes + epsilon
-                    && first.endMinutes >= second.endMinutes - epsilon;
-                bool secondContainsFirst = second.startMinutes <= first.startMinutes + epsilon
-                    && second.endMinutes >= first.endMinutes - epsilon;
-
-                if (firstContainsSecond && !secondContainsFirst) {
-                    if (!first.fromSplit) {
-                        first.width = qMin(first.width, containerWidth);
-                        first.offset = 0.0;
-                        first.anchor = LayoutInfo::Anchor::Left;
-                    }
-                    second.width = qMin(second.width, containWidth);
-                    second.offset = 1.0 - second.width;
-                    second.anchor = LayoutInfo::Anchor::Right;
-                    second.isContained = true;
-                    continue;
-                }
-                if (secondContainsFirst && !firstContainsSecond) {
-                    if (!second.fromSplit) {
-                        second.width = qMin(second.width, containerWidth);
-                        second.offset = 0.0;
-                        second.anchor = LayoutInfo::Anchor::Left;
-                    }
-                    first.width = qMin(first.width, containWidth);
-                    first.offset = 1.0 - first.width;
-                    first.anchor = LayoutInfo::Anchor::Right;
-                    first.isContained = true;
-                    continue;
-                }
-                const double overlapStart = qMax(first.startMinutes, second.startMinutes);
-                const double overlapEnd = qMin(first.endMinutes, second.endMinutes);
-                if (overlapEnd - overlapStart > epsilon) {
-                    DayEntry *left = &first;
-                    DayEntry *right = &second;
-                    if (second.startMinutes < first.startMinutes
-                        || (qAbs(second.startMinutes - first.startMinutes) < epsilon
-                            && second.endMinutes < first.endMinutes)) {
-                        left = &second;
-                        right = &first;
-                    }
-                    if (!left->fromSplit && !left->isContained) {
-                        left->width = qMin(left->width, overlapWidth);
-                        left->offset = 0.0;
-                        left->anchor = LayoutInfo::Anchor::Left;
-                    }
-                    if (!right->fromSplit && !right->isContained) {
-                        right->width = qMin(right->width, overlapWidth);
-                        right->offset = 1.0 - right->width;
-                        right->anchor = LayoutInfo::Anchor::Right;
-                    }
-                }
+        for (int day = 0; day < slotCount; ++day) {
+            DayLayoutBucket &bucket = *buckets[static_cast<std::size_t>(day)];
+            if (!bucket.dirty) {
+                continue;
             }
+            bucket.dirty = false;
+            auto &dayIds = ids[static_cast<std::size_t>(day)];
+            auto &daySpans = spans[static_cast<std::size_t>(day)];
+            if (dayIds == bucket.ids && daySpans == bucket.spans) {
+                continue;
+            }
+            bucket.layouts = layoutDayColumn(daySpans);
+            bucket.ids = std::move(dayIds);
+            bucket.spans = std::move(daySpans);
         }
+    }
 
-        for (const auto &entry : entries) {
-            LayoutInfo info;
-            info.offsetFraction = entry.offset;
-            info.widthFraction = entry.width;
-            info.anchor = entry.anchor;
-            if (entry.isContained) {
-                info.zPriority = 1;
+    for (int day = 0; day < slotCount; ++day) {
+        const DayLayoutBucket &bucket = *buckets[static_cast<std::size_t>(day)];
+        for (std::size_t idx = 0; idx < bucket.ids.size(); ++idx) {
+            const auto slot = m_slotById.constFind(bucket.ids[idx]);
+            if (slot == m_slotById.constEnd()) {
+                continue;
+            }
+            const LayoutInfo &info = bucket.layouts[idx];
+            EventLayoutRecord &record = m_layoutRecords[slot.value()];
+            if (record.days.empty()) {
+                record.firstDay = day;
+            }
+            record.days.resize(static_cast<std::size_t>(day - record.firstDay) + 1);
+            record.days.back() = info;
+            if (!qFuzzyCompare(1.0 + info.widthFraction, 1.0 + 1.0) || info.offsetFraction > 0.0) {
+                record.hasOverlap = true;
+            }
+            if (info.zPriority > 0) {
+                record.hasOverlay = true;
             }
-            m_layoutCache[{ entry.event->id, entry.dayIndex }] = info;
         }
     }
 
     m_layoutDirty = false;
 }
 
-CalendarView::LayoutInfo CalendarView::layoutInfoFor(const QUuid &eventId, int dayIndex) const
+CalendarView::LayoutInfo CalendarView::layoutInfoFor(std::size_t slot, int dayIndex) const
 {
     ensureLayoutCache();
-    auto key = std::make_pair(eventId, dayIndex);
-    const auto it = m_layoutCache.find(key);
-    if (it != m_layoutCache.end()) {
-        return it->second;
+    if (slot >= m_layoutRecords.size()) {
+        return LayoutInfo();
     }
-    return LayoutInfo();
+    const EventLayoutRecord &record = m_layoutRecords[slot];
+    const int day = dayIndex - record.firstDay;
+    if (day < 0 || day >= static_cast<int>(record.days.size())) {
+        return LayoutInfo();
+    }
+    return record.days[static_cast<std::size_t>(day)];
+}
+
+QRectF CalendarView::adjustedRectForSegment(std::size_t slot, const EventSegment &segment) const
+{
+    const QUuid frontId = !m_hoveredEventId.isNull() ? m_hoveredEventId : m_selectedEvent;
+    const bool inFront = !frontId.isNull() && frontId == m_events[slot].id;
+    return layoutRect(slot, segment.dayIndex, segment.rect, inFront);
 }
 
-QRectF CalendarView::adjustedRectForSegment(const data::CalendarEvent &event, const EventSegment &segment) const
+QRectF CalendarView::layoutRect(std::size_t slot, int dayIndex, const QRectF &segmentRect, bool inFront) const
 {
-    LayoutInfo info = layoutInfoFor(event.id, segment.dayIndex);
-    QRectF rect = segment.rect;
+    LayoutInfo info = layoutInfoFor(slot, dayIndex);
+    QRectF rect = segmentRect;
     const double availableWidth = rect.width();
     double width = availableWidth * info.widthFraction;
     width = qBound(0.0, width, availableWidth);
     double x = rect.left() + info.offsetFraction * availableWidth;
-    const QUuid frontId = !m_hoveredEventId.isNull() ? m_hoveredEventId : m_selectedEvent;
-    if (!frontId.isNull() && frontId == event.id && eventHasOverlap(event)) {
+    if (inFront && eventHasOverlap(slot)) {
         double hoverWidth = availableWidth * 0.85;
         hoverWidth = qBound(0.0, hoverWidth, availableWidth);
         switch (info.anchor) {
@@ -1600,65 +1685,214 @@ QRectF CalendarView::adjustedRectForSegment(const data::CalendarEvent &event, co
     return rect;
 }
 
-bool CalendarView::eventHasOverlap(const data::CalendarEvent &event) const
+bool CalendarView::eventHasOverlap(std::size_t slot) const
 {
     ensureLayoutCache();
-    for (const auto &[key, info] : m_layoutCache) {
-        if (key.first == event.id) {
-            if (!qFuzzyCompare(1.0 + info.widthFraction, 1.0 + 1.0) || info.offsetFraction > 0.0) {
-                return true;
-            }
-        }
-    }
-    return false;
+    return slot < m_layoutRecords.size() && m_layoutRecords[slot].hasOverlap;
 }
 
-bool CalendarView::eventHasOverlay(const data::CalendarEvent &event) const
+bool CalendarView::eventHasOverlay(std::size_t slot) const
 {
     ensureLayoutCache();
-    for (const auto &[key, info] : m_layoutCache) {
-        if (key.first == event.id && info.zPriority > 0) {
-            return true;
+    return slot < m_layoutRecords.size() && m_layoutRecords[slot].hasOverlay;
+}
+
+void CalendarView::ensureHitIndex() const
+{
+    ensureLayoutCache();
+    const std::array<double, 5> geometry{ m_hourHeight, m_dayWidth, m_dayOffset, m_timeAxisWidth,
+                                          totalHeaderHeight() };
+    if (!m_hitIndexDirty && geometry == m_hitGeometry) {
+        return;
+    }
+    m_hitIndexDirty = false;
+    m_hitGeometry = geometry;
+    m_hitEntries.clear();
+    m_hitColumns.assign(static_cast<std::size_t>(qMax(0, daySlotCount())), HitColumn());
+
+    std::vector<std::size_t> order(m_events.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(), [this](std::size_t lhsSlot, std::size_t rhsSlot) {
+        const bool lhsOverlay = eventHasOverlay(lhsSlot);
+        if (lhsOverlay != eventHasOverlay(rhsSlot)) {
+            return lhsOverlay;
+        }
+        const data::CalendarEvent &lhs = m_events[lhsSlot];
+        const data::CalendarEvent &rhs = m_events[rhsSlot];
+        if (lhs.start == rhs.start) {
+            return lhs.end < rhs.end;
+        }
+        return lhs.start < rhs.start;
+    });
+    std::vector<std::vector<std::size_t>> columnEntries(m_hitColumns.size());
+    for (const std::size_t slot : order) {
+        const auto segments = segmentsForSlot(slot);
+        for (std::size_t idx = 0; idx < segments.size(); ++idx) {
+            const EventSegment &segment = segments[idx];
+            if (segment.dayIndex < 0 || segment.dayIndex >= static_cast<int>(m_hitColumns.size())) {
+                continue;
+            }
+            HitEntry entry;
+            entry.slot = slot;
+            entry.dayIndex = segment.dayIndex;
+            entry.segmentRect = segment.rect;
+            entry.rect = layoutRect(slot, segment.dayIndex, segment.rect, false);
+            entry.firstSegment = idx == 0;
+            entry.lastSegment = idx + 1 == segments.size();
+            columnEntries[static_cast<std::size_t>(segment.dayIndex)].push_back(m_hitEntries.size());
+            m_hitEntries.push_back(entry);
+        }
+    }
+
+    for (std::size_t day = 0; day < m_hitColumns.size(); ++day) {
+        const std::vector<std::size_t> &entries = columnEntries[day];
+        if (entries.empty()) {
+            continue;
+        }
+        std::vector<double> tops;
+        std::vector<double> bottoms;
+        for (const std::size_t index : entries) {
+            tops.push_back(m_hitEntries[index].segmentRect.top());
+            bottoms.push_back(m_hitEntries[index].segmentRect.bottom());
+        }
+        std::sort(tops.begin(), tops.end());
+        std::sort(bottoms.begin(), bottoms.end());
+
+        // A handle reaches HandleHoverRange past the edge, but not into the next segment above
+        // or below it. Segment rects of one column overlap horizontally unless they have no width.
+        std::vector<std::pair<double, double>> extents;
+        extents.reserve(entries.size());
+        for (const std::size_t index : entries) {
+            HitEntry &entry = m_hitEntries[index];
+            const bool hasWidth = entry.rect.width() > 0.0;
+            const double top = entry.rect.top();
+            const double bottom = entry.rect.bottom();
+            double extentTop = top;
+            double extentBottom = bottom;
+            if (entry.firstSegment) {
+                double minY = top - HandleHoverRange;
+                const auto above = std::upper_bound(bottoms.begin(), bottoms.end(), top);
+                if (hasWidth && above != bottoms.begin()) {
+                    minY = std::max(minY, *std::prev(above));
+                }
+                const double maxY = top + HandleHoverRange;
+                entry.topHandle = minY > maxY ? qMakePair(top, top) : qMakePair(minY, maxY);
+                extentTop = std::min(extentTop, entry.topHandle.first);
+                extentBottom = std::max(extentBottom, entry.topHandle.second);
+            }
+            if (entry.lastSegment) {
+                double maxY = bottom + HandleHoverRange;
+                const auto below = std::lower_bound(tops.begin(), tops.end(), bottom);
+                if (hasWidth && below != tops.end()) {
+                    maxY = std::min(maxY, *below);
+                }
+                const double minY = bottom - HandleHoverRange;
+                entry.bottomHandle = minY > maxY ? qMakePair(bottom, bottom) : qMakePair(minY, maxY);
+                extentTop = std::min(extentTop, entry.bottomHandle.first);
+                extentBottom = std::max(extentBottom, entry.bottomHandle.second);
+            }
+            extents.emplace_back(extentTop, extentBottom);
+        }
+
+        std::vector<std::size_t> byTop(entries.size());
+        std::iota(byTop.begin(), byTop.end(), std::size_t(0));
+        std::sort(byTop.begin(), byTop.end(), [&extents](std::size_t lhs, std::size_t rhs) {
+            return extents[lhs].first < extents[rhs].first;
+        });
+        HitColumn &column = m_hitColumns[day];
+        column.entries.reserve(entries.size());
+        column.tops.reserve(entries.size());
+        column.bottoms.reserve(entries.size());
+        column.maxBottoms.reserve(entries.size());
+        for (const std::size_t idx : byTop) {
+            column.entries.push_back(entries[idx]);
+            column.tops.push_back(extents[idx].first);
+            column.bottoms.push_back(extents[idx].second);
+            column.maxBottoms.push_back(column.maxBottoms.empty()
+                                            ? extents[idx].second
+                                            : std::max(column.maxBottoms.back(), extents[idx].second));
         }
     }
-    return false;
 }
 
-std::vector<const data::CalendarEvent *> CalendarView::eventsInHitOrder() const
+std::optional<CalendarView::EventHit> CalendarView::hitTest(const QPointF &scenePos,
+                                                            const EventHitFilter &accept) const
 {
-    std::vector<const data::CalendarEvent *> overlays;
-    std::vector<const data::CalendarEvent *> base;
-    overlays.reserve(m_events.size());
-    base.reserve(m_events.size());
+    ensureHitIndex();
+    const double dayPosition = mapToDayPosition(scenePos.x());
+    if (dayPosition < 0.0 || dayPosition >= static_cast<double>(m_hitColumns.size())) {
+        return std::nullopt;
+    }
+    const HitColumn &column = m_hitColumns[static_cast<std::size_t>(dayPosition)];
+    const double y = scenePos.y();
+    // Entries starting below y cannot contain it, and neither can any before the first one
+    // whose running maximum bottom reaches y.
+    const auto first = std::lower_bound(column.maxBottoms.begin(), column.maxBottoms.end(), y);
+    const auto last = std::upper_bound(column.tops.begin(), column.tops.end(), y);
+    std::vector<std::size_t> candidates;
+    for (auto idx = static_cast<std::size_t>(first - column.maxBottoms.begin());
+         idx < static_cast<std::size_t>(last - column.tops.begin()); ++idx) {
+        if (column.bottoms[idx] >= y) {
+            candidates.push_back(column.entries[idx]);
+        }
+    }
+    if (candidates.empty()) {
+        return std::nullopt;
+    }
+    // m_hitEntries is in hit order, so sorting the indexes restores it.
+    std::sort(candidates.begin(), candidates.end());
+
     const QUuid frontId = !m_hoveredEventId.isNull() ? m_hoveredEventId : m_selectedEvent;
-    const data::CalendarEvent *frontEvent = nullptr;
-    for (const auto &event : m_events) {
-        if (!frontId.isNull() && event.id == frontId) {
-            frontEvent = &event;
-            continue;
+    const auto front = frontId.isNull() ? m_slotById.constEnd() : m_slotById.constFind(frontId);
+    const bool hasFront = front != m_slotById.constEnd();
+    const auto hitEntry = [&](const HitEntry &entry, bool inFront) -> std::optional<EventHit> {
+        const QRectF rect = inFront ? layoutRect(entry.slot, entry.dayIndex, entry.segmentRect, true)
+                                    : entry.rect;
+        const bool overRect = scenePos.x() >= rect.left() && scenePos.x() <= rect.right();
+        if (overRect && entry.firstSegment && y >= entry.topHandle.first && y <= entry.topHandle.second
+            && accept(entry.slot, EventHitPart::TopHandle)) {
+            return EventHit{ entry.slot, EventHitPart::TopHandle };
+        }
+        if (overRect && entry.lastSegment && y >= entry.bottomHandle.first && y <= entry.bottomHandle.second
+            && accept(entry.slot, EventHitPart::BottomHandle)) {
+            return EventHit{ entry.slot, EventHitPart::BottomHandle };
+        }
+        if (rect.contains(scenePos) && accept(entry.slot, EventHitPart::Body)) {
+            return EventHit{ entry.slot, EventHitPart::Body };
         }
-        if (eventHasOverlay(event)) {
-            overlays.push_back(&event);
-        } else {
-            base.push_back(&event);
+        return std::nullopt;
+    };
+    if (hasFront) {
+        for (const std::size_t index : candidates) {
+            if (m_hitEntries[index].slot == front.value()) {
+                if (const auto hit = hitEntry(m_hitEntries[index], true)) {
+                    return hit;
+                }
+                break;
+            }
         }
     }
-    auto sortByTime = [](const data::CalendarEvent *lhs, const data::CalendarEvent *rhs) {
-        if (lhs->start == rhs->start) {
-            return lhs->end < rhs->end;
+    for (const std::size_t index : candidates) {
+        const HitEntry &entry = m_hitEntries[index];
+        if (hasFront && entry.slot == front.value()) {
+            continue;
+        }
+        if (const auto hit = hitEntry(entry, false)) {
+            return hit;
         }
-        return lhs->start < rhs->start;
-    };
-    std::sort(overlays.begin(), overlays.end(), sortByTime);
-    std::sort(base.begin(), base.end(), sortByTime);
-    std::vector<const data::CalendarEvent *> ordered;
-    ordered.reserve(overlays.size() + base.size() + 1);
-    if (frontEvent) {
-        ordered.push_back(frontEvent);
     }
-    ordered.insert(ordered.end(), overlays.begin(), overlays.end());
-    ordered.insert(ordered.end(), base.begin(), base.end());
-    return ordered;
+    return std::nullopt;
+}
+
+std::optional<std::size_t> CalendarView::eventSlotAt(const QPointF &scenePos) const
+{
+    const auto hit = hitTest(scenePos, [](std::size_t, EventHitPart part) {
+        return part == EventHitPart::Body;
+    });
+    if (!hit) {
+        return std::nullopt;
+    }
+    return hit->slot;
 }
 
 void CalendarView::updateScrollBars()
@@ -1676,21 +1910,14 @@ void CalendarView::updateScrollBars()
 
 void CalendarView::selectEventAt(const QPoint &pos)
 {
-    ensureLayoutCache();
     const QPointF scenePos = QPointF(pos) + QPointF(horizontalScrollBar()->value(), verticalScrollBar()->value());
-    const auto orderedEvents = eventsInHitOrder();
-    for (const auto *eventData : orderedEvents) {
-        const auto segments = segmentsForEvent(*eventData);
-        for (const auto &segment : segments) {
-            QRectF adjusted = adjustedRectForSegment(*eventData, segment);
-            if (adjusted.contains(scenePos)) {
-                m_selectedEvent = eventData->id;
-                viewport()->update();
-                emit eventActivated(*eventData);
-                emit eventSelected(*eventData);
-                return;
-            }
-        }
+    if (const auto slot = eventSlotAt(scenePos)) {
+        const data::CalendarEvent &eventData = m_events[*slot];
+        m_selectedEvent = eventData.id;
+        viewport()->update();
+        emit eventActivated(eventData);
+        emit eventSelected(eventData);
+        return;
     }
     m_selectedEvent = {};
     viewport()->update();
@@ -1718,38 +1945,16 @@ void CalendarView::emitHoverAt(const QPoint &pos)
         }
     }
 
-    QUuid newTop;
-    QUuid newBottom;
     const bool selectionActive = !m_selectedEvent.isNull();
-    const auto orderedEvents = eventsInHitOrder();
-    for (const auto *eventData : orderedEvents) {
-        const auto segments = segmentsForEvent(*eventData);
-        if (segments.empty()) {
-            continue;
-        }
-        if (selectionActive && eventData->id != m_selectedEvent) {
-            continue;
-        }
-        const QRectF topRect = adjustedRectForSegment(*eventData, segments.front());
-        if (scenePos.x() >= topRect.left() && scenePos.x() <= topRect.right()) {
-            auto topArea = handleArea(*eventData, true);
-            if (scenePos.y() >= topArea.first && scenePos.y() <= topArea.second) {
-                newTop = eventData->id;
-            }
-        }
-
-        const QRectF bottomRect = adjustedRectForSegment(*eventData, segments.back());
-        if (scenePos.x() >= bottomRect.left() && scenePos.x() <= bottomRect.right()) {
-            auto bottomArea = handleArea(*eventData, false);
-            if (scenePos.y() >= bottomArea.first && scenePos.y() <= bottomArea.second) {
-                newBottom = eventData->id;
-            }
-        }
-
-        if (!newTop.isNull() && !newBottom.isNull()) {
-            break;
-        }
-    }
+    // While an event is selected only its handles show up.
+    const auto handleAt = [&](EventHitPart wanted) {
+        const auto hit = hitTest(scenePos, [&](std::size_t slot, EventHitPart part) {
+            return part == wanted && (!selectionActive || m_events[slot].id == m_selectedEvent);
+        });
+        return hit ? m_events[hit->slot].id : QUuid();
+    };
+    const QUuid newTop = handleAt(EventHitPart::TopHandle);
+    const QUuid newBottom = handleAt(EventHitPart::BottomHandle);
 
     if (newTop != m_hoverTopHandleId || newBottom != m_hoverBottomHandleId) {
         m_hoverTopHandleId = newTop;
@@ -1814,6 +2019,7 @@ void CalendarView::updateResize(const QPointF &scenePos)
         return;
     }
     QDateTime snapped = snapDateTime(dateTimeOpt.value());
+    const data::CalendarEvent previous = m_dragEvent;
 
     if (m_dragMode == DragMode::ResizeStart) {
         const auto minEnd = m_dragEvent.end.addSecs(-SnapIntervalMinutes * 60);
@@ -1829,12 +2035,10 @@ void CalendarView::updateResize(const QPointF &scenePos)
         }
     }
 
-    for (auto &eventData : m_events) {
-        if (eventData.id == m_dragEvent.id) {
-            eventData = m_dragEvent;
-            break;
-        }
-    }
+    m_events = m_events.withReplaced(m_dragEvent);
+    m_eventFilterResults.remove(m_dragEvent.id);
+    invalidateLayoutDays(previous);
+    invalidateLayoutDays(m_dragEvent);
     viewport()->update();
 }
 
@@ -1874,16 +2078,8 @@ std::optional<QDateTime> CalendarView::dateTimeAtScene(const QPointF &scenePos)
 
 const data::CalendarEvent *CalendarView::eventAt(const QPointF &scenePos) const
 {
-    const_cast<CalendarView *>(this)->ensureLayoutCache();
-    const auto orderedEvents = eventsInHitOrder();
-    for (const auto *eventData : orderedEvents) {
-        const auto segments = segmentsForEvent(*eventData);
-        for (const auto &segment : segments) {
-            QRectF adjusted = const_cast<CalendarView *>(this)->adjustedRectForSegment(*eventData, segment);
-            if (adjusted.contains(scenePos)) {
-                return eventData;
-            }
-        }
+    if (const auto slot = eventSlotAt(scenePos)) {
+        return &m_events[*slot];
     }
     return nullptr;
 }
@@ -2120,52 +2316,6 @@ void CalendarView::clearDropPreview()
     viewport()->update();
 }
 
-QPair<double, double> CalendarView::handleArea(const data::CalendarEvent &event, bool top) const
-{
-    const_cast<CalendarView *>(this)->ensureLayoutCache();
-    const auto segments = segmentsForEvent(event);
-    if (segments.empty()) {
-        return { 0.0, 0.0 };
-    }
-    const QRectF rect = const_cast<CalendarView *>(this)->adjustedRectForSegment(event, top ? segments.front() : segments.back());
-    const double center = top ? rect.top() : rect.bottom();
-    double minY = center - HandleHoverRange;
-    double maxY = center + HandleHoverRange;
-
-    const auto overlapsHorizontally = [&](const QRectF &other) {
-        return !(other.right() <= rect.left() || other.left() >= rect.right());
-    };
-
-    for (const auto &other : m_events) {
-        if (other.id == event.id) {
-            continue;
-        }
-        const auto otherSegments = segmentsForEvent(other);
-        for (const auto &otherRect : otherSegments) {
-            if (!overlapsHorizontally(otherRect.rect)) {
-                continue;
-            }
-            if (top && otherRect.rect.bottom() <= rect.top()) {
-                minY = std::max(minY, otherRect.rect.bottom());
-            } else if (!top && otherRect.rect.top() >= rect.bottom()) {
-                maxY = std::min(maxY, otherRect.rect.top());
-            }
-        }
-    }
-
-    if (top) {
-        maxY = std::min(maxY, rect.top() + HandleHoverRange);
-    } else {
-        minY = std::max(minY, rect.bottom() - HandleHoverRange);
-    }
-
-    if (minY > maxY) {
-        minY = maxY = center;
-    }
-
-    return { minY, maxY };
-}
-
 void CalendarView::recalculateDayWidth()
 {
     const double availableWidth = qMax(0.0, static_cast<double>(viewport()->width()) - m_timeAxisWidth);
@@ -2173,7 +2323,8 @@ void CalendarView::recalculateDayWidth()
     const double newWidth = days > 0 ? availableWidth / static_cast<double>(days) : availableWidth;
     if (!qFuzzyCompare(1.0 + m_dayWidth, 1.0 + newWidth)) {
         m_dayWidth = newWidth;
-        invalidateLayout();
+        // Layouts only depend on times.
+        m_layoutDirty = true;
         viewport()->update();
     }
 }
@@ -0,0 +1,261 @@
+#include "calendar/ui/widgets/DayLayout.hpp"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace calendar {
+namespace ui {
+
+namespace {
+constexpr double ContainWidth = 0.58;
+constexpr double ContainerWidth = 0.88;
+constexpr double OverlapWidth = 0.72;
+
+// Running maximum per position with range queries; answers "latest span index among those
+// inserted so far within a range of coordinates".
+class MaxTree
+{
+public:
+    explicit MaxTree(int size)
+        : m_size(size)
+        , m_values(static_cast<std::size_t>(2 * size), -1)
+    {
+    }
+
+    void raise(int position, int value)
+    {
+        for (position += m_size; position > 0; position >>= 1) {
+            m_values[position] = std::max(m_values[position], value);
+        }
+    }
+
+    // Maximum over [from, to), -1 if nothing was inserted there.
+    int maximum(int from, int to) const
+    {
+        int result = -1;
+        for (from += m_size, to += m_size; from < to; from >>= 1, to >>= 1) {
+            if (from & 1) {
+                result = std::max(result, m_values[from++]);
+            }
+            if (to & 1) {
+                result = std::max(result, m_values[--to]);
+            }
+        }
+        return result;
+    }
+
+private:
+    int m_size = 0;
+    std::vector<int> m_values;
+};
+
+struct Span
+{
+    // Ranks of the start and end among all coordinates of the column.
+    int start = 0;
+    int end = 0;
+};
+
+// Calls visit(first, last) for every run of order whose spans are equal under key.
+template <typename Key, typename Visit>
+void forEachGroup(const std::vector<int> &order, Key key, Visit visit)
+{
+    for (std::size_t first = 0; first < order.size();) {
+        std::size_t last = first + 1;
+        while (last < order.size() && key(order[last]) == key(order[first])) {
+            ++last;
+        }
+        visit(first, last);
+        first = last;
+    }
+}
+} // namespace
+
+std::vector<EventLayout> layoutDayColumn(const std::vector<DaySpan> &spans)
+{
+    const int count = static_cast<int>(spans.size());
+    std::vector<EventLayout> result(spans.size());
+    if (count == 0) {
+        return result;
+    }
+
+    // Segments whose ranges agree within six seconds are split side by side.
+    std::vector<bool> fromSplit(spans.size(), false);
+    std::map<std::pair<int, int>, std::vector<int>> identical;
+    for (int idx = 0; idx < count; ++idx) {
+        const int startKey = qRound(spans[idx].startMinutes * 10.0);
+        const int endKey = qRound(spans[idx].endMinutes * 10.0);
+        identical[{ startKey, endKey }].push_back(idx);
+    }
+    for (const auto &[_, indices] : identical) {
+        if (indices.size() <= 1) {
+            continue;
+        }
+        const int groupSize = static_cast<int>(indices.size());
+        const double width = qBound(0.25, 1.0 / static_cast<double>(groupSize), 0.5);
+        for (int position = 0; position < groupSize; ++position) {
+            EventLayout &layout = result[indices[position]];
+            layout.widthFraction = width;
+            layout.offsetFraction = width * position;
+            if (position == 0) {
+                layout.anchor = EventLayout::Anchor::Left;
+            } else if (position == groupSize - 1) {
+                layout.anchor = EventLayout::Anchor::Right;
+            } else {
+                layout.anchor = EventLayout::Anchor::Center;
+            }
+            fromSplit[indices[position]] = true;
+        }
+    }
+
+    // On whole seconds, comparisons within a hundredth of a minute are exact comparisons.
+    std::vector<int> coordinates;
+    coordinates.reserve(spans.size() * 2);
+    for (const DaySpan &span : spans) {
+        coordinates.push_back(qRound(span.startMinutes * 60.0));
+        coordinates.push_back(qRound(span.endMinutes * 60.0));
+    }
+    std::vector<int> sortedCoordinates = coordinates;
+    std::sort(sortedCoordinates.begin(), sortedCoordinates.end());
+    sortedCoordinates.erase(std::unique(sortedCoordinates.begin(), sortedCoordinates.end()),
+                            sortedCoordinates.end());
+    const auto rankOf = [&sortedCoordinates](int coordinate) {
+        const auto it = std::lower_bound(sortedCoordinates.begin(), sortedCoordinates.end(), coordinate);
+        return static_cast<int>(it - sortedCoordinates.begin());
+    };
+    std::vector<Span> ranked(spans.size());
+    for (int idx = 0; idx < count; ++idx) {
+        ranked[idx].start = rankOf(coordinates[2 * idx]);
+        ranked[idx].end = rankOf(coordinates[2 * idx + 1]);
+    }
+    const int rankCount = static_cast<int>(sortedCoordinates.size());
+    const auto rangeOf = [&ranked](int idx) { return std::make_pair(ranked[idx].start, ranked[idx].end); };
+    const auto startOf = [&ranked](int idx) { return ranked[idx].start; };
+    const auto endOf = [&ranked](int idx) { return ranked[idx].end; };
+
+    std::vector<int> order(spans.size());
+    for (int idx = 0; idx < count; ++idx) {
+        order[idx] = idx;
+    }
+
+    // Latest segment strictly containing each one: swept by start, longer ones first.
+    std::vector<int> latestContainer(spans.size(), -1);
+    {
+        std::sort(order.begin(), order.end(), [&ranked](int lhs, int rhs) {
+            if (ranked[lhs].start != ranked[rhs].start) {
+                return ranked[lhs].start < ranked[rhs].start;
+            }
+            return ranked[lhs].end > ranked[rhs].end;
+        });
+        MaxTree ends(rankCount);
+        forEachGroup(order, rangeOf, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                latestContainer[order[i]] = ends.maximum(ranked[order[i]].end, rankCount);
+            }
+            for (std::size_t i = first; i < last; ++i) {
+                ends.raise(ranked[order[i]].end, order[i]);
+            }
+        });
+    }
+
+    // Latest segment strictly inside each one: swept by descending start, shorter ones first.
+    std::vector<int> latestContained(spans.size(), -1);
+    {
+        std::sort(order.begin(), order.end(), [&ranked](int lhs, int rhs) {
+            if (ranked[lhs].start != ranked[rhs].start) {
+                return ranked[lhs].start > ranked[rhs].start;
+            }
+            return ranked[lhs].end < ranked[rhs].end;
+        });
+        MaxTree ends(rankCount);
+        forEachGroup(order, rangeOf, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                latestContained[order[i]] = ends.maximum(0, ranked[order[i]].end + 1);
+            }
+            for (std::size_t i = first; i < last; ++i) {
+                ends.raise(ranked[order[i]].end, order[i]);
+            }
+        });
+    }
+
+    // Latest segment starting before and ending inside each one.
+    std::vector<int> latestFromLeft(spans.size(), -1);
+    {
+        std::sort(order.begin(), order.end(), [&ranked](int lhs, int rhs) {
+            return ranked[lhs].start < ranked[rhs].start;
+        });
+        MaxTree ends(rankCount);
+        forEachGroup(order, startOf, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                const Span &span = ranked[order[i]];
+                latestFromLeft[order[i]] = ends.maximum(span.start + 1, span.end);
+            }
+            for (std::size_t i = first; i < last; ++i) {
+                ends.raise(ranked[order[i]].end, order[i]);
+            }
+        });
+    }
+
+    // Latest segment starting inside and ending after each one.
+    std::vector<int> latestFromRight(spans.size(), -1);
+    {
+        std::sort(order.begin(), order.end(), [&ranked](int lhs, int rhs) {
+            return ranked[lhs].end > ranked[rhs].end;
+        });
+        MaxTree starts(rankCount);
+        forEachGroup(order, endOf, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                const Span &span = ranked[order[i]];
+                latestFromRight[order[i]] = starts.maximum(span.start + 1, span.end);
+            }
+            for (std::size_t i = first; i < last; ++i) {
+                starts.raise(ranked[order[i]].start, order[i]);
+            }
+        });
+    }
+
+    // Segments with the same range always share a split group and leave each other alone, so
+    // every other relation is one of the four above. The latest related segment decides the
+    // anchor; every relation narrows the width. Once a segment is known to be contained, only
+    // containment still moves it, which makes its latest container outrank any overlap.
+    for (int idx = 0; idx < count; ++idx) {
+        EventLayout &layout = result[idx];
+        int latest = -1;
+        bool right = false;
+        const auto consider = [&latest, &right](int other, bool toRight) {
+            if (other > latest) {
+                latest = other;
+                right = toRight;
+            }
+        };
+        if (latestContainer[idx] >= 0) {
+            layout.widthFraction = qMin(layout.widthFraction, ContainWidth);
+            layout.zPriority = 1;
+            consider(latestContainer[idx], true);
+            if (!fromSplit[idx]) {
+                consider(latestContained[idx], false);
+            }
+        } else if (!fromSplit[idx]) {
+            if (latestContained[idx] >= 0) {
+                layout.widthFraction = qMin(layout.widthFraction, ContainerWidth);
+            }
+            if (latestFromLeft[idx] >= 0 || latestFromRight[idx] >= 0) {
+                layout.widthFraction = qMin(layout.widthFraction, OverlapWidth);
+            }
+            consider(latestContained[idx], false);
+            consider(latestFromLeft[idx], true);
+            consider(latestFromRight[idx], false);
+        }
+        if (latest < 0) {
+            continue;
+        }
+        layout.offsetFraction = right ? 1.0 - layout.widthFraction : 0.0;
+        layout.anchor = right ? EventLayout::Anchor::Right : EventLayout::Anchor::Left;
+    }
+    return result;
+}
+
+} // namespace ui
+} // namespace calendar
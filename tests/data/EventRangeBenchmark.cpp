@@ -0,0 +1,199 @@
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+#include <algorithm>
+
+#include "calendar/data/EventIntervalIndex.hpp"
+#include "calendar/data/EventSnapshot.hpp"
+
+using namespace calendar::data;
+
+namespace {
+constexpr int BENCHMARK_EVENT_COUNT = 20000;
+constexpr int TITLE_COUNT = 60;
+constexpr int LOCATION_COUNT = 40;
+// Rough per-allocation header of QString, QList and QHash node data on 64-bit platforms.
+constexpr qint64 ARRAY_HEADER_BYTES = 24;
+
+qint64 stringBytes(const QString &text)
+{
+    return text.isEmpty() ? 0 : ARRAY_HEADER_BYTES + (text.size() + 1) * static_cast<qint64>(sizeof(QChar));
+}
+
+// Heap and inline size of one CalendarEvent as the parser creates it: every string has its own
+// allocation. QDateTime keeps local times inline on 64-bit platforms.
+qint64 eventBytes(const CalendarEvent &event)
+{
+    qint64 bytes = sizeof(CalendarEvent) + stringBytes(event.title) + stringBytes(event.description)
+                   + stringBytes(event.location) + stringBytes(event.recurrenceRule);
+    if (!event.categories.isEmpty()) {
+        bytes += ARRAY_HEADER_BYTES + event.categories.size() * static_cast<qint64>(sizeof(void *));
+        for (const QString &category : event.categories) {
+            bytes += stringBytes(category);
+        }
+    }
+    return bytes;
+}
+
+bool startsBefore(const CalendarEvent &lhs, const CalendarEvent &rhs)
+{
+    if (lhs.start != rhs.start) {
+        return lhs.start < rhs.start;
+    }
+    return lhs.end < rhs.end;
+}
+} // namespace
+
+// Compares the range path of the storages, an EventIntervalIndex over integer timestamps that
+// hands out shared event handles, with sorting and scanning copied CalendarEvent values.
+class EventRangeBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void rangeMatchesScan();
+    void memoryPerEvent();
+    void sortEvents();
+    void buildIndex();
+    void scanEvents();
+    void scanIndex();
+
+private:
+    void fillIndex(EventIntervalIndex &index) const;
+
+    std::vector<CalendarEvent> m_events;
+    std::vector<EventHandle> m_handles;
+    QHash<QUuid, EventHandle> m_handleById;
+    EventIntervalIndex m_index;
+    QDateTime m_scanFrom;
+    QDateTime m_scanTo;
+};
+
+void EventRangeBenchmark::initTestCase()
+{
+    QRandomGenerator random(4711);
+    const QDateTime base(QDate(2024, 1, 1), QTime(8, 0));
+    m_events.reserve(BENCHMARK_EVENT_COUNT);
+    for (int i = 0; i < BENCHMARK_EVENT_COUNT; ++i) {
+        CalendarEvent event;
+        event.id = QUuid::createUuid();
+        event.title = QStringLiteral("Besprechung %1").arg(random.bounded(TITLE_COUNT));
+        event.description = QStringLiteral("Agenda für Termin %1").arg(i);
+        event.location = QStringLiteral("Linz, Büro %1").arg(random.bounded(LOCATION_COUNT));
+        // fromLatin1 allocates every time, like the parser does.
+        event.categories = {QString::fromLatin1("Arbeit"), QString::fromLatin1("Team")};
+        event.start = base.addSecs(static_cast<qint64>(random.bounded(365 * 24 * 4)) * 15 * 60);
+        event.end = event.start.addSecs(static_cast<qint64>(1 + random.bounded(8)) * 15 * 60);
+        event.allDay = i % 50 == 0;
+        event.reminderMinutes = i % 3 == 0 ? 10 : 0;
+        m_events.push_back(event);
+        m_handles.push_back(std::make_shared<const CalendarEvent>(event));
+        m_handleById.insert(event.id, m_handles.back());
+    }
+    fillIndex(m_index);
+    m_scanFrom = QDateTime(QDate(2024, 6, 3), QTime(0, 0));
+    m_scanTo = QDateTime(QDate(2024, 6, 10), QTime(0, 0)).addMSecs(-1);
+}
+
+void EventRangeBenchmark::fillIndex(EventIntervalIndex &index) const
+{
+    for (const EventHandle &event : m_handles) {
+        index.insert(event->id, event->start.toMSecsSinceEpoch(), event->end.toMSecsSinceEpoch());
+    }
+}
+
+void EventRangeBenchmark::rangeMatchesScan()
+{
+    QRandomGenerator random(42);
+    const QDateTime base(QDate(2024, 1, 1), QTime(0, 0));
+    for (int query = 0; query < 50; ++query) {
+        const QDateTime from = base.addSecs(static_cast<qint64>(random.bounded(360 * 24)) * 3600);
+        const QDateTime to = from.addSecs(static_cast<qint64>(1 + random.bounded(14 * 24)) * 3600);
+
+        std::vector<CalendarEvent> expected;
+        for (const CalendarEvent &event : m_events) {
+            if (event.start <= to && event.end >= from) {
+                expected.push_back(event);
+            }
+        }
+        std::stable_sort(expected.begin(), expected.end(), startsBefore);
+
+        const auto ids = m_index.overlapping(from.toMSecsSinceEpoch(), to.toMSecsSinceEpoch());
+        QCOMPARE(ids.size(), expected.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const EventHandle event = m_handleById.value(ids[i]);
+            QVERIFY(event);
+            QCOMPARE(event->start, expected[i].start);
+            QCOMPARE(event->end, expected[i].end);
+        }
+    }
+}
+
+void EventRangeBenchmark::memoryPerEvent()
+{
+    // What a range result costs per event: a copy of the event, or a shared handle to it.
+    qint64 copiedBytes = 0;
+    for (const CalendarEvent &event : m_events) {
+        copiedBytes += eventBytes(event);
+    }
+    const qint64 handleBytes = BENCHMARK_EVENT_COUNT * static_cast<qint64>(sizeof(EventHandle));
+    // What the index keeps per event: a tree node plus its entry in the id table.
+    const qint64 indexBytes = 3 * sizeof(qint64) + sizeof(QUuid) + sizeof(quint32) + 2 * sizeof(int)
+                              + ARRAY_HEADER_BYTES + sizeof(QUuid) + sizeof(int);
+    qInfo("Bytes per event: CalendarEvent copy %lld, shared handle %lld, interval index %lld",
+          copiedBytes / BENCHMARK_EVENT_COUNT,
+          handleBytes / BENCHMARK_EVENT_COUNT,
+          indexBytes);
+    QVERIFY(handleBytes < copiedBytes);
+}
+
+void EventRangeBenchmark::sortEvents()
+{
+    // Includes the copy, as a sorted vector of fetched events is always a copy of the stored ones.
+    QBENCHMARK {
+        std::vector<CalendarEvent> events = m_events;
+        std::sort(events.begin(), events.end(), startsBefore);
+    }
+}
+
+void EventRangeBenchmark::buildIndex()
+{
+    // The index keeps the events ordered as they are inserted, so building it replaces sorting.
+    QBENCHMARK {
+        EventIntervalIndex index;
+        fillIndex(index);
+    }
+}
+
+void EventRangeBenchmark::scanEvents()
+{
+    int matches = 0;
+    QBENCHMARK {
+        matches = 0;
+        for (const CalendarEvent &event : m_events) {
+            if (event.start <= m_scanTo && event.end >= m_scanFrom) {
+                ++matches;
+            }
+        }
+    }
+    QVERIFY(matches > 0);
+}
+
+void EventRangeBenchmark::scanIndex()
+{
+    const qint64 from = m_scanFrom.toMSecsSinceEpoch();
+    const qint64 to = m_scanTo.toMSecsSinceEpoch();
+    size_t matches = 0;
+    QBENCHMARK {
+        std::vector<EventHandle> events;
+        for (const QUuid &id : m_index.overlapping(from, to)) {
+            events.push_back(m_handleById.value(id));
+        }
+        matches = EventSnapshot(std::move(events)).size();
+    }
+    QVERIFY(matches > 0);
+}
+
+QTEST_GUILESS_MAIN(EventRangeBenchmark)
+
+#include "EventRangeBenchmark.moc"
@@ -0,0 +1,587 @@
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+#include <algorithm>
+
+#include "calendar/data/CalendarCache.hpp"
+#include "calendar/data/FileCalendarStorage.hpp"
+#include "calendar/data/IcsWriter.hpp"
+
+using namespace calendar::data;
+
+class FileCalendarStorageTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void journalReplay();
+    void compactionFoldsJournal();
+    void batchDefersPersistence();
+    void rangeQueryMatchesScan();
+    void todoOrderMatchesSort();
+    void snapshotCache();
+    void cacheKeepsLoadedState();
+    void lazyMaterialization();
+    void monthlyShards();
+    void monthlyShardDuplicates();
+    void externalEditsAreMerged();
+};
+
+void FileCalendarStorageTest::journalReplay()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+
+    FileCalendarStorage storage(path);
+    CalendarEvent event;
+    event.title = QStringLiteral("Review");
+    event.start = QDateTime(QDate(2024, 3, 4), QTime(9, 0));
+    event.end = event.start.addSecs(3600);
+    const auto stored = storage.addOrUpdateEvent(event);
+
+    TodoItem todo;
+    todo.title = QStringLiteral("Write report");
+    const auto storedTodo = storage.addOrUpdateTodo(todo);
+    QVERIFY(storage.removeTodo(storedTodo.id));
+
+    storage.flush();
+    QVERIFY(QFile::exists(storage.journalPath()));
+
+    FileCalendarStorage replayed(path);
+    QCOMPARE(replayed.eventCount(), 1);
+    QCOMPARE(replayed.event(stored.id)->title, QStringLiteral("Review"));
+    QCOMPARE(replayed.event(stored.id)->start, stored.start);
+    QVERIFY(replayed.todos().isEmpty());
+}
+
+void FileCalendarStorageTest::compactionFoldsJournal()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+
+    QUuid id;
+    {
+        FileCalendarStorage storage(path);
+        TodoItem todo;
+        todo.title = QStringLiteral("Call back");
+        todo.priority = 2;
+        id = storage.addOrUpdateTodo(todo).id;
+        storage.compact();
+        storage.flush();
+        QVERIFY(QFile::exists(path));
+        QVERIFY(!QFile::exists(storage.journalPath()));
+
+        todo = storage.todos().value(id);
+        todo.status = TodoStatus::Completed;
+        storage.addOrUpdateTodo(todo);
+    }
+
+    QVERIFY(!QFile::exists(path + QStringLiteral(".journal")));
+    FileCalendarStorage reloaded(path);
+    QCOMPARE(reloaded.todos().size(), 1);
+    QCOMPARE(reloaded.todos().value(id).status, TodoStatus::Completed);
+    QCOMPARE(reloaded.todos().value(id).priority, 2);
+}
+
+void FileCalendarStorageTest::batchDefersPersistence()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+
+    FileCalendarStorage storage(path);
+    storage.beginBatch();
+    for (int i = 0; i < 3; ++i) {
+        TodoItem todo;
+        todo.title = QStringLiteral("Item %1").arg(i);
+        storage.addOrUpdateTodo(todo);
+    }
+    storage.flush();
+    QVERIFY(!QFile::exists(storage.journalPath()));
+    storage.commitBatch();
+    storage.flush();
+    QVERIFY(QFile::exists(storage.journalPath()));
+
+    FileCalendarStorage replayed(path);
+    QCOMPARE(replayed.todos().size(), 3);
+}
+
+void FileCalendarStorageTest::rangeQueryMatchesScan()
+{
+    FileCalendarStorage storage(QString{});
+    QRandomGenerator random(7);
+    const QDateTime origin(QDate(2024, 1, 1), QTime(0, 0));
+    QList<QUuid> ids;
+    for (int i = 0; i < 500; ++i) {
+        CalendarEvent event;
+        event.title = QStringLiteral("Event %1").arg(i);
+        event.start = origin.addSecs(random.bounded(60 * 24) * 15 * 60);
+        event.end = event.start.addSecs((1 + random.bounded(i % 10 == 0 ? 400 : 12)) * 15 * 60);
+        ids.append(storage.addOrUpdateEvent(event).id);
+    }
+    for (int i = 0; i < 100; ++i) {
+        storage.removeEvent(ids.at(random.bounded(ids.size())));
+    }
+
+    for (int day = -2; day < 64; day += 3) {
+        const QDate from = origin.date().addDays(day);
+        const QDate to = from.addDays(random.bounded(8));
+        std::vector<CalendarEvent> expected;
+        for (const auto &event : storage.allEvents()) {
+            if (event.end.date() < from || event.start.date() > to) {
+                continue;
+            }
+            expected.push_back(event);
+        }
+        std::sort(expected.begin(), expected.end(), [](const CalendarEvent &lhs, const CalendarEvent &rhs) {
+            if (lhs.start == rhs.start) {
+                return lhs.end < rhs.end;
+            }
+            return lhs.start < rhs.start;
+        });
+
+        const auto actual = storage.eventsInRange(from, to);
+        QCOMPARE(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            QCOMPARE(actual[i].start, expected[i].start);
+            QCOMPARE(actual[i].end, expected[i].end);
+        }
+    }
+}
+
+void FileCalendarStorageTest::todoOrderMatchesSort()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+    const QStringList titles{QStringLiteral("einkaufen"), QStringLiteral("Einkaufen"),
+                             QStringLiteral("Äpfel"), QStringLiteral("Zahnarzt"), QStringLiteral("abwasch")};
+
+    const auto verifyOrder = [](const FileCalendarStorage &storage) {
+        std::vector<TodoItem> expected;
+        for (const auto &todo : storage.todos()) {
+            expected.push_back(todo);
+        }
+        std::sort(expected.begin(), expected.end(), todoListedBefore);
+        const auto actual = storage.orderedTodos();
+        QCOMPARE(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            QCOMPARE(actual[i].priority, expected[i].priority);
+            QCOMPARE(actual[i].title.toLower(), expected[i].title.toLower());
+        }
+    };
+
+    {
+        FileCalendarStorage storage(path);
+        QRandomGenerator random(11);
+        QList<QUuid> ids;
+        for (int i = 0; i < 300; ++i) {
+            TodoItem todo;
+            todo.title = titles.at(random.bounded(titles.size())) + QString::number(random.bounded(20));
+            todo.priority = random.bounded(4);
+            ids.append(storage.addOrUpdateTodo(todo).id);
+        }
+        for (int i = 0; i < 200; ++i) {
+            const QUuid id = ids.at(random.bounded(ids.size()));
+            if (i % 4 == 0) {
+                storage.removeTodo(id);
+                continue;
+            }
+            if (!storage.todos().contains(id)) {
+                continue;
+            }
+            TodoItem todo = storage.todos().value(id);
+            todo.priority = random.bounded(4);
+            todo.title = titles.at(random.bounded(titles.size()));
+            storage.addOrUpdateTodo(todo);
+        }
+        verifyOrder(storage);
+        storage.flush();
+    }
+
+    FileCalendarStorage reloaded(path);
+    QVERIFY(!reloaded.todos().isEmpty());
+    verifyOrder(reloaded);
+}
+
+void FileCalendarStorageTest::snapshotCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+
+    CalendarEvent event;
+    event.title = QStringLiteral("Zahnarzt");
+    event.location = QStringLiteral("Linz");
+    event.categories = {QStringLiteral("Privat")};
+    event.start = QDateTime(QDate(2024, 5, 6), QTime(14, 30));
+    event.end = event.start.addSecs(45 * 60);
+    event.reminderMinutes = 15;
+    {
+        FileCalendarStorage storage(path);
+        event = storage.addOrUpdateEvent(event);
+    }
+    QVERIFY(QFile::exists(CalendarCache::cachePathFor(path)));
+
+    const auto cached = CalendarCache::read(path);
+    QVERIFY(cached.has_value());
+    QCOMPARE(cached->eventRefs.size(), 1);
+    QCOMPARE(cached->eventRefs.value(event.id).start, event.start);
+    QCOMPARE(cached->eventRefs.value(event.id).end, event.end);
+
+    FileCalendarStorage cachedStorage(path);
+    QCOMPARE(cachedStorage.materializedEventCount(), 0);
+    const auto restored = cachedStorage.event(event.id);
+    QVERIFY(restored.has_value());
+    QCOMPARE(restored->title, event.title);
+    QCOMPARE(restored->location, event.location);
+    QCOMPARE(restored->categories, event.categories);
+    QCOMPARE(restored->start, event.start);
+    QCOMPARE(restored->end, event.end);
+    QCOMPARE(restored->reminderMinutes, event.reminderMinutes);
+
+    // Changing the ICS file behind the storage's back invalidates the cache.
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("BEGIN:VTODO\r\nSUMMARY:Extern\r\nEND:VTODO\r\n");
+    file.close();
+    QVERIFY(!CalendarCache::read(path).has_value());
+
+    FileCalendarStorage reloaded(path);
+    QCOMPARE(reloaded.eventCount(), 1);
+    QCOMPARE(reloaded.todos().size(), 1);
+    reloaded.flush();
+    QVERIFY(CalendarCache::read(path).has_value());
+}
+
+void FileCalendarStorageTest::cacheKeepsLoadedState()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("BEGIN:VCALENDAR\r\nBEGIN:VTODO\r\nSUMMARY:Alt\r\nEND:VTODO\r\nEND:VCALENDAR\r\n");
+    }
+    QByteArray contents;
+    const IcsSourceState state = CalendarCache::readSource(path, &contents);
+    QVERIFY(state.isValid());
+    QCOMPARE(state.size, static_cast<qint64>(contents.size()));
+
+    // The file is replaced before the cache for the loaded bytes is written.
+    {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("BEGIN:VCALENDAR\r\nBEGIN:VTODO\r\nSUMMARY:Neuer Eintrag\r\nEND:VTODO\r\n"
+                   "END:VCALENDAR\r\n");
+    }
+    QVERIFY(CalendarCache::write(path, CalendarSnapshot{{}, {}, {}, contents, state}));
+    QVERIFY(!CalendarCache::read(path).has_value());
+    QVERIFY(CalendarCache::read(path, contents, state).has_value());
+
+    // Without the state of the bytes there is nothing to stamp the cache with.
+    QVERIFY(!CalendarCache::write(path, CalendarSnapshot{{}, {}, {}, contents, {}}));
+}
+
+void FileCalendarStorageTest::lazyMaterialization()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+    const QDateTime origin(QDate(2024, 1, 1), QTime(9, 0));
+
+    QList<QUuid> ids;
+    {
+        FileCalendarStorage storage(path);
+        storage.beginBatch();
+        for (int i = 0; i < 200; ++i) {
+            CalendarEvent event;
+            event.title = QStringLiteral("Termin %1").arg(i);
+            event.description = QStringLiteral("Zeile 1\nZeile 2");
+            event.start = origin.addDays(i);
+            event.end = event.start.addSecs(3600);
+            ids.append(storage.addOrUpdateEvent(event).id);
+        }
+        storage.commitBatch();
+    }
+
+    {
+        FileCalendarStorage storage(path);
+        storage.setMaterializedEventBudget(20);
+        QCOMPARE(storage.eventCount(), 200);
+        QCOMPARE(storage.materializedEventCount(), 0);
+
+        const auto week = storage.eventsInRange(origin.date().addDays(10), origin.date().addDays(16));
+        QCOMPARE(week.size(), static_cast<size_t>(7));
+        QCOMPARE(week.front().title, QStringLiteral("Termin 10"));
+        QCOMPARE(week.front().description, QStringLiteral("Zeile 1\nZeile 2"));
+        QCOMPARE(storage.materializedEventCount(), 7);
+
+        const auto quarter = storage.eventsInRange(origin.date(), origin.date().addDays(89));
+        QCOMPARE(quarter.size(), static_cast<size_t>(90));
+        QVERIFY(storage.materializedEventCount() <= 20);
+
+        // Modified events stay materialized; untouched ones are written back verbatim.
+        CalendarEvent changed = *storage.event(ids.at(150));
+        changed.title = QStringLiteral("Verschoben");
+        storage.addOrUpdateEvent(changed);
+        QVERIFY(storage.removeEvent(ids.at(151)));
+        storage.compact();
+    }
+
+    FileCalendarStorage reloaded(path);
+    QCOMPARE(reloaded.eventCount(), 199);
+    QCOMPARE(reloaded.event(ids.at(150))->title, QStringLiteral("Verschoben"));
+    QVERIFY(!reloaded.containsEvent(ids.at(151)));
+    QCOMPARE(reloaded.event(ids.at(42))->title, QStringLiteral("Termin 42"));
+    QCOMPARE(reloaded.event(ids.at(199))->start, origin.addDays(199));
+}
+
+void FileCalendarStorageTest::monthlyShards()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString root = dir.filePath(QStringLiteral("calendar"));
+    const QString january = root + QStringLiteral("/2024/2024-01.ics");
+    const QString march = root + QStringLiteral("/2024/2024-03.ics");
+    const QString spanning = root + QStringLiteral("/spanning.ics");
+
+    auto makeEvent = [](const QString &title, const QDateTime &start, int hours) {
+        CalendarEvent event;
+        event.title = title;
+        event.start = start;
+        event.end = start.addSecs(hours * 3600);
+        return event;
+    };
+    CalendarEvent meeting =
+        makeEvent(QStringLiteral("Meeting"), QDateTime(QDate(2024, 1, 15), QTime(9, 0)), 1);
+    const CalendarEvent review =
+        makeEvent(QStringLiteral("Review"), QDateTime(QDate(2024, 3, 4), QTime(14, 0)), 2);
+    const CalendarEvent trip =
+        makeEvent(QStringLiteral("Reise"), QDateTime(QDate(2024, 1, 30), QTime(8, 0)), 72);
+    {
+        FileCalendarStorage storage(root, FileCalendarStorage::Layout::Monthly);
+        storage.beginBatch();
+        storage.addOrUpdateEvent(meeting);
+        storage.addOrUpdateEvent(review);
+        storage.addOrUpdateEvent(trip);
+        TodoItem todo;
+        todo.title = QStringLiteral("Packen");
+        storage.addOrUpdateTodo(todo);
+        storage.commitBatch();
+        storage.flush();
+    }
+    QVERIFY(QFile::exists(january));
+    QVERIFY(QFile::exists(march));
+    QVERIFY(QFile::exists(spanning));
+    QVERIFY(QFile::exists(root + QStringLiteral("/todos.ics")));
+    QVERIFY(!QFile::exists(root + QStringLiteral("/2024/2024-02.ics")));
+
+    const QDateTime untouched(QDate(2020, 1, 1), QTime(0, 0));
+    {
+        QFile file(march);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(untouched, QFileDevice::FileModificationTime));
+    }
+
+    {
+        FileCalendarStorage storage(root, FileCalendarStorage::Layout::Monthly);
+        QCOMPARE(storage.todos().size(), 1);
+        QCOMPARE(storage.loadedShardCount(), 0);
+
+        // February has no file of its own; the trip comes from the spanning file.
+        const auto february = storage.eventsInRange(QDate(2024, 2, 1), QDate(2024, 2, 29));
+        QCOMPARE(february.size(), static_cast<size_t>(1));
+        QCOMPARE(february.front().title, QStringLiteral("Reise"));
+        QCOMPARE(storage.loadedShardCount(), 0);
+
+        const auto januaryEvents = storage.eventsInRange(QDate(2024, 1, 1), QDate(2024, 1, 31));
+        QCOMPARE(januaryEvents.size(), static_cast<size_t>(2));
+        QCOMPARE(storage.loadedShardCount(), 1);
+
+        meeting.title = QStringLiteral("Meeting (verschoben)");
+        meeting.start = meeting.start.addDays(1);
+        meeting.end = meeting.end.addDays(1);
+        storage.addOrUpdateEvent(meeting);
+        storage.flush();
+        QCOMPARE(storage.loadedShardCount(), 1);
+    }
+    QCOMPARE(QFileInfo(march).lastModified(), untouched);
+
+    {
+        // Moving an event to another month removes it from its old file. The shard index
+        // leads to the month of the event without reading the others.
+        FileCalendarStorage storage(root, FileCalendarStorage::Layout::Monthly);
+        QCOMPARE(storage.eventCount(), 3);
+        // Month files that were not read are parsed by the worker and stay unread.
+        QFuture<EventSnapshot> all = storage.allEventsAsync(CancellationToken());
+        all.waitForFinished();
+        QCOMPARE(all.result().size(), size_t(3));
+        QCOMPARE(storage.loadedShardCount(), 0);
+        QVERIFY(storage.containsEvent(meeting.id));
+        QCOMPARE(storage.loadedShardCount(), 1);
+        QVERIFY(!storage.containsEvent(QUuid::createUuid()));
+        QCOMPARE(storage.loadedShardCount(), 1);
+        meeting.start = QDateTime(QDate(2024, 3, 20), QTime(10, 0));
+        meeting.end = meeting.start.addSecs(3600);
+        storage.addOrUpdateEvent(meeting);
+        QVERIFY(storage.removeEvent(trip.id));
+        storage.flush();
+    }
+    QVERIFY(!QFile::exists(january));
+    QVERIFY(!QFile::exists(spanning));
+
+    FileCalendarStorage reloaded(root, FileCalendarStorage::Layout::Monthly);
+    QCOMPARE(reloaded.eventCount(), 2);
+    QCOMPARE(reloaded.event(meeting.id)->title, QStringLiteral("Meeting (verschoben)"));
+    QCOMPARE(reloaded.eventsInRange(QDate(2024, 3, 1), QDate(2024, 3, 31)).size(), static_cast<size_t>(2));
+    QVERIFY(!reloaded.containsEvent(trip.id));
+}
+
+void FileCalendarStorageTest::monthlyShardDuplicates()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString root = dir.filePath(QStringLiteral("calendar"));
+    const QString january = root + QStringLiteral("/2024/2024-01.ics");
+    const QString march = root + QStringLiteral("/2024/2024-03.ics");
+
+    CalendarEvent event;
+    event.title = QStringLiteral("Termin");
+    event.start = QDateTime(QDate(2024, 1, 15), QTime(9, 0));
+    event.end = event.start.addSecs(3600);
+    {
+        FileCalendarStorage storage(root, FileCalendarStorage::Layout::Monthly);
+        storage.addOrUpdateEvent(event);
+        storage.flush();
+    }
+    QVERIFY(QFile::exists(january));
+
+    {
+        // The month of the old copy has not been read; the shard index leads to it.
+        FileCalendarStorage storage(root, FileCalendarStorage::Layout::Monthly);
+        event.start = QDateTime(QDate(2024, 3, 4), QTime(9, 0));
+        event.end = event.start.addSecs(3600);
+        storage.addOrUpdateEvent(event);
+        storage.flush();
+    }
+    QVERIFY(!QFile::exists(january));
+    {
+        FileCalendarStorage storage(root, FileCalendarStorage::Layout::Monthly);
+        QCOMPARE(storage.eventCount(), 1);
+    }
+
+    // An interrupted move leaves the event in two files. The copy from the newer file wins,
+    // whichever month is read first.
+    CalendarEvent stale = event;
+    stale.title = QStringLiteral("Termin (alt)");
+    stale.start = QDateTime(QDate(2024, 1, 15), QTime(9, 0));
+    stale.end = stale.start.addSecs(3600);
+    const auto writeShard = [](const QString &path, const CalendarEvent &copy, qint64 revision) {
+        CalendarSnapshot shard;
+        shard.events.insert(copy.id, std::make_shared<const CalendarEvent>(copy));
+        shard.revision = revision;
+        return IcsWriter::writeCalendar(path, shard);
+    };
+    for (const bool januaryFirst : {true, false}) {
+        QVERIFY(writeShard(january, stale, 100));
+        QVERIFY(writeShard(march, event, 200));
+        {
+            FileCalendarStorage storage(root, FileCalendarStorage::Layout::Monthly);
+            const QDate first = januaryFirst ? QDate(2024, 1, 1) : QDate(2024, 3, 1);
+            const QDate second = januaryFirst ? QDate(2024, 3, 1) : QDate(2024, 1, 1);
+            storage.eventsInRange(first, first.addMonths(1).addDays(-1));
+            storage.eventsInRange(second, second.addMonths(1).addDays(-1));
+            QCOMPARE(storage.eventCount(), 1);
+            QCOMPARE(storage.event(event.id)->title, QStringLiteral("Termin"));
+            QVERIFY(storage.eventsInRange(QDate(2024, 1, 1), QDate(2024, 1, 31)).empty());
+        }
+        QVERIFY(!QFile::exists(january));
+    }
+}
+
+void FileCalendarStorageTest::externalEditsAreMerged()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+
+    auto makeEvent = [](const QString &title, const QDateTime &start) {
+        CalendarEvent event;
+        event.title = title;
+        event.start = start;
+        event.end = start.addSecs(3600);
+        return event;
+    };
+
+    FileCalendarStorage storage(path);
+    storage.setWriteCoalescingInterval(0);
+    std::vector<EventChangeSet> eventChanges;
+    std::vector<TodoChangeSet> todoChanges;
+    connect(&storage,
+            &FileCalendarStorage::eventsChangedExternally,
+            this,
+            [&](const EventChangeSet &changes) { eventChanges.push_back(changes); });
+    connect(&storage,
+            &FileCalendarStorage::todosChangedExternally,
+            this,
+            [&](const TodoChangeSet &changes) { todoChanges.push_back(changes); });
+
+    const CalendarEvent standup = storage.addOrUpdateEvent(
+        makeEvent(QStringLiteral("Standup"), QDateTime(QDate(2024, 5, 6), QTime(9, 0))));
+    CalendarEvent review = storage.addOrUpdateEvent(
+        makeEvent(QStringLiteral("Review"), QDateTime(QDate(2024, 5, 7), QTime(14, 0))));
+    TodoItem todo;
+    todo.title = QStringLiteral("Protokoll");
+    todo = storage.addOrUpdateTodo(todo);
+    storage.compact();
+    storage.flush();
+
+    // Rewriting the file ourselves is not reported as an external change.
+    QTest::qWait(500);
+    QVERIFY(eventChanges.empty());
+    QVERIFY(todoChanges.empty());
+
+    // A change that is still in the journal wins over the file.
+    review.title = QStringLiteral("Review (lokal)");
+    storage.addOrUpdateEvent(review);
+    storage.flush();
+
+    CalendarSnapshot external;
+    CalendarEvent moved = standup;
+    moved.title = QStringLiteral("Standup (verschoben)");
+    moved.start = moved.start.addSecs(1800);
+    moved.end = moved.end.addSecs(1800);
+    external.events.insert(moved.id, std::make_shared<const CalendarEvent>(moved));
+    CalendarEvent remoteReview = review;
+    remoteReview.title = QStringLiteral("Review (entfernt)");
+    external.events.insert(remoteReview.id, std::make_shared<const CalendarEvent>(remoteReview));
+    CalendarEvent added = makeEvent(QStringLiteral("Retro"), QDateTime(QDate(2024, 5, 8), QTime(11, 0)));
+    added.id = QUuid::createUuid();
+    external.events.insert(added.id, std::make_shared<const CalendarEvent>(added));
+    QVERIFY(IcsWriter::writeCalendar(path, external));
+
+    QTRY_COMPARE(eventChanges.size(), static_cast<size_t>(1));
+    QTRY_COMPARE(todoChanges.size(), static_cast<size_t>(1));
+    const EventChangeSet &events = eventChanges.front();
+    QCOMPARE(events.updated.size(), static_cast<size_t>(1));
+    QCOMPARE(events.updated.front().before.title, QStringLiteral("Standup"));
+    QCOMPARE(events.updated.front().after.title, QStringLiteral("Standup (verschoben)"));
+    QCOMPARE(events.inserted.size(), static_cast<size_t>(1));
+    QCOMPARE(events.inserted.front().id, added.id);
+    QVERIFY(events.removed.empty());
+    QCOMPARE(todoChanges.front().removed.size(), static_cast<size_t>(1));
+    QCOMPARE(todoChanges.front().removed.front().id, todo.id);
+
+    QCOMPARE(storage.eventCount(), 3);
+    QCOMPARE(storage.event(review.id)->title, QStringLiteral("Review (lokal)"));
+    QVERIFY(storage.todos().isEmpty());
+    const auto day = storage.eventsInRange(QDate(2024, 5, 6), QDate(2024, 5, 6));
+    QCOMPARE(day.size(), static_cast<size_t>(1));
+    QCOMPARE(day.front().start, moved.start);
+}
+
+QTEST_GUILESS_MAIN(FileCalendarStorageTest)
+#include "FileCalendarStorageTest.moc"
@@ -0,0 +1,526 @@
+#include <QtTest/QtTest>
+
+#include "calendar/data/IcsDateTime.hpp"
+#include "calendar/data/IcsParser.hpp"
+#include "calendar/data/IcsWriter.hpp"
+
+using namespace calendar::data;
+
+namespace {
+constexpr int BENCHMARK_EVENT_COUNT = 20000;
+constexpr int BENCHMARK_TODO_COUNT = 2000;
+constexpr int FOLD_WIDTH = 74;
+
+// The QTextStream based parser FileCalendarStorage used before IcsParser, kept as the
+// reference for both correctness and speed.
+QString legacyDecodeText(const QString &text)
+{
+    QString decoded = text;
+    decoded.replace("\\n", "\n", Qt::CaseInsensitive);
+    decoded.replace("\\,", ",");
+    decoded.replace("\\;", ";");
+    decoded.replace("\\\\", "\\");
+    return decoded;
+}
+
+QDateTime legacyParseDateTime(const QString &value)
+{
+    if (value.length() == 8) {
+        return QDate::fromString(value, "yyyyMMdd").startOfDay();
+    }
+    if (value.endsWith('Z')) {
+        QDateTime dt = QDateTime::fromString(value, "yyyyMMdd'T'hhmmss'Z'");
+        dt.setTimeSpec(Qt::UTC);
+        return dt.toLocalTime();
+    }
+    QDateTime dt = QDateTime::fromString(value, "yyyyMMdd'T'hhmmss");
+    if (!dt.isValid()) {
+        dt = QDateTime::fromString(value, Qt::ISODate);
+    }
+    return dt;
+}
+
+QString legacyFormatDateTime(const QDateTime &value)
+{
+    return value.toUTC().toString(QStringLiteral("yyyyMMdd'T'hhmmss'Z'"));
+}
+
+// Start times as the benchmark calendar has them.
+std::vector<QDateTime> benchmarkDateTimes()
+{
+    const QDateTime base(QDate(2024, 1, 1), QTime(8, 0));
+    std::vector<QDateTime> values;
+    values.reserve(BENCHMARK_EVENT_COUNT);
+    for (int i = 0; i < BENCHMARK_EVENT_COUNT; ++i) {
+        values.push_back(base.addSecs(static_cast<qint64>(i) * 45 * 60));
+    }
+    return values;
+}
+
+QStringList legacySplitList(const QString &value)
+{
+    QStringList cleaned;
+    for (const QString &part : value.split(',', Qt::SkipEmptyParts)) {
+        cleaned << part.trimmed();
+    }
+    return cleaned;
+}
+
+QUuid legacyParseUid(const QString &value)
+{
+    const QUuid id(QStringLiteral("{%1}").arg(value));
+    return id.isNull() ? QUuid::createUuid() : id;
+}
+
+void legacyParse(const QString &path, QHash<QUuid, CalendarEvent> &events, QHash<QUuid, TodoItem> &todos)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return;
+    }
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    enum class Section {
+        None,
+        Event,
+        Todo
+    };
+    Section section = Section::None;
+    CalendarEvent event;
+    TodoItem todo;
+
+    auto handleLine = [&](const QString &line) {
+        if (line == QLatin1String("BEGIN:VEVENT")) {
+            section = Section::Event;
+            event = CalendarEvent{};
+            return;
+        }
+        if (line == QLatin1String("END:VEVENT")) {
+            if (!event.end.isValid() || event.end <= event.start) {
+                event.end = event.start.addSecs(30 * 60);
+            }
+            events.insert(event.id, event);
+            section = Section::None;
+            return;
+        }
+        if (line == QLatin1String("BEGIN:VTODO")) {
+            section = Section::Todo;
+            todo = TodoItem{};
+            return;
+        }
+        if (line == QLatin1String("END:VTODO")) {
+            todos.insert(todo.id, todo);
+            section = Section::None;
+            return;
+        }
+        const int colonIndex = line.indexOf(':');
+        if (colonIndex <= 0 || section == Section::None) {
+            return;
+        }
+        const QString property = line.left(colonIndex);
+        const QString rawValue = line.mid(colonIndex + 1);
+        const QString name = property.section(';', 0, 0).toUpper();
+        const QString parameters = property.contains(';') ? property.section(';', 1) : QString();
+        const QString value = legacyDecodeText(rawValue);
+        const bool dateOnlyParam = parameters.contains(QLatin1String("VALUE=DATE"), Qt::CaseInsensitive);
+
+        if (section == Section::Event) {
+            if (name == QLatin1String("UID")) {
+                event.id = legacyParseUid(value);
+            } else if (name == QLatin1String("SUMMARY")) {
+                event.title = value;
+            } else if (name == QLatin1String("DESCRIPTION")) {
+                event.description = value;
+            } else if (name == QLatin1String("LOCATION")) {
+                event.location = value;
+            } else if (name == QLatin1String("DTSTART")) {
+                event.start = legacyParseDateTime(rawValue);
+                event.allDay = dateOnlyParam || rawValue.size() == 8;
+                if (event.allDay && event.start.isValid()) {
+                    event.start.setTime(QTime(0, 0));
+                }
+            } else if (name == QLatin1String("DTEND")) {
+                event.end = legacyParseDateTime(rawValue);
+                if (event.allDay && event.end.isValid()) {
+                    event.end.setTime(QTime(0, 0));
+                }
+            } else if (name == QLatin1String("CATEGORIES")) {
+                event.categories = legacySplitList(value);
+            } else if (name == QLatin1String("RRULE")) {
+                event.recurrenceRule = rawValue;
+            } else if (name == QLatin1String("X-TASKMASTER-REMINDER")) {
+                event.reminderMinutes = rawValue.toInt();
+            } else if (name == QLatin1String("X-TASKMASTER-ALLDAY")) {
+                event.allDay = rawValue.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0;
+            }
+            return;
+        }
+
+        if (name == QLatin1String("UID")) {
+            todo.id = legacyParseUid(value);
+        } else if (name == QLatin1String("SUMMARY")) {
+            todo.title = value;
+        } else if (name == QLatin1String("DESCRIPTION")) {
+            todo.description = value;
+        } else if (name == QLatin1String("LOCATION")) {
+            todo.location = value;
+        } else if (name == QLatin1String("DUE")) {
+            todo.dueDate = legacyParseDateTime(rawValue);
+            if (dateOnlyParam && todo.dueDate.isValid()) {
+                todo.dueDate.setTime(QTime(0, 0));
+            }
+        } else if (name == QLatin1String("PRIORITY")) {
+            todo.priority = rawValue.toInt();
+        } else if (name == QLatin1String("STATUS")) {
+            const QString normalized = rawValue.toUpper();
+            if (normalized == QLatin1String("COMPLETED")) {
+                todo.status = TodoStatus::Completed;
+            } else if (normalized == QLatin1String("IN-PROCESS")) {
+                todo.status = TodoStatus::InProgress;
+            }
+        } else if (name == QLatin1String("CATEGORIES")) {
+            todo.tags = legacySplitList(value);
+        } else if (name == QLatin1String("X-TASKMASTER-SCHEDULED")) {
+            todo.scheduled = rawValue.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0;
+        } else if (name == QLatin1String("X-TASKMASTER-DURATION")) {
+            todo.durationMinutes = rawValue.toInt();
+        }
+    };
+
+    QString accumulator;
+    bool hasAccumulator = false;
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine();
+        if (!line.isEmpty() && (line.startsWith(' ') || line.startsWith('\t'))) {
+            if (hasAccumulator) {
+                accumulator += line.mid(1);
+            }
+        } else {
+            if (hasAccumulator) {
+                handleLine(accumulator);
+            }
+            accumulator = line;
+            hasAccumulator = true;
+        }
+    }
+    if (hasAccumulator) {
+        handleLine(accumulator);
+    }
+}
+
+// Folds long content lines the way external calendars export them.
+QString foldLines(const QString &text)
+{
+    QString folded;
+    folded.reserve(text.size() + text.size() / 16);
+    const QStringList lines = text.split(QStringLiteral("\r\n"));
+    for (const QString &line : lines) {
+        if (line.isEmpty()) {
+            continue;
+        }
+        folded += line.left(FOLD_WIDTH);
+        for (int pos = FOLD_WIDTH; pos < line.size(); pos += FOLD_WIDTH - 1) {
+            folded += QStringLiteral("\r\n ");
+            folded += line.mid(pos, FOLD_WIDTH - 1);
+        }
+        folded += QStringLiteral("\r\n");
+    }
+    return folded;
+}
+
+bool writeBenchmarkCalendar(const QString &path)
+{
+    QString contents = QStringLiteral("BEGIN:VCALENDAR\r\nVERSION:2.0\r\n");
+    const QDateTime base(QDate(2024, 1, 1), QTime(8, 0));
+    for (int i = 0; i < BENCHMARK_EVENT_COUNT; ++i) {
+        CalendarEvent event;
+        event.id = QUuid::createUuid();
+        event.title = QStringLiteral("Besprechung %1 – Planung für das nächste Quartal").arg(i);
+        event.description = QStringLiteral("Agenda:\nPunkt 1, Punkt 2; Punkt 3\nRaum wird noch bekanntgegeben, "
+                                           "bitte Unterlagen vorab lesen.");
+        event.location = QStringLiteral("Linz, Büro %1").arg(i % 40);
+        event.categories = {QStringLiteral("Arbeit"), QStringLiteral("Team")};
+        event.start = base.addSecs(static_cast<qint64>(i) * 45 * 60);
+        event.end = event.start.addSecs(30 * 60);
+        event.allDay = i % 50 == 0;
+        event.reminderMinutes = 10;
+        contents += IcsWriter::eventRecord(event);
+    }
+    for (int i = 0; i < BENCHMARK_TODO_COUNT; ++i) {
+        TodoItem todo;
+        todo.id = QUuid::createUuid();
+        todo.title = QStringLiteral("Aufgabe %1").arg(i);
+        todo.description = QStringLiteral("Details zur Aufgabe, mit Komma; und Semikolon");
+        todo.dueDate = base.addDays(i % 90);
+        todo.priority = i % 5;
+        todo.status = static_cast<TodoStatus>(i % 3);
+        todo.tags = {QStringLiteral("privat")};
+        contents += IcsWriter::todoRecord(todo);
+    }
+    contents += QStringLiteral("END:VCALENDAR\r\n");
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(foldLines(contents).toUtf8()) > 0;
+}
+} // namespace
+
+class IcsParserBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void unfoldsAndDecodes();
+    void matchesLegacyParser();
+    void concurrentMatchesSequential();
+    void legacyParser();
+    void mappedParser();
+    void concurrentParser();
+    void eventIndex();
+    void dateTimeMatchesLegacy();
+    void legacyDateTimeConversion();
+    void dateTimeConversion();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_path;
+};
+
+void IcsParserBenchmark::initTestCase()
+{
+    // A zone with daylight saving time, so that the conversions cross transitions.
+    qputenv("TZ", "Europe/Vienna");
+    QVERIFY(m_dir.isValid());
+    m_path = m_dir.filePath(QStringLiteral("benchmark.ics"));
+    QVERIFY(writeBenchmarkCalendar(m_path));
+}
+
+void IcsParserBenchmark::unfoldsAndDecodes()
+{
+    QByteArray input("BEGIN:VEVENT\r\n"
+                     "UID:6f1c7f2e-3f4b-4c55-9d6e-0a1b2c3d4e5f\r\n"
+                     "SUMMARY:Lange \r\n"
+                     " Zusammen\r\n"
+                     "\tfassung\r\n"
+                     "DESCRIPTION:Zeile 1\\nZeile 2\\, mit Komma\\; und \\\\n\r\n"
+                     "DTSTART;VALUE=DATE:20240304\r\n"
+                     "DTEND;VALUE=DATE:20240305\r\n"
+                     "END:VEVENT\r\n"
+                     "X-TASKMASTER-DELETED-TODO:6f1c7f2e-3f4b-4c55-9d6e-0a1b2c3d4e60\r\n"
+                     "BEGIN:VTODO\r\n"
+                     "SUMMARY:Offen");
+
+    IcsParser::Collector collector;
+    const auto result = IcsParser::parse(input.data(), input.data() + input.size(), collector);
+    QCOMPARE(result.records, 2);
+    QVERIFY(!result.complete);
+    QCOMPARE(collector.events.size(), 1);
+    QVERIFY(collector.todos.isEmpty());
+
+    const CalendarEvent event = collector.events.constBegin().value();
+    QCOMPARE(event.id, QUuid(QStringLiteral("{6f1c7f2e-3f4b-4c55-9d6e-0a1b2c3d4e5f}")));
+    QCOMPARE(event.title, QStringLiteral("Lange Zusammenfassung"));
+    QCOMPARE(event.description, QStringLiteral("Zeile 1\nZeile 2, mit Komma; und \\n"));
+    QVERIFY(event.allDay);
+    QCOMPARE(event.start, QDateTime(QDate(2024, 3, 4), QTime(0, 0)));
+    QCOMPARE(event.end, QDateTime(QDate(2024, 3, 5), QTime(0, 0)));
+}
+
+void IcsParserBenchmark::matchesLegacyParser()
+{
+    QHash<QUuid, CalendarEvent> legacyEvents;
+    QHash<QUuid, TodoItem> legacyTodos;
+    legacyParse(m_path, legacyEvents, legacyTodos);
+
+    IcsParser::Collector collector;
+    const auto result = IcsParser::parseFile(m_path, collector);
+    QVERIFY(result.complete);
+    QCOMPARE(result.records, BENCHMARK_EVENT_COUNT + BENCHMARK_TODO_COUNT);
+    QCOMPARE(collector.events.size(), legacyEvents.size());
+    QCOMPARE(collector.todos.size(), legacyTodos.size());
+
+    for (auto it = legacyEvents.constBegin(); it != legacyEvents.constEnd(); ++it) {
+        const auto found = collector.events.constFind(it.key());
+        QVERIFY(found != collector.events.constEnd());
+        const CalendarEvent &expected = it.value();
+        const CalendarEvent &actual = found.value();
+        QCOMPARE(actual.title, expected.title);
+        QCOMPARE(actual.description, expected.description);
+        QCOMPARE(actual.location, expected.location);
+        QCOMPARE(actual.categories, expected.categories);
+        QCOMPARE(actual.start, expected.start);
+        QCOMPARE(actual.end, expected.end);
+        QCOMPARE(actual.allDay, expected.allDay);
+        QCOMPARE(actual.reminderMinutes, expected.reminderMinutes);
+    }
+    for (auto it = legacyTodos.constBegin(); it != legacyTodos.constEnd(); ++it) {
+        const auto found = collector.todos.constFind(it.key());
+        QVERIFY(found != collector.todos.constEnd());
+        const TodoItem &expected = it.value();
+        const TodoItem &actual = found.value();
+        QCOMPARE(actual.title, expected.title);
+        QCOMPARE(actual.description, expected.description);
+        QCOMPARE(actual.dueDate, expected.dueDate);
+        QCOMPARE(actual.priority, expected.priority);
+        QVERIFY(actual.status == expected.status);
+        QCOMPARE(actual.tags, expected.tags);
+    }
+}
+
+void IcsParserBenchmark::concurrentMatchesSequential()
+{
+    QFile file(m_path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray contents = file.readAll();
+
+    // A removal at the end has to reach records parsed by the first worker.
+    const int uidStart = contents.indexOf("UID:") + 4;
+    const QByteArray firstUid = contents.mid(uidStart, 36);
+    contents.append("X-TASKMASTER-DELETED-EVENT:" + firstUid + "\r\n");
+    QByteArray sequentialInput = contents;
+
+    IcsParser::Collector sequential;
+    const auto sequentialResult
+        = IcsParser::parse(sequentialInput.data(), sequentialInput.data() + sequentialInput.size(), sequential);
+    IcsParser::Collector concurrent;
+    const auto concurrentResult
+        = IcsParser::parseConcurrently(contents.data(), contents.data() + contents.size(), concurrent);
+
+    QCOMPARE(concurrentResult.records, sequentialResult.records);
+    QCOMPARE(concurrentResult.complete, sequentialResult.complete);
+    QCOMPARE(concurrent.events.size(), BENCHMARK_EVENT_COUNT - 1);
+    QVERIFY(!concurrent.events.contains(QUuid(QStringLiteral("{%1}").arg(QString::fromLatin1(firstUid)))));
+    QCOMPARE(concurrent.events.size(), sequential.events.size());
+    QCOMPARE(concurrent.todos.size(), sequential.todos.size());
+    for (auto it = sequential.todos.constBegin(); it != sequential.todos.constEnd(); ++it) {
+        QVERIFY(concurrent.todos.contains(it.key()));
+    }
+    for (auto it = sequential.events.constBegin(); it != sequential.events.constEnd(); ++it) {
+        QVERIFY(concurrent.events.contains(it.key()));
+        const CalendarEvent actual = concurrent.events.value(it.key());
+        QCOMPARE(actual.title, it.value().title);
+        QCOMPARE(actual.start, it.value().start);
+        QCOMPARE(actual.end, it.value().end);
+    }
+}
+
+void IcsParserBenchmark::legacyParser()
+{
+    QBENCHMARK {
+        QHash<QUuid, CalendarEvent> events;
+        QHash<QUuid, TodoItem> todos;
+        legacyParse(m_path, events, todos);
+        QCOMPARE(events.size(), BENCHMARK_EVENT_COUNT);
+    }
+}
+
+void IcsParserBenchmark::mappedParser()
+{
+    QBENCHMARK {
+        IcsParser::Collector collector;
+        IcsParser::parseFile(m_path, collector);
+        QCOMPARE(collector.events.size(), BENCHMARK_EVENT_COUNT);
+    }
+}
+
+void IcsParserBenchmark::concurrentParser()
+{
+    QBENCHMARK {
+        IcsParser::Collector collector;
+        IcsParser::parseFileConcurrently(m_path, collector);
+        QCOMPARE(collector.events.size(), BENCHMARK_EVENT_COUNT);
+    }
+}
+
+void IcsParserBenchmark::eventIndex()
+{
+    QFile file(m_path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+
+    QBENCHMARK {
+        IcsParser::Collector collector;
+        IcsParser::indexConcurrently(contents.constData(), contents.constData() + contents.size(), collector);
+        QCOMPARE(collector.eventRefs.size(), BENCHMARK_EVENT_COUNT);
+    }
+
+    IcsParser::Collector collector;
+    IcsParser::index(contents.constData(), contents.constData() + contents.size(), collector);
+    QCOMPARE(collector.todos.size(), BENCHMARK_TODO_COUNT);
+    for (const IcsEventRef &ref : qAsConst(collector.eventRefs)) {
+        const auto event = IcsParser::parseEvent(contents.constData() + ref.offset, ref.length);
+        QVERIFY(event.has_value());
+        QCOMPARE(event->id, ref.id);
+        QCOMPARE(event->start, ref.start);
+        QCOMPARE(event->end, ref.end);
+    }
+}
+
+void IcsParserBenchmark::dateTimeMatchesLegacy()
+{
+    const QDate first(2023, 1, 1);
+    const QDate last(2025, 12, 31);
+    for (QDate date = first; date <= last; date = date.addDays(1)) {
+        const QString text = date.toString(QStringLiteral("yyyyMMdd"));
+        QCOMPARE(IcsDateTime::formatDate(date), text);
+        const QByteArray bytes = text.toLatin1();
+        const QDateTime parsed = IcsDateTime::parse(bytes.constData(), bytes.size());
+        QCOMPARE(parsed, legacyParseDateTime(text));
+        QCOMPARE(parsed.timeSpec(), Qt::LocalTime);
+    }
+
+    // Quarter hours plus a few seconds, as instants and as local wall times. The latter
+    // include the skipped and the repeated hour of every transition.
+    const qint64 begin = first.startOfDay(Qt::UTC).toMSecsSinceEpoch();
+    const qint64 end = last.endOfDay(Qt::UTC).toMSecsSinceEpoch();
+    for (qint64 msecs = begin; msecs < end; msecs += 15 * 60 * 1000 + 7000) {
+        const QDateTime instant = QDateTime::fromMSecsSinceEpoch(msecs);
+        const QString text = legacyFormatDateTime(instant);
+        QCOMPARE(IcsDateTime::format(instant), text);
+        const QByteArray bytes = text.toLatin1();
+        const QDateTime parsed = IcsDateTime::parse(bytes.constData(), bytes.size());
+        QCOMPARE(parsed, legacyParseDateTime(text));
+        QCOMPARE(parsed.timeSpec(), Qt::LocalTime);
+
+        const QDateTime wallTime(QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC).date(),
+                                 QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC).time());
+        QCOMPARE(IcsDateTime::format(wallTime), legacyFormatDateTime(wallTime));
+        const QByteArray floating = wallTime.toString(QStringLiteral("yyyyMMdd'T'hhmmss")).toLatin1();
+        QCOMPARE(IcsDateTime::parse(floating.constData(), floating.size()), wallTime);
+    }
+
+    const QDateTime utc(QDate(2024, 7, 1), QTime(12, 30, 15), Qt::UTC);
+    QCOMPARE(IcsDateTime::format(utc), QStringLiteral("20240701T123015Z"));
+    QCOMPARE(IcsDateTime::format(QDateTime()), QString());
+    QVERIFY(!IcsDateTime::parse("20240230", 8).isValid());
+    QVERIFY(!IcsDateTime::parse("20240701T246000Z", 16).isValid());
+}
+
+void IcsParserBenchmark::legacyDateTimeConversion()
+{
+    const std::vector<QDateTime> values = benchmarkDateTimes();
+    QBENCHMARK {
+        for (const QDateTime &value : values) {
+            QVERIFY(legacyParseDateTime(legacyFormatDateTime(value)).isValid());
+        }
+    }
+}
+
+void IcsParserBenchmark::dateTimeConversion()
+{
+    const std::vector<QDateTime> values = benchmarkDateTimes();
+    QBENCHMARK {
+        for (const QDateTime &value : values) {
+            const QByteArray text = IcsDateTime::format(value).toLatin1();
+            QVERIFY(IcsDateTime::parse(text.constData(), text.size()).isValid());
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(IcsParserBenchmark)
+
+#include "IcsParserBenchmark.moc"
@@ -0,0 +1,375 @@
+#include <QtTest/QtTest>
+
+#include "calendar/data/IcsParser.hpp"
+#include "calendar/data/IcsWriter.hpp"
+#include "calendar/data/InMemoryEventRepository.hpp"
+#include "calendar/data/Recurrence.hpp"
+#include "calendar/data/RecurringEventRepository.hpp"
+
+using namespace calendar::data;
+
+namespace {
+std::vector<QDateTime> expand(const QString &ruleText,
+                              const QDateTime &start,
+                              const QDate &from,
+                              const QDate &to,
+                              qint64 durationMs = 30 * 60 * 1000)
+{
+    const auto rule = RecurrenceRule::parse(ruleText);
+    if (!rule) {
+        return {};
+    }
+    return rule->occurrences(start, durationMs, from.startOfDay(), to.addDays(1).startOfDay().addMSecs(-1));
+}
+
+std::vector<QDate> datesOf(const std::vector<QDateTime> &dateTimes)
+{
+    std::vector<QDate> dates;
+    for (const QDateTime &dateTime : dateTimes) {
+        dates.push_back(dateTime.date());
+    }
+    return dates;
+}
+
+CalendarEvent standUp()
+{
+    CalendarEvent event;
+    event.title = QStringLiteral("Stand-up");
+    event.start = QDateTime(QDate(2024, 1, 1), QTime(9, 0));
+    event.end = event.start.addSecs(15 * 60);
+    event.recurrenceRule = QStringLiteral("FREQ=DAILY");
+    return event;
+}
+} // namespace
+
+class RecurrenceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parsesRules();
+    void expandsEndlessSeriesPerWindow();
+    void honoursCountAndUntil();
+    void expandsByDayAndMonthDay();
+    void expandsYearlyMonthDaysInEveryMonth();
+    void repositoryExpandsSeries();
+    void editsSingleOccurrences();
+    void cachesWindowsUntilMasterChanges();
+    void icsRoundTrip();
+    void foreignUidsKeepSeriesTogether();
+};
+
+void RecurrenceTest::parsesRules()
+{
+    const auto rule = RecurrenceRule::parse(QStringLiteral("FREQ=MONTHLY;INTERVAL=2;BYDAY=-1FR,2MO;WKST=MO"));
+    QVERIFY(rule.has_value());
+    QCOMPARE(rule->frequency, RecurrenceRule::Frequency::Monthly);
+    QCOMPARE(rule->interval, 2);
+    QCOMPARE(rule->byDay.size(), static_cast<size_t>(2));
+    QCOMPARE(rule->byDay[0].ordinal, -1);
+    QCOMPARE(rule->byDay[0].dayOfWeek, 5);
+    QCOMPARE(rule->byDay[1].ordinal, 2);
+    QCOMPARE(rule->byDay[1].dayOfWeek, 1);
+
+    QVERIFY(RecurrenceRule::parse(QStringLiteral("RRULE:FREQ=WEEKLY;COUNT=3")).has_value());
+    QVERIFY(!RecurrenceRule::parse(QString()).has_value());
+    QVERIFY(!RecurrenceRule::parse(QStringLiteral("FREQ=HOURLY")).has_value());
+    QVERIFY(!RecurrenceRule::parse(QStringLiteral("FREQ=DAILY;INTERVAL=0")).has_value());
+    QVERIFY(!RecurrenceRule::parse(QStringLiteral("FREQ=MONTHLY;BYSETPOS=-1;BYDAY=MO")).has_value());
+    QVERIFY(!RecurrenceRule::parse(QStringLiteral("FREQ=WEEKLY;BYDAY=1MO")).has_value());
+}
+
+void RecurrenceTest::expandsEndlessSeriesPerWindow()
+{
+    const QDateTime start(QDate(2024, 1, 1), QTime(9, 0));
+    const auto week = expand(QStringLiteral("FREQ=DAILY"), start, QDate(2024, 1, 1), QDate(2024, 1, 7));
+    QCOMPARE(week.size(), static_cast<size_t>(7));
+    QCOMPARE(week.front(), start);
+    QCOMPARE(week.back(), QDateTime(QDate(2024, 1, 7), QTime(9, 0)));
+
+    // Decades later the window still only holds its own week.
+    const auto later = expand(QStringLiteral("FREQ=DAILY"), start, QDate(2054, 3, 2), QDate(2054, 3, 8));
+    QCOMPARE(later.size(), static_cast<size_t>(7));
+    QCOMPARE(later.front(), QDateTime(QDate(2054, 3, 2), QTime(9, 0)));
+
+    const auto everyOther =
+        expand(QStringLiteral("FREQ=DAILY;INTERVAL=2"), start, QDate(2024, 3, 1), QDate(2024, 3, 7));
+    QCOMPARE(datesOf(everyOther),
+             (std::vector<QDate>{
+                 QDate(2024, 3, 1), QDate(2024, 3, 3), QDate(2024, 3, 5), QDate(2024, 3, 7)}));
+
+    // Events lasting into the window count as well.
+    const auto overnight = expand(QStringLiteral("FREQ=WEEKLY"),
+                                  QDateTime(QDate(2024, 1, 1), QTime(22, 0)),
+                                  QDate(2024, 1, 9),
+                                  QDate(2024, 1, 9),
+                                  4 * 60 * 60 * 1000);
+    QCOMPARE(datesOf(overnight), (std::vector<QDate>{QDate(2024, 1, 8)}));
+    QVERIFY(expand(QStringLiteral("FREQ=DAILY"), start, QDate(2023, 12, 1), QDate(2023, 12, 31)).empty());
+}
+
+void RecurrenceTest::honoursCountAndUntil()
+{
+    const QDateTime start(QDate(2024, 1, 1), QTime(9, 0));
+    const auto five =
+        expand(QStringLiteral("FREQ=DAILY;COUNT=5"), start, QDate(2024, 1, 1), QDate(2024, 12, 31));
+    QCOMPARE(five.size(), static_cast<size_t>(5));
+    const auto tail =
+        expand(QStringLiteral("FREQ=WEEKLY;COUNT=10"), start, QDate(2024, 3, 1), QDate(2024, 12, 31));
+    QCOMPARE(datesOf(tail), (std::vector<QDate>{QDate(2024, 3, 4)}));
+
+    // A date as UNTIL includes that day.
+    const auto until =
+        expand(QStringLiteral("FREQ=DAILY;UNTIL=20240103"), start, QDate(2024, 1, 1), QDate(2024, 1, 31));
+    QCOMPARE(until.size(), static_cast<size_t>(3));
+    const auto untilTime = expand(QStringLiteral("FREQ=DAILY;UNTIL=20240103T080000Z"),
+                                  start,
+                                  QDate(2024, 1, 1),
+                                  QDate(2024, 1, 31));
+    QVERIFY(!untilTime.empty());
+    QVERIFY(untilTime.back() <= QDateTime(QDate(2024, 1, 3), QTime(8, 0), Qt::UTC));
+}
+
+void RecurrenceTest::expandsByDayAndMonthDay()
+{
+    const QDateTime monday(QDate(2024, 1, 1), QTime(9, 0));
+    const auto weekdays =
+        expand(QStringLiteral("FREQ=WEEKLY;BYDAY=MO,WE,FR"), monday, QDate(2024, 1, 1), QDate(2024, 1, 14));
+    QCOMPARE(datesOf(weekdays),
+             (std::vector<QDate>{QDate(2024, 1, 1),
+                                 QDate(2024, 1, 3),
+                                 QDate(2024, 1, 5),
+                                 QDate(2024, 1, 8),
+                                 QDate(2024, 1, 10),
+                                 QDate(2024, 1, 12)}));
+
+    const auto lastFriday =
+        expand(QStringLiteral("FREQ=MONTHLY;BYDAY=-1FR"), monday, QDate(2024, 1, 1), QDate(2024, 3, 31));
+    QCOMPARE(datesOf(lastFriday),
+             (std::vector<QDate>{
+                 QDate(2024, 1, 1), QDate(2024, 1, 26), QDate(2024, 2, 23), QDate(2024, 3, 29)}));
+
+    const auto lastDay =
+        expand(QStringLiteral("FREQ=MONTHLY;BYMONTHDAY=-1"), monday, QDate(2024, 2, 1), QDate(2024, 4, 30));
+    QCOMPARE(datesOf(lastDay),
+             (std::vector<QDate>{QDate(2024, 2, 29), QDate(2024, 3, 31), QDate(2024, 4, 30)}));
+
+    // Months without the 31st are skipped.
+    const QDateTime thirtyFirst(QDate(2024, 1, 31), QTime(12, 0));
+    const auto monthly =
+        expand(QStringLiteral("FREQ=MONTHLY"), thirtyFirst, QDate(2024, 1, 1), QDate(2024, 5, 31));
+    QCOMPARE(datesOf(monthly),
+             (std::vector<QDate>{QDate(2024, 1, 31), QDate(2024, 3, 31), QDate(2024, 5, 31)}));
+
+    const auto thanksgiving = expand(QStringLiteral("FREQ=YEARLY;BYMONTH=11;BYDAY=4TH"),
+                                     QDateTime(QDate(2024, 11, 28), QTime(18, 0)),
+                                     QDate(2025, 1, 1),
+                                     QDate(2026, 12, 31));
+    QCOMPARE(datesOf(thanksgiving), (std::vector<QDate>{QDate(2025, 11, 27), QDate(2026, 11, 26)}));
+}
+
+void RecurrenceTest::expandsYearlyMonthDaysInEveryMonth()
+{
+    const auto fifteenth = expand(QStringLiteral("FREQ=YEARLY;BYMONTHDAY=15"),
+                                  QDateTime(QDate(2024, 1, 15), QTime(10, 0)),
+                                  QDate(2025, 1, 1),
+                                  QDate(2025, 12, 31));
+    std::vector<QDate> expected;
+    for (int month = 1; month <= 12; ++month) {
+        expected.push_back(QDate(2025, month, 15));
+    }
+    QCOMPARE(datesOf(fifteenth), expected);
+
+    const auto fridayThe13th = expand(QStringLiteral("FREQ=YEARLY;BYDAY=FR;BYMONTHDAY=13"),
+                                      QDateTime(QDate(2024, 9, 13), QTime(20, 0)),
+                                      QDate(2026, 1, 1),
+                                      QDate(2026, 12, 31));
+    QCOMPARE(datesOf(fridayThe13th),
+             (std::vector<QDate>{QDate(2026, 2, 13), QDate(2026, 3, 13), QDate(2026, 11, 13)}));
+}
+
+void RecurrenceTest::repositoryExpandsSeries()
+{
+    InMemoryEventRepository backend;
+    RecurringEventRepository repo(backend);
+    CalendarEvent master = standUp();
+    master.exceptionDates = {QDateTime(QDate(2024, 1, 3), QTime(9, 0))};
+    repo.addEvent(master);
+    CalendarEvent single;
+    single.title = QStringLiteral("Review");
+    single.start = QDateTime(QDate(2024, 1, 2), QTime(8, 0));
+    single.end = single.start.addSecs(3600);
+    repo.addEvent(single);
+
+    const auto events = repo.fetchEvents(QDate(2024, 1, 1), QDate(2024, 1, 4));
+    QCOMPARE(events.size(), static_cast<size_t>(4));
+    QCOMPARE(events[0].start, master.start);
+    QCOMPARE(events[0].seriesId, master.id);
+    QVERIFY(events[0].id != master.id);
+    QVERIFY(events[0].recurrenceRule.isEmpty());
+    QCOMPARE(events[1].id, single.id);
+    QCOMPARE(events[2].start, QDateTime(QDate(2024, 1, 2), QTime(9, 0)));
+    QCOMPARE(events[3].start, QDateTime(QDate(2024, 1, 4), QTime(9, 0)));
+    QCOMPARE(events[3].end, QDateTime(QDate(2024, 1, 4), QTime(9, 15)));
+
+    // The master itself is outside, its occurrences are not.
+    const auto later = repo.fetchEvents(QDate(2030, 6, 3), QDate(2030, 6, 9));
+    QCOMPARE(later.size(), static_cast<size_t>(7));
+    const auto occurrence = repo.findById(later[2].id);
+    QVERIFY(occurrence.has_value());
+    QCOMPARE(occurrence->start, later[2].start);
+    QCOMPARE(occurrence->title, master.title);
+}
+
+void RecurrenceTest::editsSingleOccurrences()
+{
+    InMemoryEventRepository backend;
+    RecurringEventRepository repo(backend);
+    const CalendarEvent master = repo.addEvent(standUp());
+
+    auto events = repo.fetchEvents(QDate(2024, 1, 8), QDate(2024, 1, 14));
+    QCOMPARE(events.size(), static_cast<size_t>(7));
+    CalendarEvent moved = events[1];
+    moved.start = QDateTime(QDate(2024, 1, 20), QTime(11, 0));
+    moved.end = moved.start.addSecs(30 * 60);
+    moved.title = QStringLiteral("Verschoben");
+    QVERIFY(repo.updateEvent(moved));
+    QVERIFY(backend.findById(moved.id).has_value());
+    QCOMPARE(backend.findById(moved.id)->seriesId, master.id);
+
+    events = repo.fetchEvents(QDate(2024, 1, 8), QDate(2024, 1, 14));
+    QCOMPARE(events.size(), static_cast<size_t>(6));
+    const auto overrides = repo.fetchEvents(QDate(2024, 1, 20), QDate(2024, 1, 20));
+    QCOMPARE(overrides.size(), static_cast<size_t>(2));
+    QCOMPARE(overrides[0].start, QDateTime(QDate(2024, 1, 20), QTime(9, 0)));
+    QCOMPARE(overrides[1].id, moved.id);
+    QCOMPARE(overrides[1].title, moved.title);
+
+    // Removing an occurrence excludes it from the series; removing the override as well.
+    QVERIFY(repo.removeEvent(events[0].id));
+    QVERIFY(repo.removeEvent(moved.id));
+    QCOMPARE(backend.findById(master.id)->exceptionDates.size(), 2);
+    QCOMPARE(repo.fetchEvents(QDate(2024, 1, 8), QDate(2024, 1, 14)).size(), static_cast<size_t>(5));
+    QCOMPARE(repo.fetchEvents(QDate(2024, 1, 20), QDate(2024, 1, 20)).size(), static_cast<size_t>(1));
+
+    QVERIFY(repo.removeEvent(master.id));
+    QVERIFY(repo.fetchEvents(QDate(2024, 1, 1), QDate(2024, 12, 31)).empty());
+    QVERIFY(backend.fetchSeriesEvents().empty());
+}
+
+void RecurrenceTest::cachesWindowsUntilMasterChanges()
+{
+    InMemoryEventRepository backend;
+    RecurringEventRepository repo(backend);
+    CalendarEvent master = repo.addEvent(standUp());
+
+    QCOMPARE(repo.fetchEvents(QDate(2024, 2, 5), QDate(2024, 2, 11)).size(), static_cast<size_t>(7));
+    QCOMPARE(repo.cachedWindowCount(), 1);
+    QCOMPARE(repo.fetchEvents(QDate(2024, 2, 5), QDate(2024, 2, 11)).size(), static_cast<size_t>(7));
+    QCOMPARE(repo.cachedWindowCount(), 1);
+
+    // Navigating through many weeks keeps the number of windows bounded.
+    for (int week = 0; week < 100; ++week) {
+        const QDate monday = QDate(2025, 1, 6).addDays(7 * week);
+        QCOMPARE(repo.fetchEvents(monday, monday.addDays(6)).size(), static_cast<size_t>(7));
+    }
+    QVERIFY(repo.cachedWindowCount() <= 8);
+
+    master.recurrenceRule = QStringLiteral("FREQ=WEEKLY;BYDAY=MO,TH");
+    QVERIFY(repo.updateEvent(master));
+    QCOMPARE(repo.fetchEvents(QDate(2024, 2, 5), QDate(2024, 2, 11)).size(), static_cast<size_t>(2));
+
+    // Changes made directly in the storage are noticed as well.
+    master.recurrenceRule = QStringLiteral("FREQ=WEEKLY;BYDAY=MO");
+    QVERIFY(backend.updateEvent(master));
+    QCOMPARE(repo.fetchEvents(QDate(2024, 2, 5), QDate(2024, 2, 11)).size(), static_cast<size_t>(1));
+    master.recurrenceRule.clear();
+    QVERIFY(backend.updateEvent(master));
+    QVERIFY(repo.fetchEvents(QDate(2024, 2, 5), QDate(2024, 2, 11)).empty());
+    QCOMPARE(repo.cachedWindowCount(), 0);
+}
+
+void RecurrenceTest::icsRoundTrip()
+{
+    CalendarEvent master = standUp();
+    master.exceptionDates = {QDateTime(QDate(2024, 1, 3), QTime(9, 0))};
+    CalendarEvent moved;
+    moved.title = QStringLiteral("Stand-up (verschoben)");
+    moved.seriesId = master.id;
+    moved.recurrenceId = QDateTime(QDate(2024, 1, 4), QTime(9, 0));
+    moved.id = Recurrence::occurrenceId(master.id, moved.recurrenceId);
+    moved.start = QDateTime(QDate(2024, 1, 4), QTime(10, 0));
+    moved.end = moved.start.addSecs(15 * 60);
+
+    const QByteArray masterRecord = IcsWriter::eventRecord(master).toUtf8();
+    const QByteArray overrideRecord = IcsWriter::eventRecord(moved).toUtf8();
+    QVERIFY(overrideRecord.contains("UID:" + master.id.toString(QUuid::WithoutBraces).toUtf8()));
+    QVERIFY(overrideRecord.contains("RECURRENCE-ID:"));
+
+    const auto parsedMaster = IcsParser::parseEvent(masterRecord.constData(), masterRecord.size());
+    QVERIFY(parsedMaster.has_value());
+    QCOMPARE(parsedMaster->id, master.id);
+    QCOMPARE(parsedMaster->recurrenceRule, master.recurrenceRule);
+    QCOMPARE(parsedMaster->exceptionDates, master.exceptionDates);
+
+    const auto parsedOverride = IcsParser::parseEvent(overrideRecord.constData(), overrideRecord.size());
+    QVERIFY(parsedOverride.has_value());
+    QCOMPARE(parsedOverride->id, moved.id);
+    QCOMPARE(parsedOverride->seriesId, master.id);
+    QCOMPARE(parsedOverride->recurrenceId, moved.recurrenceId);
+
+    // The index knows which events belong to a series without parsing them.
+    const QByteArray calendar = "BEGIN:VCALENDAR\n" + masterRecord + overrideRecord + "END:VCALENDAR\n";
+    IcsParser::Collector collector;
+    IcsParser::index(calendar.constData(), calendar.constData() + calendar.size(), collector);
+    QCOMPARE(collector.eventRefs.size(), 2);
+    QVERIFY(collector.eventRefs.value(master.id).inSeries);
+    QVERIFY(collector.eventRefs.value(moved.id).inSeries);
+}
+
+void RecurrenceTest::foreignUidsKeepSeriesTogether()
+{
+    // UIDs written by other programs are not necessarily UUIDs.
+    QByteArray calendar = "BEGIN:VCALENDAR\n"
+                          "BEGIN:VEVENT\n"
+                          "UID:040000008200E00074C5B7101A82E008@example.com\n"
+                          "SUMMARY:Jour fixe\n"
+                          "DTSTART:20240108T100000\n"
+                          "DTEND:20240108T110000\n"
+                          "RRULE:FREQ=WEEKLY\n"
+                          "END:VEVENT\n"
+                          "BEGIN:VEVENT\n"
+                          "UID:040000008200E00074C5B7101A82E008@example.com\n"
+                          "SUMMARY:Jour fixe (verschoben)\n"
+                          "RECURRENCE-ID:20240115T100000\n"
+                          "DTSTART:20240116T100000\n"
+                          "DTEND:20240116T110000\n"
+                          "END:VEVENT\n"
+                          "END:VCALENDAR\n";
+    const QByteArray original = calendar;
+
+    IcsParser::Collector collector;
+    IcsParser::parse(calendar.data(), calendar.data() + calendar.size(), collector);
+    QCOMPARE(collector.events.size(), 2);
+    QUuid masterId;
+    QUuid overrideSeriesId;
+    for (const CalendarEvent &event : qAsConst(collector.events)) {
+        if (event.recurrenceId.isValid()) {
+            overrideSeriesId = event.seriesId;
+        } else {
+            masterId = event.id;
+        }
+    }
+    QVERIFY(!masterId.isNull());
+    QCOMPARE(overrideSeriesId, masterId);
+
+    // Reading the file again yields the same ids.
+    calendar = original;
+    IcsParser::Collector again;
+    IcsParser::parse(calendar.data(), calendar.data() + calendar.size(), again);
+    QVERIFY(again.events.contains(masterId));
+}
+
+QTEST_GUILESS_MAIN(RecurrenceTest)
+
+#include "RecurrenceTest.moc"
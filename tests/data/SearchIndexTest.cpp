@@ -0,0 +1,183 @@
+#include <QtTest/QtTest>
+
+#include "calendar/data/CalendarSearch.hpp"
+#include "calendar/data/InMemoryEventRepository.hpp"
+#include "calendar/data/InMemoryTodoRepository.hpp"
+#include "calendar/data/ObservableEventRepository.hpp"
+#include "calendar/data/ObservableTodoRepository.hpp"
+#include "calendar/data/RecurringEventRepository.hpp"
+#include "calendar/data/SearchIndex.hpp"
+
+#include <QRandomGenerator>
+
+using namespace calendar::data;
+
+class SearchIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesLikeContains();
+    void ignoresCase();
+    void followsRepositoryChanges();
+    void matchesOccurrencesThroughSeries();
+};
+
+namespace {
+QString randomText(QRandomGenerator &random, int maxLength)
+{
+    // A small alphabet, so queries of every length have matches.
+    static const QString alphabet = QStringLiteral("abcAB ä");
+    QString text;
+    const int length = random.bounded(maxLength + 1);
+    for (int i = 0; i < length; ++i) {
+        text.append(alphabet.at(random.bounded(alphabet.size())));
+    }
+    return text;
+}
+} // namespace
+
+void SearchIndexTest::matchesLikeContains()
+{
+    QRandomGenerator random(20240611);
+    SearchIndex index;
+    QHash<QUuid, QString> texts;
+    for (int round = 0; round < 400; ++round) {
+        const int action = random.bounded(4);
+        if (action == 0 && !texts.isEmpty()) {
+            const QUuid id = texts.keys().at(random.bounded(texts.size()));
+            QVERIFY(index.remove(id));
+            texts.remove(id);
+        } else if (action == 1 && !texts.isEmpty()) {
+            const QUuid id = texts.keys().at(random.bounded(texts.size()));
+            texts[id] = randomText(random, 12);
+            index.insert(id, texts[id]);
+        } else {
+            const QUuid id = QUuid::createUuid();
+            texts.insert(id, randomText(random, 12));
+            index.insert(id, texts[id]);
+        }
+        QCOMPARE(index.size(), texts.size());
+
+        const QString query = randomText(random, 5);
+        QSet<QUuid> expected;
+        if (!query.isEmpty()) {
+            for (auto it = texts.constBegin(); it != texts.constEnd(); ++it) {
+                if (it.value().contains(query, Qt::CaseInsensitive)) {
+                    expected.insert(it.key());
+                }
+            }
+        }
+        QCOMPARE(index.matching(query), expected);
+    }
+}
+
+void SearchIndexTest::ignoresCase()
+{
+    SearchIndex index;
+    const QUuid dentist = QUuid::createUuid();
+    const QUuid market = QUuid::createUuid();
+    index.insert(dentist, QStringLiteral("Zahnarzt Dr. Müller"));
+    index.insert(market, QStringLiteral("Wochenmarkt"));
+
+    QCOMPARE(index.matching(QStringLiteral("ZAHN")), QSet<QUuid>({dentist}));
+    QCOMPARE(index.matching(QStringLiteral("MÜLLER")), QSet<QUuid>({dentist}));
+    QCOMPARE(index.matching(QStringLiteral("arkt")), QSet<QUuid>({market}));
+    QCOMPARE(index.matching(QStringLiteral("rz")), QSet<QUuid>({dentist}));
+    QVERIFY(index.matching(QStringLiteral("marktz")).isEmpty());
+    QVERIFY(index.matching(QString()).isEmpty());
+}
+
+void SearchIndexTest::followsRepositoryChanges()
+{
+    InMemoryEventRepository storedEvents;
+    InMemoryTodoRepository storedTodos;
+    RecurringEventRepository recurring(storedEvents);
+    ObservableEventRepository events(recurring);
+    ObservableTodoRepository todos(storedTodos);
+
+    CalendarEvent meeting;
+    meeting.title = QStringLiteral("Teambesprechung");
+    meeting.location = QStringLiteral("Raum 3");
+    meeting.start = QDateTime(QDate(2024, 3, 4), QTime(9, 0));
+    meeting.end = meeting.start.addSecs(3600);
+    meeting = events.addEvent(meeting);
+    TodoItem todo;
+    todo.title = QStringLiteral("Protokoll schreiben");
+    todo = todos.addTodo(todo);
+
+    CalendarSearch search(storedEvents, storedTodos, events, todos);
+    QVERIFY(!search.isIndexed());
+    // The first search starts building the index and compares the texts until it is ready.
+    const EventMatches pending = search.matchingEvents(QStringLiteral("raum"));
+    QVERIFY(pending.contains(meeting));
+    QVERIFY(search.matchingTodos(QStringLiteral("PROTOKOLL")).contains(todo));
+    QVERIFY(!search.matchingTodos(QStringLiteral("kantine")).contains(todo));
+    // Changes made meanwhile are applied once the index is installed.
+    TodoItem early;
+    early.title = QStringLiteral("Protokoll lesen");
+    early = todos.addTodo(early);
+    QTRY_VERIFY(search.isIndexed());
+    QCOMPARE(search.matchingEvents(QStringLiteral("raum")).ids, QSet<QUuid>({meeting.id}));
+    QCOMPARE(search.matchingTodos(QStringLiteral("protokoll")).ids, QSet<QUuid>({todo.id, early.id}));
+    QVERIFY(todos.removeTodo(early.id));
+
+    meeting.location = QStringLiteral("Kantine");
+    QVERIFY(events.updateEvent(meeting));
+    QVERIFY(search.matchingEvents(QStringLiteral("raum")).ids.isEmpty());
+    QCOMPARE(search.matchingEvents(QStringLiteral("kantine")).ids, QSet<QUuid>({meeting.id}));
+
+    TodoItem another;
+    another.description = QStringLiteral("Protokoll verschicken");
+    another = todos.addTodo(another);
+    QCOMPARE(search.matchingTodos(QStringLiteral("protokoll")).ids, QSet<QUuid>({todo.id, another.id}));
+    QVERIFY(todos.removeTodo(todo.id));
+    QCOMPARE(search.matchingTodos(QStringLiteral("protokoll")).ids, QSet<QUuid>({another.id}));
+
+    QVERIFY(events.removeEvent(meeting.id));
+    QVERIFY(search.matchingEvents(QStringLiteral("kantine")).ids.isEmpty());
+}
+
+void SearchIndexTest::matchesOccurrencesThroughSeries()
+{
+    InMemoryEventRepository storedEvents;
+    InMemoryTodoRepository storedTodos;
+    RecurringEventRepository recurring(storedEvents);
+    ObservableEventRepository events(recurring);
+    ObservableTodoRepository todos(storedTodos);
+    CalendarSearch search(storedEvents, storedTodos, events, todos);
+
+    CalendarEvent master;
+    master.title = QStringLiteral("Yoga");
+    master.start = QDateTime(QDate(2024, 1, 1), QTime(18, 0));
+    master.end = master.start.addSecs(3600);
+    master.recurrenceRule = QStringLiteral("FREQ=DAILY;COUNT=5");
+    master = events.addEvent(master);
+
+    const std::vector<CalendarEvent> week = events.fetchEvents(QDate(2024, 1, 1), QDate(2024, 1, 7));
+    QCOMPARE(week.size(), size_t(5));
+    search.matchingEvents(QStringLiteral("yoga"));
+    QTRY_VERIFY(search.isIndexed());
+    QCOMPARE(search.matchingEvents(QStringLiteral("yoga")).ids, QSet<QUuid>({master.id}));
+    // Turn the third occurrence into an override with a text of its own.
+    CalendarEvent changed = week.at(2);
+    changed.title = QStringLiteral("Pilates");
+    QVERIFY(events.updateEvent(changed));
+
+    const EventMatches yoga = search.matchingEvents(QStringLiteral("yoga"));
+    const EventMatches pilates = search.matchingEvents(QStringLiteral("pilates"));
+    int yogaCount = 0;
+    for (const CalendarEvent &event : events.fetchEvents(QDate(2024, 1, 1), QDate(2024, 1, 7))) {
+        const bool isOverride = event.id == changed.id;
+        QCOMPARE(yoga.contains(event), !isOverride);
+        QCOMPARE(pilates.contains(event), isOverride);
+        yogaCount += yoga.contains(event) ? 1 : 0;
+    }
+    QCOMPARE(yogaCount, 4);
+
+    QVERIFY(events.removeEvent(master.id));
+    QVERIFY(search.matchingEvents(QStringLiteral("pilates")).ids.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(SearchIndexTest)
+#include "SearchIndexTest.moc"
@@ -0,0 +1,277 @@
+#include <QtTest/QtTest>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <algorithm>
+#include <memory>
+
+#include "calendar/data/IcsExchange.hpp"
+#include "calendar/data/InMemoryEventRepository.hpp"
+#include "calendar/data/InMemoryTodoRepository.hpp"
+#include "calendar/data/RepositoryBatch.hpp"
+#include "calendar/data/SqliteDatabase.hpp"
+#include "calendar/data/SqliteEventRepository.hpp"
+#include "calendar/data/SqliteTodoRepository.hpp"
+
+using namespace calendar::data;
+
+class SqliteRepositoryTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void migratesSchema();
+    void eventRoundTrip();
+    void todoRoundTrip();
+    void rangeQueryMatchesScan();
+    void batchIsOneTransaction();
+    void icsExchange();
+};
+
+void SqliteRepositoryTest::initTestCase()
+{
+    if (!QSqlDatabase::isDriverAvailable(QStringLiteral("QSQLITE"))) {
+        QSKIP("QSQLITE driver not available");
+    }
+}
+
+void SqliteRepositoryTest::migratesSchema()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.sqlite"));
+    {
+        SqliteDatabase database(path);
+        QVERIFY2(database.isOpen(), qPrintable(database.lastError()));
+        QCOMPARE(database.schemaVersion(), SqliteDatabase::latestSchemaVersion());
+    }
+    // Reopening an up-to-date database must not run any migration again.
+    SqliteDatabase reopened(path);
+    QVERIFY2(reopened.isOpen(), qPrintable(reopened.lastError()));
+    QCOMPARE(reopened.schemaVersion(), SqliteDatabase::latestSchemaVersion());
+}
+
+void SqliteRepositoryTest::eventRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.sqlite"));
+
+    CalendarEvent event;
+    event.title = QStringLiteral("Review");
+    event.description = QStringLiteral("Line 1\nLine 2");
+    event.location = QStringLiteral("Linz");
+    event.start = QDateTime(QDate(2024, 3, 4), QTime(9, 0));
+    event.end = event.start.addSecs(3600);
+    event.categories = {QStringLiteral("Work"), QStringLiteral("Team")};
+    event.reminderMinutes = 15;
+    {
+        auto database = std::make_shared<SqliteDatabase>(path);
+        QVERIFY(database->isOpen());
+        SqliteEventRepository repo(database);
+        repo.addEvent(event);
+    }
+
+    auto database = std::make_shared<SqliteDatabase>(path);
+    SqliteEventRepository repo(database);
+    auto stored = repo.findById(event.id);
+    QVERIFY(stored.has_value());
+    QCOMPARE(stored->title, event.title);
+    QCOMPARE(stored->description, event.description);
+    QCOMPARE(stored->location, event.location);
+    QCOMPARE(stored->start, event.start);
+    QCOMPARE(stored->end, event.end);
+    QCOMPARE(stored->categories, event.categories);
+    QCOMPARE(stored->reminderMinutes, 15);
+
+    stored->title = QStringLiteral("Retro");
+    QVERIFY(repo.updateEvent(*stored));
+    QCOMPARE(repo.findById(event.id)->title, QStringLiteral("Retro"));
+    // The worker reads through a connection of its own.
+    QFuture<EventSnapshot> all = repo.fetchAllEventsAsync(CancellationToken());
+    all.waitForFinished();
+    QCOMPARE(all.result().size(), size_t(1));
+    QCOMPARE(all.result().front().title, QStringLiteral("Retro"));
+
+    CalendarEvent unknown;
+    QVERIFY(!repo.updateEvent(unknown));
+    QVERIFY(repo.removeEvent(event.id));
+    QVERIFY(!repo.removeEvent(event.id));
+    QVERIFY(!repo.findById(event.id).has_value());
+}
+
+void SqliteRepositoryTest::todoRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto database = std::make_shared<SqliteDatabase>(dir.filePath(QStringLiteral("calendar.sqlite")));
+    QVERIFY(database->isOpen());
+    SqliteTodoRepository repo(database);
+
+    TodoItem low;
+    low.title = QStringLiteral("b low");
+    low.priority = 1;
+    low.tags = {QStringLiteral("home")};
+    low.dueDate = QDateTime(QDate(2024, 5, 1), QTime(12, 0));
+    low.status = TodoStatus::InProgress;
+    low.durationMinutes = 45;
+    TodoItem high;
+    high.title = QStringLiteral("A high");
+    high.priority = 5;
+    TodoItem tie;
+    tie.title = QStringLiteral("a tie");
+    tie.priority = 1;
+    repo.addTodo(low);
+    repo.addTodo(high);
+    repo.addTodo(tie);
+
+    const auto todos = repo.fetchTodos();
+    QCOMPARE(todos.size(), size_t(3));
+    QCOMPARE(todos[0].id, high.id);
+    QCOMPARE(todos[1].id, tie.id);
+    QCOMPARE(todos[2].id, low.id);
+    QCOMPARE(todos[2].tags, low.tags);
+    QCOMPARE(todos[2].dueDate, low.dueDate);
+    QCOMPARE(todos[2].status, TodoStatus::InProgress);
+    QCOMPARE(todos[2].durationMinutes, 45);
+    QVERIFY(!todos[0].dueDate.isValid());
+
+    TodoItem done = tie;
+    done.status = TodoStatus::Completed;
+    QVERIFY(repo.updateTodo(done));
+    QCOMPARE(repo.findById(tie.id)->status, TodoStatus::Completed);
+    QVERIFY(repo.removeTodo(tie.id));
+    QCOMPARE(repo.fetchTodos().size(), size_t(2));
+    QFuture<std::vector<TodoItem>> async = repo.fetchTodosAsync(CancellationToken());
+    async.waitForFinished();
+    QCOMPARE(async.result().size(), size_t(2));
+    QCOMPARE(async.result().front().id, high.id);
+}
+
+void SqliteRepositoryTest::rangeQueryMatchesScan()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto database = std::make_shared<SqliteDatabase>(dir.filePath(QStringLiteral("calendar.sqlite")));
+    QVERIFY(database->isOpen());
+    SqliteEventRepository repo(database);
+
+    QRandomGenerator random(7);
+    const QDateTime origin(QDate(2024, 1, 1), QTime(0, 0));
+    std::vector<CalendarEvent> events;
+    {
+        RepositoryBatch batch(repo);
+        for (int i = 0; i < 500; ++i) {
+            CalendarEvent event;
+            event.title = QStringLiteral("Event %1").arg(i);
+            event.start = origin.addSecs(random.bounded(60 * 24) * 15 * 60);
+            // Every tenth event spans several weeks and has to be found through the long-event index.
+            event.end = event.start.addSecs((1 + random.bounded(i % 10 == 0 ? 4000 : 12)) * 15 * 60);
+            events.push_back(repo.addEvent(event));
+        }
+    }
+
+    for (int day = -40; day < 64; day += 3) {
+        const QDate from = origin.date().addDays(day);
+        const QDate to = from.addDays(random.bounded(8));
+        std::vector<CalendarEvent> expected;
+        for (const auto &event : events) {
+            if (event.end.date() < from || event.start.date() > to) {
+                continue;
+            }
+            expected.push_back(event);
+        }
+        std::sort(expected.begin(), expected.end(), [](const CalendarEvent &lhs, const CalendarEvent &rhs) {
+            if (lhs.start == rhs.start) {
+                return lhs.end < rhs.end;
+            }
+            return lhs.start < rhs.start;
+        });
+
+        const auto actual = repo.fetchEvents(from, to);
+        QCOMPARE(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            QCOMPARE(actual[i].start, expected[i].start);
+            QCOMPARE(actual[i].end, expected[i].end);
+        }
+    }
+}
+
+void SqliteRepositoryTest::batchIsOneTransaction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.sqlite"));
+    auto database = std::make_shared<SqliteDatabase>(path);
+    QVERIFY(database->isOpen());
+    SqliteEventRepository events(database);
+    SqliteTodoRepository todos(database);
+
+    CalendarEvent event;
+    event.start = QDateTime(QDate(2024, 3, 4), QTime(9, 0));
+    event.end = event.start.addSecs(3600);
+    {
+        RepositoryBatch batch(events, todos);
+        events.addEvent(event);
+        todos.addTodo(TodoItem{});
+    }
+    // Committed data is visible to a second connection.
+    auto reader = std::make_shared<SqliteDatabase>(path);
+    QVERIFY(SqliteEventRepository(reader).findById(event.id).has_value());
+    QCOMPARE(SqliteTodoRepository(reader).fetchTodos().size(), size_t(1));
+}
+
+void SqliteRepositoryTest::icsExchange()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString icsPath = dir.filePath(QStringLiteral("calendar.ics"));
+
+    InMemoryEventRepository sourceEvents;
+    InMemoryTodoRepository sourceTodos;
+    for (int i = 0; i < 20; ++i) {
+        CalendarEvent event;
+        event.title = QStringLiteral("Event, %1; with \\ escapes").arg(i);
+        event.start = QDateTime(QDate(2024, 6, 1 + i), QTime(8, 30));
+        event.end = event.start.addSecs(5400);
+        sourceEvents.addEvent(event);
+        TodoItem todo;
+        todo.title = QStringLiteral("Todo %1").arg(i);
+        todo.priority = i % 4;
+        sourceTodos.addTodo(todo);
+    }
+    QString errorString;
+    QVERIFY2(IcsExchange::exportFile(icsPath, sourceEvents, sourceTodos, &errorString),
+             qPrintable(errorString));
+
+    auto database = std::make_shared<SqliteDatabase>(dir.filePath(QStringLiteral("calendar.sqlite")));
+    QVERIFY(database->isOpen());
+    SqliteEventRepository events(database);
+    SqliteTodoRepository todos(database);
+    QCOMPARE(IcsExchange::importFile(icsPath, events, todos), 40);
+
+    auto expected = sourceEvents.fetchEvents(QDate(2024, 1, 1), QDate(2024, 12, 31));
+    std::sort(expected.begin(), expected.end(), [](const CalendarEvent &lhs, const CalendarEvent &rhs) {
+        return lhs.start < rhs.start;
+    });
+    const auto actual = events.fetchEvents(QDate(2024, 1, 1), QDate(2024, 12, 31));
+    QCOMPARE(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        QCOMPARE(actual[i].id, expected[i].id);
+        QCOMPARE(actual[i].title, expected[i].title);
+        QCOMPARE(actual[i].start, expected[i].start);
+        QCOMPARE(actual[i].end, expected[i].end);
+    }
+    QCOMPARE(todos.fetchTodos().size(), sourceTodos.fetchTodos().size());
+
+    // And back out again: the exported database reads like the original calendar.
+    const QString exportedPath = dir.filePath(QStringLiteral("exported.ics"));
+    QVERIFY(IcsExchange::exportFile(exportedPath, events, todos));
+    InMemoryEventRepository reimported;
+    InMemoryTodoRepository reimportedTodos;
+    QCOMPARE(IcsExchange::importFile(exportedPath, reimported, reimportedTodos), 40);
+    QCOMPARE(reimported.fetchEvents(QDate(2024, 1, 1), QDate(2024, 12, 31)).size(), expected.size());
+}
+
+QTEST_GUILESS_MAIN(SqliteRepositoryTest)
+#include "SqliteRepositoryTest.moc"
@@ -1,6 +1,8 @@
 #include <QtTest/QtTest>
 
 #include "calendar/data/InMemoryTodoRepository.hpp"
+#include "calendar/data/ObservableTodoRepository.hpp"
+#include "calendar/data/RepositoryBatch.hpp"
 
 using namespace calendar::data;
 
@@ -11,6 +13,7 @@ class TodoRepositoryTest : public QObject
 private slots:
     void addAndFetch();
     void updateAndRemove();
+    void changeSetsFoldBatches();
 };
 
 void TodoRepositoryTest::addAndFetch()
@@ -52,5 +55,50 @@ void TodoRepositoryTest::updateAndRemove()
     QVERIFY(!repo.findById(stored.id).has_value());
 }
 
+void TodoRepositoryTest::changeSetsFoldBatches()
+{
+    InMemoryTodoRepository backend;
+    TodoItem existing;
+    existing.title = "Existing";
+    existing = backend.addTodo(existing);
+
+    ObservableTodoRepository repo(backend);
+    std::vector<TodoChangeSet> received;
+    connect(&repo, &ObservableTodoRepository::todosChanged, [&received](const TodoChangeSet &changes) {
+        received.push_back(changes);
+    });
+
+    TodoItem renamed = existing;
+    renamed.title = "Renamed";
+    QVERIFY(repo.updateTodo(renamed));
+    QCOMPARE(received.size(), static_cast<size_t>(1));
+    QCOMPARE(received.back().updated.size(), static_cast<size_t>(1));
+    QCOMPARE(received.back().updated.front().before.title, QStringLiteral("Existing"));
+    QCOMPARE(received.back().updated.front().after.title, QStringLiteral("Renamed"));
+
+    {
+        RepositoryBatch batch(repo);
+        TodoItem temporary;
+        temporary = repo.addTodo(temporary);
+        QVERIFY(repo.removeTodo(temporary.id));
+        TodoItem kept;
+        kept.title = "Kept";
+        kept = repo.addTodo(kept);
+        kept.priority = 2;
+        QVERIFY(repo.updateTodo(kept));
+        QVERIFY(repo.removeTodo(existing.id));
+        QVERIFY(!repo.removeTodo(existing.id));
+        QCOMPARE(received.size(), static_cast<size_t>(1));
+    }
+    // One notification per batch with the net effect of all mutations.
+    QCOMPARE(received.size(), static_cast<size_t>(2));
+    const TodoChangeSet &batch = received.back();
+    QCOMPARE(batch.inserted.size(), static_cast<size_t>(1));
+    QCOMPARE(batch.inserted.front().priority, 2);
+    QVERIFY(batch.updated.empty());
+    QCOMPARE(batch.removed.size(), static_cast<size_t>(1));
+    QCOMPARE(batch.removed.front().title, QStringLiteral("Renamed"));
+}
+
 QTEST_MAIN(TodoRepositoryTest)
 #include "TodoRepositoryTest.moc"
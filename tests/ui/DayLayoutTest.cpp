@@ -0,0 +1,235 @@
+#include <QtTest/QtTest>
+
+#include "calendar/ui/widgets/DayLayout.hpp"
+
+#include <QRandomGenerator>
+#include <map>
+
+using namespace calendar::ui;
+
+class DayLayoutTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splitsIdenticalRanges();
+    void narrowsContainedSegments();
+    void matchesPairwiseLayout();
+};
+
+namespace {
+// The layout as CalendarView computed it before the sweep: every pair of segments of the
+// column is compared, in order.
+std::vector<EventLayout> pairwiseLayout(const std::vector<DaySpan> &spans)
+{
+    struct DayEntry
+    {
+        double startMinutes = 0.0;
+        double endMinutes = 0.0;
+        double width = 1.0;
+        double offset = 0.0;
+        EventLayout::Anchor anchor = EventLayout::Anchor::Left;
+        bool fromSplit = false;
+        bool isContained = false;
+    };
+
+    std::vector<DayEntry> entries;
+    for (const DaySpan &span : spans) {
+        DayEntry entry;
+        entry.startMinutes = span.startMinutes;
+        entry.endMinutes = span.endMinutes;
+        entries.push_back(entry);
+    }
+
+    constexpr double containWidth = 0.58;
+    constexpr double containerWidth = 0.88;
+    constexpr double overlapWidth = 0.72;
+    constexpr double epsilon = 0.01;
+
+    std::map<std::pair<int, int>, std::vector<int>> identical;
+    for (int idx = 0; idx < static_cast<int>(entries.size()); ++idx) {
+        const int startKey = qRound(entries[idx].startMinutes * 10.0);
+        const int endKey = qRound(entries[idx].endMinutes * 10.0);
+        identical[{ startKey, endKey }].push_back(idx);
+    }
+    for (auto &[_, indices] : identical) {
+        if (indices.size() <= 1) {
+            continue;
+        }
+        const int groupSize = static_cast<int>(indices.size());
+        const double width = qBound(0.25, 1.0 / static_cast<double>(groupSize), 0.5);
+        for (int position = 0; position < groupSize; ++position) {
+            auto &entry = entries[indices[position]];
+            entry.width = width;
+            entry.offset = width * position;
+            if (position == 0) {
+                entry.anchor = EventLayout::Anchor::Left;
+            } else if (position == groupSize - 1) {
+                entry.anchor = EventLayout::Anchor::Right;
+            } else {
+                entry.anchor = EventLayout::Anchor::Center;
+            }
+            entry.fromSplit = true;
+        }
+    }
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        for (std::size_t j = i + 1; j < entries.size(); ++j) {
+            auto &first = entries[i];
+            auto &second = entries[j];
+            bool sameRange = qAbs(first.startMinutes - second.startMinutes) < epsilon
+                && qAbs(first.endMinutes - second.endMinutes) < epsilon;
+            if (sameRange && first.fromSplit && second.fromSplit) {
+                continue;
+            }
+            bool firstContainsSecond = first.startMinutes <= second.startMinutes + epsilon
+                && first.endMinutes >= second.endMinutes - epsilon;
+            bool secondContainsFirst = second.startMinutes <= first.startMinutes + epsilon
+                && second.endMinutes >= first.endMinutes - epsilon;
+
+            if (firstContainsSecond && !secondContainsFirst) {
+                if (!first.fromSplit) {
+                    first.width = qMin(first.width, containerWidth);
+                    first.offset = 0.0;
+                    first.anchor = EventLayout::Anchor::Left;
+                }
+                second.width = qMin(second.width, containWidth);
+                second.offset = 1.0 - second.width;
+                second.anchor = EventLayout::Anchor::Right;
+                second.isContained = true;
+                continue;
+            }
+            if (secondContainsFirst && !firstContainsSecond) {
+                if (!second.fromSplit) {
+                    second.width = qMin(second.width, containerWidth);
+                    second.offset = 0.0;
+                    second.anchor = EventLayout::Anchor::Left;
+                }
+                first.width = qMin(first.width, containWidth);
+                first.offset = 1.0 - first.width;
+                first.anchor = EventLayout::Anchor::Right;
+                first.isContained = true;
+                continue;
+            }
+            const double overlapStart = qMax(first.startMinutes, second.startMinutes);
+            const double overlapEnd = qMin(first.endMinutes, second.endMinutes);
+            if (overlapEnd - overlapStart > epsilon) {
+                DayEntry *left = &first;
+                DayEntry *right = &second;
+                if (second.startMinutes < first.startMinutes
+                    || (qAbs(second.startMinutes - first.startMinutes) < epsilon
+                        && second.endMinutes < first.endMinutes)) {
+                    left = &second;
+                    right = &first;
+                }
+                if (!left->fromSplit && !left->isContained) {
+                    left->width = qMin(left->width, overlapWidth);
+                    left->offset = 0.0;
+                    left->anchor = EventLayout::Anchor::Left;
+                }
+                if (!right->fromSplit && !right->isContained) {
+                    right->width = qMin(right->width, overlapWidth);
+                    right->offset = 1.0 - right->width;
+                    right->anchor = EventLayout::Anchor::Right;
+                }
+            }
+        }
+    }
+
+    std::vector<EventLayout> result;
+    for (const auto &entry : entries) {
+        EventLayout layout;
+        layout.offsetFraction = entry.offset;
+        layout.widthFraction = entry.width;
+        layout.anchor = entry.anchor;
+        layout.zPriority = entry.isContained ? 1 : 0;
+        result.push_back(layout);
+    }
+    return result;
+}
+
+DaySpan span(double startMinutes, double endMinutes)
+{
+    DaySpan result;
+    result.startMinutes = startMinutes;
+    result.endMinutes = endMinutes;
+    return result;
+}
+
+// Minutes with a few seconds now and then, so that near-identical ranges come up as well.
+double randomMinutes(QRandomGenerator &random, int quarterHours)
+{
+    double minutes = 15.0 * random.bounded(quarterHours + 1);
+    if (random.bounded(6) == 0) {
+        minutes += random.bounded(1, 10) / 60.0;
+    }
+    return minutes;
+}
+} // namespace
+
+void DayLayoutTest::splitsIdenticalRanges()
+{
+    const auto layouts = layoutDayColumn({ span(600, 660), span(600, 660), span(600, 660) });
+    QCOMPARE(layouts.size(), size_t(3));
+    QCOMPARE(layouts[0].anchor, EventLayout::Anchor::Left);
+    QCOMPARE(layouts[1].anchor, EventLayout::Anchor::Center);
+    QCOMPARE(layouts[2].anchor, EventLayout::Anchor::Right);
+    QCOMPARE(layouts[1].offsetFraction, 1.0 / 3.0);
+    QCOMPARE(layouts[2].widthFraction, 1.0 / 3.0);
+}
+
+void DayLayoutTest::narrowsContainedSegments()
+{
+    const auto layouts = layoutDayColumn({ span(540, 720), span(600, 660), span(700, 780), span(900, 960) });
+    QCOMPARE(layouts[1].zPriority, 1);
+    QCOMPARE(layouts[1].anchor, EventLayout::Anchor::Right);
+    QCOMPARE(layouts[1].widthFraction, 0.58);
+    // The overlap with the third segment comes after the containment and decides the anchor.
+    QCOMPARE(layouts[0].anchor, EventLayout::Anchor::Left);
+    QCOMPARE(layouts[0].widthFraction, 0.72);
+    QCOMPARE(layouts[2].anchor, EventLayout::Anchor::Right);
+    QCOMPARE(layouts[2].offsetFraction, 1.0 - 0.72);
+    QCOMPARE(layouts[3].widthFraction, 1.0);
+    QCOMPARE(layouts[3].zPriority, 0);
+}
+
+void DayLayoutTest::matchesPairwiseLayout()
+{
+    QRandomGenerator random(20240612);
+    for (int round = 0; round < 2000; ++round) {
+        // Short days crowd the segments together, long ones spread them out.
+        const int quarterHours = random.bounded(4, 97);
+        const int count = random.bounded(1, 40);
+        std::vector<DaySpan> spans;
+        for (int i = 0; i < count; ++i) {
+            double start = randomMinutes(random, quarterHours);
+            double end = randomMinutes(random, quarterHours);
+            if (end < start) {
+                std::swap(start, end);
+            }
+            if (end == start) {
+                end = start + 15.0;
+            }
+            spans.push_back(span(start, end));
+        }
+        // Sometimes in the order CalendarView uses, sometimes in any order.
+        if (random.bounded(2) == 0) {
+            std::stable_sort(spans.begin(), spans.end(), [](const DaySpan &lhs, const DaySpan &rhs) {
+                return lhs.startMinutes < rhs.startMinutes;
+            });
+        }
+
+        const auto expected = pairwiseLayout(spans);
+        const auto actual = layoutDayColumn(spans);
+        QCOMPARE(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i) {
+            QCOMPARE(actual[i].offsetFraction, expected[i].offsetFraction);
+            QCOMPARE(actual[i].widthFraction, expected[i].widthFraction);
+            QCOMPARE(actual[i].anchor, expected[i].anchor);
+            QCOMPARE(actual[i].zPriority, expected[i].zPriority);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(DayLayoutTest)
+#include "DayLayoutTest.moc"
@@ -2,16 +2,48 @@
 
 #include "calendar/data/InMemoryEventRepository.hpp"
 #include "calendar/data/Event.hpp"
+#include "calendar/data/FileCalendarStorage.hpp"
+#include "calendar/data/FileEventRepository.hpp"
+#include "calendar/data/IcsWriter.hpp"
+#include "calendar/data/ObservableEventRepository.hpp"
+#include "calendar/data/RepositoryBatch.hpp"
 #include "calendar/ui/viewmodels/ScheduleViewModel.hpp"
 
 using namespace calendar;
 
+namespace {
+class CountingEventRepository : public data::InMemoryEventRepository
+{
+public:
+    std::vector<data::CalendarEvent> fetchEvents(const QDate &from, const QDate &to) const override
+    {
+        ++fetches;
+        return InMemoryEventRepository::fetchEvents(from, to);
+    }
+
+    mutable int fetches = 0;
+};
+
+data::CalendarEvent eventAt(const QString &title, const QDateTime &start)
+{
+    data::CalendarEvent event;
+    event.title = title;
+    event.start = start;
+    event.end = start.addSecs(3600);
+    return event;
+}
+} // namespace
+
 class ScheduleViewModelTest : public QObject
 {
     Q_OBJECT
 
 private slots:
     void loadsRange();
+    void appliesChangeSets();
+    void sharesSnapshots();
+    void dropsStaleQueries();
+    void servesNavigationFromCache();
 };
 
 void ScheduleViewModelTest::loadsRange()
@@ -30,5 +62,184 @@ void ScheduleViewModelTest::loadsRange()
     QCOMPARE(model.events().front().title, QStringLiteral("Meeting"));
 }
 
+void ScheduleViewModelTest::appliesChangeSets()
+{
+    data::InMemoryEventRepository backend;
+    data::ObservableEventRepository repo(backend);
+    ui::ScheduleViewModel model(repo);
+    QObject::connect(&repo,
+                     &data::ObservableEventRepository::eventsChanged,
+                     &model,
+                     &ui::ScheduleViewModel::applyChanges);
+    int emitted = 0;
+    QObject::connect(&model, &ui::ScheduleViewModel::eventsChanged, [&emitted]() { ++emitted; });
+    model.setRange(QDate(2023, 1, 2), QDate(2023, 1, 8));
+    model.refresh();
+    emitted = 0;
+
+    data::CalendarEvent late;
+    late.title = "Late";
+    late.start = QDateTime(QDate(2023, 1, 3), QTime(15, 0));
+    late.end = late.start.addSecs(3600);
+    data::CalendarEvent early = late;
+    early.id = QUuid::createUuid();
+    early.title = "Early";
+    early.start = QDateTime(QDate(2023, 1, 3), QTime(8, 0));
+    early.end = early.start.addSecs(3600);
+    {
+        data::RepositoryBatch batch(repo);
+        repo.addEvent(late);
+        repo.addEvent(early);
+    }
+    QCOMPARE(emitted, 1);
+    QCOMPARE(model.events().size(), static_cast<size_t>(2));
+    QCOMPARE(model.events().front().title, QStringLiteral("Early"));
+
+    // Moving the early event behind the late one reorders it; moving it out of range drops it.
+    early.start = QDateTime(QDate(2023, 1, 4), QTime(9, 0));
+    early.end = early.start.addSecs(3600);
+    QVERIFY(repo.updateEvent(early));
+    QCOMPARE(model.events().back().id, early.id);
+    early.start = QDateTime(QDate(2023, 2, 1), QTime(9, 0));
+    early.end = early.start.addSecs(3600);
+    QVERIFY(repo.updateEvent(early));
+    QCOMPARE(model.events().size(), static_cast<size_t>(1));
+    QCOMPARE(emitted, 3);
+
+    // Changes outside the visible range do not touch the view.
+    early.title = "Still outside";
+    QVERIFY(repo.updateEvent(early));
+    QCOMPARE(emitted, 3);
+
+    QVERIFY(repo.removeEvent(late.id));
+    QVERIFY(model.events().empty());
+    QCOMPARE(emitted, 4);
+}
+
+void ScheduleViewModelTest::sharesSnapshots()
+{
+    auto storage = std::make_shared<data::FileCalendarStorage>(QString{});
+    data::FileEventRepository backend(storage);
+    data::ObservableEventRepository repo(backend);
+    ui::ScheduleViewModel model(repo);
+    QObject::connect(&repo,
+                     &data::ObservableEventRepository::eventsChanged,
+                     &model,
+                     &ui::ScheduleViewModel::applyChanges);
+
+    data::CalendarEvent standup;
+    standup.title = "Standup";
+    standup.start = QDateTime(QDate(2023, 1, 3), QTime(9, 0));
+    standup.end = standup.start.addSecs(900);
+    standup = repo.addEvent(standup);
+    data::CalendarEvent review = standup;
+    review.id = QUuid::createUuid();
+    review.title = "Review";
+    review.start = QDateTime(QDate(2023, 1, 4), QTime(14, 0));
+    review.end = review.start.addSecs(3600);
+    review = repo.addEvent(review);
+
+    model.setRange(QDate(2023, 1, 2), QDate(2023, 1, 8));
+    model.refresh();
+    const data::EventSnapshot loaded = model.events();
+    QCOMPARE(loaded.size(), static_cast<size_t>(2));
+    // The view model holds the very events the storage keeps in memory.
+    const data::EventSnapshot stored = storage->eventSnapshot(QDate(2023, 1, 2), QDate(2023, 1, 8));
+    QCOMPARE(loaded.handles().at(0).get(), stored.handles().at(0).get());
+    QCOMPARE(loaded.handles().at(1).get(), stored.handles().at(1).get());
+
+    review.title = "Review (verschoben)";
+    QVERIFY(repo.updateEvent(review));
+    const data::EventSnapshot patched = model.events();
+    QCOMPARE(patched.back().title, QStringLiteral("Review (verschoben)"));
+    QCOMPARE(patched.handles().front().get(), loaded.handles().front().get());
+    // Snapshots handed out before never change.
+    QCOMPARE(loaded.back().title, QStringLiteral("Review"));
+}
+
+void ScheduleViewModelTest::dropsStaleQueries()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("calendar.ics"));
+    data::CalendarSnapshot contents;
+    for (int day = 0; day < 60; ++day) {
+        auto event = std::make_shared<data::CalendarEvent>();
+        event->title = QStringLiteral("Termin %1").arg(day);
+        event->start = QDateTime(QDate(2023, 1, 2).addDays(day), QTime(9, 0));
+        event->end = event->start.addSecs(3600);
+        contents.events.insert(event->id, event);
+    }
+    QVERIFY(data::IcsWriter::writeCalendar(path, contents));
+
+    // Events of a freshly loaded file are parsed on a worker thread.
+    auto storage = std::make_shared<data::FileCalendarStorage>(path);
+    data::FileEventRepository repo(storage);
+    ui::ScheduleViewModel model(repo);
+    std::vector<data::EventSnapshot> received;
+    QObject::connect(&model,
+                     &ui::ScheduleViewModel::eventsChanged,
+                     [&received](const data::EventSnapshot &events) { received.push_back(events); });
+
+    model.setRange(QDate(2023, 1, 2), QDate(2023, 1, 8));
+    model.refresh();
+    model.setRange(QDate(2023, 2, 6), QDate(2023, 2, 12));
+    model.refresh();
+    QTRY_VERIFY(!model.isLoading());
+    QTest::qWait(50);
+
+    QVERIFY(!received.empty());
+    QCOMPARE(received.back().size(), static_cast<size_t>(7));
+    QCOMPARE(received.back().front().start.date(), QDate(2023, 2, 6));
+    QCOMPARE(model.events().front().start.date(), QDate(2023, 2, 6));
+    // The January query either finished before it was overtaken or was dropped.
+    QVERIFY(received.size() <= 2);
+}
+
+void ScheduleViewModelTest::servesNavigationFromCache()
+{
+    CountingEventRepository backend;
+    backend.addEvent(eventAt(QStringLiteral("Planung"), QDateTime(QDate(2023, 1, 3), QTime(9, 0))));
+    backend.addEvent(eventAt(QStringLiteral("Review"), QDateTime(QDate(2023, 1, 10), QTime(14, 0))));
+    data::ObservableEventRepository repo(backend);
+    ui::ScheduleViewModel model(repo);
+    QObject::connect(&repo,
+                     &data::ObservableEventRepository::eventsChanged,
+                     &model,
+                     &ui::ScheduleViewModel::applyChanges);
+
+    model.setRange(QDate(2023, 1, 2), QDate(2023, 1, 9));
+    model.refresh();
+    QCOMPARE(backend.fetches, 1);
+    // Both neighbouring weeks are prefetched in the background.
+    QTRY_COMPARE(model.cachedRangeCount(), 2);
+    QCOMPARE(backend.fetches, 2);
+
+    model.setRange(QDate(2023, 1, 9), QDate(2023, 1, 16));
+    model.refresh();
+    QCOMPARE(backend.fetches, 2);
+    QCOMPARE(model.events().size(), static_cast<size_t>(1));
+    QCOMPARE(model.events().front().title, QStringLiteral("Review"));
+    // Moving forward prefetches the following week.
+    QTRY_COMPARE(backend.fetches, 3);
+
+    model.setRange(QDate(2023, 1, 2), QDate(2023, 1, 9));
+    model.refresh();
+    QCOMPARE(model.events().size(), static_cast<size_t>(1));
+    QCOMPARE(model.events().front().title, QStringLiteral("Planung"));
+
+    // Changes reach the cached weeks as well.
+    repo.addEvent(eventAt(QStringLiteral("Retro"), QDateTime(QDate(2023, 1, 11), QTime(11, 0))));
+    model.setRange(QDate(2023, 1, 9), QDate(2023, 1, 16));
+    model.refresh();
+    QCOMPARE(model.events().size(), static_cast<size_t>(2));
+    QCOMPARE(model.events().back().title, QStringLiteral("Retro"));
+    QCOMPARE(backend.fetches, 3);
+
+    model.clearCache();
+    model.refresh();
+    QCOMPARE(backend.fetches, 4);
+}
+
 QTEST_GUILESS_MAIN(ScheduleViewModelTest)
 #include "ScheduleViewModelTest.moc"
@@ -1,6 +1,8 @@
 #include <QtTest/QtTest>
 
+#include "calendar/data/InMemoryTodoRepository.hpp"
 #include "calendar/ui/models/TodoListModel.hpp"
+#include "calendar/ui/viewmodels/TodoListViewModel.hpp"
 
 using namespace calendar;
 
@@ -11,6 +13,7 @@ class TodoListModelTest : public QObject
 private slots:
     void setTodosAndData();
     void mimeDataContainsIds();
+    void viewModelPatchesRows();
 };
 
 void TodoListModelTest::setTodosAndData()
@@ -43,5 +46,50 @@ void TodoListModelTest::mimeDataContainsIds()
     QVERIFY(mime->hasFormat(QStringLiteral("application/x-calendar-todo")));
 }
 
+void TodoListModelTest::viewModelPatchesRows()
+{
+    data::InMemoryTodoRepository repo;
+    ui::TodoListViewModel viewModel(repo);
+    auto *model = viewModel.model();
+
+    data::TodoItem low;
+    low.title = "Low";
+    low.priority = 1;
+    data::TodoItem high;
+    high.title = "High";
+    high.priority = 5;
+    data::TodoChangeSet inserted;
+    inserted.inserted = {low, high};
+    viewModel.applyChanges(inserted);
+    QCOMPARE(model->rowCount(), 2);
+    QCOMPARE(model->todos().at(0).id, high.id);
+
+    int resets = 0;
+    int changedRows = 0;
+    connect(model, &QAbstractItemModel::modelReset, [&resets]() { ++resets; });
+    connect(model, &QAbstractItemModel::dataChanged, [&changedRows]() { ++changedRows; });
+
+    // A status change keeps the row; a priority change moves it.
+    data::TodoItem started = low;
+    started.status = data::TodoStatus::InProgress;
+    data::TodoChangeSet update;
+    update.updated.push_back({low, started});
+    viewModel.applyChanges(update);
+    QCOMPARE(changedRows, 1);
+    QCOMPARE(model->todos().at(1).status, data::TodoStatus::InProgress);
+
+    data::TodoItem urgent = started;
+    urgent.priority = 9;
+    update.updated = {{started, urgent}};
+    viewModel.applyChanges(update);
+    QCOMPARE(model->todos().at(0).id, low.id);
+
+    data::TodoChangeSet removal;
+    removal.removed = {high};
+    viewModel.applyChanges(removal);
+    QCOMPARE(model->rowCount(), 1);
+    QCOMPARE(resets, 0);
+}
+
 QTEST_GUILESS_MAIN(TodoListModelTest)
 #include "TodoListModelTest.moc"